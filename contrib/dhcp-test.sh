@@ -0,0 +1,79 @@
+#!/bin/bash
+# This file is part of Firejail project
+# Copyright (C) 2014-2024 Firejail Authors
+# License GPL v2
+
+# Test --ip=dhcp and --ip6=dhcp against a local dnsmasq server. The script
+# creates a bridge with a private IPv4/IPv6 network, starts dnsmasq on it and
+# runs a sandbox connected to the bridge. Run it as root; everything is
+# removed on exit.
+#
+# Usage: dhcp-test.sh [-n runs] [-4|-6] [firejail options]
+# Example: dhcp-test.sh -n 20 -6 --noprofile
+
+BRIDGE=fjdhcp0
+RUNS=1
+if [ "$1" = "-n" ]; then
+	RUNS="$2"
+	shift 2
+fi
+DHCP="--ip=dhcp --ip6=dhcp"
+if [ "$1" = "-4" ]; then
+	DHCP="--ip=dhcp"
+	shift
+elif [ "$1" = "-6" ]; then
+	DHCP="--ip6=dhcp"
+	shift
+fi
+
+if ! command -v dnsmasq >/dev/null; then
+	echo "Error: dnsmasq not found"
+	exit 1
+fi
+
+PIDFILE="$(mktemp)"
+cleanup() {
+	[ -s "$PIDFILE" ] && kill "$(cat "$PIDFILE")"
+	rm -f "$PIDFILE"
+	ip link del "$BRIDGE" 2>/dev/null
+}
+trap cleanup EXIT
+
+ip link add "$BRIDGE" type bridge || exit 1
+ip addr add 10.250.0.1/24 dev "$BRIDGE"
+ip addr add fd00:250::1/64 dev "$BRIDGE" nodad
+ip link set "$BRIDGE" up
+
+dnsmasq --pid-file="$PIDFILE" --interface="$BRIDGE" --bind-interfaces \
+	--port=0 --dhcp-authoritative --enable-ra \
+	--dhcp-range=10.250.0.100,10.250.0.200,2m \
+	--dhcp-range=fd00:250::100,fd00:250::200,64,2m \
+	--dhcp-option=option:dns-server,10.250.0.1 \
+	--dhcp-option=option6:dns-server,[fd00:250::1] \
+	--domain=fjdhcp.test || exit 1
+
+min=""
+max=0
+total=0
+for _ in $(seq 1 "$RUNS"); do
+	start="$(date +%s%N)"
+	# shellcheck disable=SC2086
+	if ! firejail --quiet --net="$BRIDGE" $DHCP "$@" -- sh -c 'ip addr show; cat /etc/resolv.conf' >/dev/null; then
+		echo "Error: sandbox failed"
+		exit 1
+	fi
+	end="$(date +%s%N)"
+	usec=$(( (end - start) / 1000 ))
+	total=$(( total + usec ))
+	[ "$usec" -gt "$max" ] && max="$usec"
+	if [ -z "$min" ] || [ "$usec" -lt "$min" ]; then
+		min="$usec"
+	fi
+done
+
+# last run with the output visible
+# shellcheck disable=SC2086
+firejail --quiet --net="$BRIDGE" $DHCP "$@" -- sh -c 'ip addr show; ip route; cat /etc/resolv.conf'
+
+echo "runs: $RUNS"
+echo "startup min: $(( min / 1000 )) ms, avg: $(( total / RUNS / 1000 )) ms, max: $(( max / 1000 )) ms"
@@ -0,0 +1,37 @@
+#!/bin/bash
+# This file is part of Firejail project
+# Copyright (C) 2014-2024 Firejail Authors
+# License GPL v2
+
+# Measure the time between the exit of the sandboxed program and the return
+# of the firejail process, i.e. the latency added by the sandbox teardown.
+#
+# Usage: exit-latency.sh [-n runs] [firejail options]
+# Example: exit-latency.sh -n 50 --noprofile --dbus-user=filter
+
+RUNS=20
+if [ "$1" = "-n" ]; then
+	RUNS="$2"
+	shift 2
+fi
+
+STAMP="$(mktemp)"
+trap 'rm -f "$STAMP"' EXIT
+
+min=""
+max=0
+total=0
+for _ in $(seq 1 "$RUNS"); do
+	firejail --quiet "$@" sh -c "date +%s%N > $STAMP"
+	end="$(date +%s%N)"
+	start="$(cat "$STAMP")"
+	usec=$(( (end - start) / 1000 ))
+	total=$(( total + usec ))
+	[ "$usec" -gt "$max" ] && max="$usec"
+	if [ -z "$min" ] || [ "$usec" -lt "$min" ]; then
+		min="$usec"
+	fi
+done
+
+echo "exit-to-return latency over $RUNS runs (microseconds):"
+echo "   min $min, avg $(( total / RUNS )), max $max"
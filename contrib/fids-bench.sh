@@ -0,0 +1,62 @@
+#!/bin/bash
+# This file is part of Firejail project
+# Copyright (C) 2014-2024 Firejail Authors
+# License GPL v2
+
+# Measure the fids scan time on a synthetic tree with a long exclude list.
+# A tree of dirs x files empty files is created in a temporary directory and
+# scanned by "fids --init" after the exclude entries. Half of the exclude
+# entries are next to the tree directories and half inside them, none of them
+# match a file. /etc/firejail/ids.config.local is replaced while the test runs,
+# the files listed in /etc/firejail/ids.config are scanned as well. Run it as root.
+#
+# Usage: fids-bench.sh [-d dirs] [-f files] [-e excludes] [fids]
+# Example: fids-bench.sh -d 1000 -f 1000 -e 200 /usr/lib/firejail/fids
+
+DIRS=1000
+FILES=1000
+EXCLUDES=200
+while true; do
+	case "$1" in
+	-d) DIRS="$2"; shift 2 ;;
+	-f) FILES="$2"; shift 2 ;;
+	-e) EXCLUDES="$2"; shift 2 ;;
+	*) break ;;
+	esac
+done
+FIDS="${1:-/usr/lib/firejail/fids}"
+LOCAL=/etc/firejail/ids.config.local
+
+TREE="$(mktemp -d)"
+if [ -f "$LOCAL" ]; then
+	cp -a "$LOCAL" "$TREE.local"
+fi
+cleanup() {
+	rm -f "$LOCAL"
+	if [ -f "$TREE.local" ]; then
+		mv "$TREE.local" "$LOCAL"
+	fi
+	rm -rf "$TREE"
+}
+trap cleanup EXIT
+
+echo "building $DIRS x $FILES files in $TREE"
+for d in $(seq 1 "$DIRS"); do
+	mkdir "$TREE/d$d"
+	(cd "$TREE/d$d" && seq -f "f%g" 1 "$FILES" | xargs touch)
+done
+
+mkdir -p /etc/firejail
+for e in $(seq 1 "$EXCLUDES"); do
+	if [ $((e % 2)) -eq 0 ]; then
+		echo "!$TREE/x$e"
+	else
+		echo "!$TREE/d$e/x"
+	fi
+done > "$LOCAL"
+echo "$TREE" >> "$LOCAL"
+
+start="$(date +%s%N)"
+"$FIDS" --init "$HOME" 2>&1 >/dev/null | grep "files scanned"
+end="$(date +%s%N)"
+echo "scan time: $(( (end - start) / 1000000 )) ms"
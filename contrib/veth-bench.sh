@@ -0,0 +1,83 @@
+#!/bin/bash
+# This file is part of Firejail project
+# Copyright (C) 2014-2024 Firejail Authors
+# License GPL v2
+
+# Measure the TCP throughput between two sandboxes connected to the same bridge.
+# The server and the client run in separate sandboxes; the options are passed
+# to both of them. iperf3 is used if installed, otherwise a python3 sender and
+# receiver are started. Run it as root; the bridge is removed on exit.
+#
+# Usage: veth-bench.sh [-t seconds] [-P streams] [firejail options]
+# Example: veth-bench.sh -P 8 --veth-queues=auto
+#          veth-bench.sh -P 8 --mtu=9000 --veth-queues=8
+
+BRIDGE=fjbench0
+TIME=10
+STREAMS=4
+while true; do
+	case "$1" in
+	-t) TIME="$2"; shift 2 ;;
+	-P) STREAMS="$2"; shift 2 ;;
+	*) break ;;
+	esac
+done
+
+cleanup() {
+	[ -n "$SERVER" ] && kill "$SERVER" 2>/dev/null
+	wait 2>/dev/null
+	ip link del "$BRIDGE" 2>/dev/null
+}
+trap cleanup EXIT
+
+ip link add "$BRIDGE" type bridge || exit 1
+ip link set "$BRIDGE" mtu 9000
+ip addr add 10.251.0.1/24 dev "$BRIDGE"
+ip link set "$BRIDGE" up
+
+# python3 fallback: the receiver counts the bytes on all connections,
+# the sender writes for $TIME seconds on $STREAMS connections
+PYSERVER='
+import socket, threading
+def sink(c):
+	while c.recv(1 << 20):
+		pass
+s = socket.socket()
+s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+s.bind(("0.0.0.0", 5201))
+s.listen(64)
+while True:
+	c, _ = s.accept()
+	threading.Thread(target=sink, args=(c,), daemon=True).start()
+'
+PYCLIENT='
+import socket, sys, threading, time
+t, n = float(sys.argv[1]), int(sys.argv[2])
+total = [0] * n
+buf = bytes(1 << 20)
+def run(i):
+	c = socket.create_connection(("10.251.0.10", 5201))
+	end = time.time() + t
+	while time.time() < end:
+		total[i] += c.send(buf)
+th = [threading.Thread(target=run, args=(i,)) for i in range(n)]
+for x in th:
+	x.start()
+for x in th:
+	x.join()
+print("%d streams: %.2f Gbit/s" % (n, sum(total) * 8 / t / 1e9))
+'
+
+if command -v iperf3 >/dev/null; then
+	firejail --quiet --noprofile --net="$BRIDGE" --ip=10.251.0.10 "$@" iperf3 -s -1 &
+	SERVER=$!
+	sleep 2
+	firejail --quiet --noprofile --net="$BRIDGE" --ip=10.251.0.11 "$@" \
+		iperf3 -c 10.251.0.10 -t "$TIME" -P "$STREAMS" | tail -4
+else
+	firejail --quiet --noprofile --net="$BRIDGE" --ip=10.251.0.10 "$@" python3 -c "$PYSERVER" &
+	SERVER=$!
+	sleep 2
+	firejail --quiet --noprofile --net="$BRIDGE" --ip=10.251.0.11 "$@" \
+		python3 -c "$PYCLIENT" "$TIME" "$STREAMS"
+fi
@@ -24,6 +24,7 @@
 
 #define MAX_BUF 4098
 #define MAX_ARR 1024
+#define HASH_SIZE 1024 // power of 2
 char *arr[MAX_ARR] = {NULL};
 int arr_cnt = 0;
 
@@ -35,6 +36,27 @@ static char *outptr;
 static int arg_replace = 0;
 static int arg_debug = 0;
 
+// what to do with a private-etc entry
+typedef enum {
+	ETC_ADD = 0,	// not part of any group, keep it in the list
+	ETC_DROP,	// already available in the sandbox
+	ETC_GAMES,	// replaced by @games
+	ETC_TLS_CA,	// replaced by @tls-ca
+	ETC_X11		// replaced by @x11
+} EtcClass;
+
+typedef struct hnode_t {
+	struct hnode_t *next;
+	const char *name;
+	EtcClass class;
+} HNode;
+
+// index of all the files in etc_groups.h, built once at startup
+static HNode *etc_index[HASH_SIZE] = {NULL};
+// entries already in arr[] for the current file
+static HNode *arr_index[HASH_SIZE] = {NULL};
+static HNode arr_nodes[MAX_ARR];
+
 void outprintf(char* fmt, ...) {
 	va_list args;
 	va_start(args,fmt);
@@ -42,35 +64,76 @@ void outprintf(char* fmt, ...) {
 	va_end(args);
 }
 
+static unsigned hash(const char *str) {
+	unsigned h = 5381;
+	int c;
+	while ((c = *str++) != 0)
+		h = ((h << 5) + h) ^ c; // hash * 33 ^ c
+	return h & (HASH_SIZE - 1);
+}
 
+static HNode *hash_find(HNode **table, const char *name) {
+	HNode *node = table[hash(name)];
+	while (node) {
+		if (strcmp(node->name, name) == 0)
+			return node;
+		node = node->next;
+	}
+	return NULL;
+}
 
-static int arr_check(const char *fname, char **pptr) {
-	assert(fname);
-	assert(pptr);
+static void index_add(const char *name, EtcClass class) {
+	// the first group a file is found in wins
+	if (hash_find(etc_index, name))
+		return;
+
+	HNode *node = malloc(sizeof(HNode));
+	if (!node)
+		errExit("malloc");
+	unsigned h = hash(name);
+	node->name = name;
+	node->class = class;
+	node->next = etc_index[h];
+	etc_index[h] = node;
+}
 
+static void index_add_list(char **pptr, EtcClass class) {
+	assert(pptr);
 	while (*pptr != NULL) {
-		if (strcmp(fname, *pptr) == 0)
-			return 1;
+		index_add(*pptr, class);
 		pptr++;
 	}
-
-	return 0;
 }
 
-
+// the order matches the precedence of the groups
+static void index_build(void) {
+	index_add_list(&etc_list[0], ETC_DROP);
+	index_add_list(&etc_group_sound[0], ETC_DROP);
+	index_add_list(&etc_group_network[0], ETC_DROP);
+	index_add("@games", ETC_GAMES);
+	index_add("@tls-ca", ETC_TLS_CA);
+	index_add("@x11", ETC_X11);
+	index_add_list(&etc_group_games[0], ETC_GAMES);
+	index_add_list(&etc_group_tls_ca[0], ETC_TLS_CA);
+	index_add_list(&etc_group_x11[0], ETC_X11);
+}
 
 static void arr_add(const char *fname) {
 	assert(fname);
 	assert(arr_cnt < MAX_ARR);
 
-	int i;
-	for (i = 0; i < arr_cnt; i++)
-		if (strcmp(arr[i], fname) == 0)
-			return;
+	if (hash_find(arr_index, fname))
+		return;
 
 	arr[arr_cnt] = strdup(fname);
 	if (!arr[arr_cnt])
 		errExit("strdup");
+
+	HNode *node = &arr_nodes[arr_cnt];
+	unsigned h = hash(fname);
+	node->name = arr[arr_cnt];
+	node->next = arr_index[h];
+	arr_index[h] = node;
 	arr_cnt++;
 }
 
@@ -91,6 +154,7 @@ static void arr_clean(void) {
 		free(arr[i]);
 		arr[i] = NULL;
 	}
+	memset(arr_index, 0, sizeof(arr_index));
 
 	arr_cnt = 0;
 	arr_games = 0;
@@ -168,23 +232,22 @@ static void process_file(const char *fname) {
 		while (ptr) {
 			if (arg_debug)
 				printf("%s\n", ptr);
-			if (arr_check(ptr, &etc_list[0]));
-			else if (arr_check(ptr, &etc_group_sound[0]));
-			else if (arr_check(ptr, &etc_group_network[0]));
-			else if (strcmp(ptr, "@games") == 0)
+			HNode *node = hash_find(etc_index, ptr);
+			switch (node ? node->class : ETC_ADD) {
+			case ETC_DROP:
+				break;
+			case ETC_GAMES:
 				arr_games = 1;
-			else if (strcmp(ptr, "@tls-ca") == 0)
+				break;
+			case ETC_TLS_CA:
 				arr_tls_ca = 1;
-			else if (strcmp(ptr, "@x11") == 0)
+				break;
+			case ETC_X11:
 				arr_x11 = 1;
-			else if (arr_check(ptr, &etc_group_games[0]))
-				arr_games = 1;
-			else if (arr_check(ptr, &etc_group_tls_ca[0]))
-				arr_tls_ca = 1;
-			else if (arr_check(ptr, &etc_group_x11[0]))
-				arr_x11 = 1;
-			else
+				break;
+			default:
 				arr_add(ptr);
+			}
 
 			ptr = strtok(NULL, ",");
 		}
@@ -251,6 +314,7 @@ int main(int argc, char **argv) {
 			break;
 	}
 
+	index_build();
 	for (; i < argc; i++)
 		process_file(argv[i]);
 
@@ -37,7 +37,7 @@ void build_profile(int argc, char **argv, int index, FILE *fp) {
 	close(tfile);
 
 	char *output;
-	if(asprintf(&output,"--trace=%s",trace_output) == -1)
+	if(asprintf(&output, (arg_trace_fanotify)? "--trace-fanotify=%s": "--trace=%s", trace_output) == -1)
 		errExit("asprintf");
 
 	// calculate command length
@@ -141,7 +141,11 @@ void build_profile(int argc, char **argv, int index, FILE *fp) {
 		fprintf(fp, "#notv\t# disable DVB TV devices\n");
 		fprintf(fp, "#nou2f\t# disable U2F devices\n");
 		fprintf(fp, "#novideo\t# disable video capture devices\n");
-		build_protocol(trace_output, fp);
+		// socket calls are not reported by fanotify
+		if (arg_trace_fanotify)
+			fprintf(fp, "#net none\t# network access was not traced\n");
+		else
+			build_protocol(trace_output, fp);
 		fprintf(fp, "seccomp !chroot\t# allowing chroot, just in case this is an Electron app\n");
 		fprintf(fp, "#tracelog\t# send blacklist violations to syslog\n");
 		fprintf(fp, "\n");
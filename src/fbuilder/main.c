@@ -20,10 +20,11 @@
 #include "fbuilder.h"
 int arg_debug = 0;
 int arg_appimage = 0;
+int arg_trace_fanotify = 0;
 
 static const char *const usage_str =
 	"Firejail profile builder\n"
-	"Usage: firejail [--debug] --build[=profile-file] program-and-arguments\n";
+	"Usage: firejail [--debug] [--trace-fanotify] --build[=profile-file] program-and-arguments\n";
 
 static void usage(void) {
 	puts(usage_str);
@@ -55,6 +56,8 @@ printf("\n");
 			arg_debug = 1;
 		else if (strcmp(argv[i], "--appimage") == 0)
 			arg_appimage = 1;
+		else if (strcmp(argv[i], "--trace-fanotify") == 0)
+			arg_trace_fanotify = 1;
 		else if (strcmp(argv[i], "--build") == 0)
 			; // do nothing, this is passed down from firejail
 		else if (strncmp(argv[i], "--build=", 8) == 0) {
@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+// DHCPv4 client, RFC 2131
+//
+// Plain UDP sockets are used: the broadcast flag is set in all messages sent
+// before the address is configured, so the server's replies are broadcast
+// and reach the socket even though the interface has no address yet.
+
+#include "fdhcp.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+
+#define BOOTREQUEST 1
+#define BOOTREPLY 2
+#define DHCP_COOKIE 0x63825363
+#define DHCP_SERVER_PORT 67
+#define DHCP_CLIENT_PORT 68
+#define DHCP_FLAG_BROADCAST 0x8000
+
+// message types
+#define DHCPDISCOVER 1
+#define DHCPOFFER 2
+#define DHCPREQUEST 3
+#define DHCPACK 5
+#define DHCPNAK 6
+
+// options
+#define OPT_PAD 0
+#define OPT_SUBNET_MASK 1
+#define OPT_ROUTER 3
+#define OPT_DNS 6
+#define OPT_DOMAIN_NAME 15
+#define OPT_REQUESTED_IP 50
+#define OPT_LEASE_TIME 51
+#define OPT_MESSAGE_TYPE 53
+#define OPT_SERVER_ID 54
+#define OPT_PARAM_REQUEST 55
+#define OPT_T1 58
+#define OPT_T2 59
+#define OPT_CLIENT_ID 61
+#define OPT_END 255
+
+typedef struct {
+	uint8_t op;
+	uint8_t htype;
+	uint8_t hlen;
+	uint8_t hops;
+	uint32_t xid;
+	uint16_t secs;
+	uint16_t flags;
+	uint32_t ciaddr;
+	uint32_t yiaddr;
+	uint32_t siaddr;
+	uint32_t giaddr;
+	uint8_t chaddr[16];
+	uint8_t sname[64];
+	uint8_t file[128];
+	uint32_t cookie;
+	uint8_t options[312];
+} __attribute__((packed)) Dhcp4Packet;
+
+// information extracted from a server message
+typedef struct {
+	int type;
+	uint32_t server;
+	uint32_t mask;
+	uint32_t router;
+	uint32_t lease;
+	uint32_t t1;
+	uint32_t t2;
+	int dns_cnt;
+	uint32_t dns[MAX_DNS];
+	char domain[256];
+} Dhcp4Reply;
+
+static uint32_t new_xid(void) {
+	uint32_t xid;
+	if (getrandom(&xid, sizeof(xid), 0) != sizeof(xid))
+		xid = (uint32_t) now_ms() ^ (uint32_t) getpid();
+	return xid;
+}
+
+void dhcp4_init(Lease *l) {
+	l->sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (l->sock == -1)
+		errExit("socket");
+
+	int on = 1;
+	if (setsockopt(l->sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1 ||
+	    setsockopt(l->sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on)) == -1)
+		errExit("setsockopt");
+	if (setsockopt(l->sock, SOL_SOCKET, SO_BINDTODEVICE, l->ifname, strlen(l->ifname) + 1) == -1)
+		errExit("setsockopt SO_BINDTODEVICE");
+
+	struct sockaddr_in sin;
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(DHCP_CLIENT_PORT);
+	sin.sin_addr.s_addr = INADDR_ANY;
+	if (bind(l->sock, (struct sockaddr *) &sin, sizeof(sin)) == -1)
+		errExit("bind");
+
+	l->state = STATE_INIT;
+}
+
+static uint8_t *add_option(uint8_t *ptr, uint8_t code, uint8_t len, const void *data) {
+	*ptr++ = code;
+	*ptr++ = len;
+	memcpy(ptr, data, len);
+	return ptr + len;
+}
+
+static void send_message(Lease *l, int type) {
+	Dhcp4Packet pkt;
+	memset(&pkt, 0, sizeof(pkt));
+	pkt.op = BOOTREQUEST;
+	pkt.htype = 1;	// ethernet
+	pkt.hlen = 6;
+	pkt.xid = l->xid;
+	uint64_t secs = (now_ms() - l->start) / 1000;
+	pkt.secs = htons((secs > 0xffff) ? 0xffff : (uint16_t) secs);
+	memcpy(pkt.chaddr, l->mac, 6);
+	pkt.cookie = htonl(DHCP_COOKIE);
+
+	// renewing and rebinding clients own the address, the reply is sent directly to it
+	int renew = (l->state == STATE_RENEWING || l->state == STATE_REBINDING);
+	if (renew)
+		pkt.ciaddr = l->addr;
+	else
+		pkt.flags = htons(DHCP_FLAG_BROADCAST);
+
+	uint8_t *ptr = pkt.options;
+	uint8_t t = (uint8_t) type;
+	ptr = add_option(ptr, OPT_MESSAGE_TYPE, 1, &t);
+	uint8_t client_id[7];
+	client_id[0] = 1;	// ethernet
+	memcpy(client_id + 1, l->mac, 6);
+	ptr = add_option(ptr, OPT_CLIENT_ID, sizeof(client_id), client_id);
+	if (type == DHCPREQUEST && l->state == STATE_REQUESTING) {
+		ptr = add_option(ptr, OPT_REQUESTED_IP, 4, &l->offered);
+		ptr = add_option(ptr, OPT_SERVER_ID, 4, &l->server);
+	}
+	static const uint8_t params[] = {
+		OPT_SUBNET_MASK, OPT_ROUTER, OPT_DNS, OPT_DOMAIN_NAME,
+		OPT_LEASE_TIME, OPT_SERVER_ID, OPT_T1, OPT_T2
+	};
+	ptr = add_option(ptr, OPT_PARAM_REQUEST, sizeof(params), params);
+	*ptr++ = OPT_END;
+
+	struct sockaddr_in dest;
+	memset(&dest, 0, sizeof(dest));
+	dest.sin_family = AF_INET;
+	dest.sin_port = htons(DHCP_SERVER_PORT);
+	dest.sin_addr.s_addr = (l->state == STATE_RENEWING) ? l->server : INADDR_BROADCAST;
+
+	size_t len = ptr - (uint8_t *) &pkt;
+	if (len < 300)	// minimum BOOTP message size, some servers insist on it
+		len = 300;
+	if (sendto(l->sock, &pkt, len, 0, (struct sockaddr *) &dest, sizeof(dest)) == -1 && arg_debug)
+		printf("fdhcp: %s: sendto: %s\n", l->ifname, strerror(errno));
+}
+
+static void start_discover(Lease *l) {
+	l->state = STATE_SELECTING;
+	l->xid = new_xid();
+	l->start = now_ms();
+	l->rto = RTO_INIT;
+	l->tries = 0;
+	if (arg_debug)
+		printf("fdhcp: %s: DHCPDISCOVER\n", l->ifname);
+	send_message(l, DHCPDISCOVER);
+	lease_retransmit(l, 0);
+}
+
+static void parse_options(const Dhcp4Packet *pkt, size_t len, Dhcp4Reply *r) {
+	memset(r, 0, sizeof(Dhcp4Reply));
+	const uint8_t *ptr = pkt->options;
+	const uint8_t *end = (const uint8_t *) pkt + len;
+
+	while (ptr < end && *ptr != OPT_END) {
+		if (*ptr == OPT_PAD) {
+			ptr++;
+			continue;
+		}
+		if (ptr + 2 > end || ptr + 2 + ptr[1] > end)
+			break;
+		uint8_t code = ptr[0];
+		uint8_t olen = ptr[1];
+		const uint8_t *data = ptr + 2;
+
+		switch (code) {
+		case OPT_MESSAGE_TYPE:
+			if (olen >= 1)
+				r->type = data[0];
+			break;
+		case OPT_SERVER_ID:
+			if (olen >= 4)
+				memcpy(&r->server, data, 4);
+			break;
+		case OPT_SUBNET_MASK:
+			if (olen >= 4)
+				memcpy(&r->mask, data, 4);
+			break;
+		case OPT_ROUTER:
+			if (olen >= 4)
+				memcpy(&r->router, data, 4);
+			break;
+		case OPT_LEASE_TIME:
+			if (olen >= 4) {
+				memcpy(&r->lease, data, 4);
+				r->lease = ntohl(r->lease);
+			}
+			break;
+		case OPT_T1:
+			if (olen >= 4) {
+				memcpy(&r->t1, data, 4);
+				r->t1 = ntohl(r->t1);
+			}
+			break;
+		case OPT_T2:
+			if (olen >= 4) {
+				memcpy(&r->t2, data, 4);
+				r->t2 = ntohl(r->t2);
+			}
+			break;
+		case OPT_DNS: {
+			int i;
+			for (i = 0; i + 4 <= olen && r->dns_cnt < MAX_DNS; i += 4)
+				memcpy(&r->dns[r->dns_cnt++], data + i, 4);
+			break;
+		}
+		case OPT_DOMAIN_NAME: {
+			int i;
+			for (i = 0; i < olen && i < (int) sizeof(r->domain) - 1; i++) {
+				// accept only characters valid in a domain name
+				if (!isalnum(data[i]) && data[i] != '-' && data[i] != '.')
+					break;
+				r->domain[i] = data[i];
+			}
+			r->domain[i] = '\0';
+			break;
+		}
+		default:
+			break;
+		}
+		ptr += 2 + olen;
+	}
+}
+
+// classful mask, used only if the server doesn't send one
+static uint32_t default_mask(uint32_t addr) {
+	uint32_t a = ntohl(addr);
+	if ((a & 0x80000000) == 0)
+		return htonl(0xff000000);
+	if ((a & 0xc0000000) == 0x80000000)
+		return htonl(0xffff0000);
+	return htonl(0xffffff00);
+}
+
+static void bind_lease(Lease *l, const Dhcp4Packet *pkt, const Dhcp4Reply *r) {
+	uint32_t mask = (r->mask) ? r->mask : default_mask(pkt->yiaddr);
+
+	// the server gave us a different address
+	if (l->addr && l->addr != pkt->yiaddr)
+		nl_addr4(l->ifindex, l->addr, l->mask, 0, 0);
+
+	uint64_t now = now_ms();
+	uint32_t lease = r->lease;
+	if (lease == 0)
+		lease = 3600;
+	if (lease == 0xffffffff) {	// infinite
+		l->t1_at = l->t2_at = l->expire_at = 0;
+	}
+	else {
+		uint32_t t1 = (r->t1 && r->t1 < lease) ? r->t1 : lease / 2;
+		uint32_t t2 = (r->t2 && r->t2 < lease && r->t2 > t1) ? r->t2 : lease / 8 * 7;
+		l->t1_at = now + (uint64_t) t1 * 1000;
+		l->t2_at = now + (uint64_t) t2 * 1000;
+		l->expire_at = now + (uint64_t) lease * 1000;
+	}
+
+	if (nl_addr4(l->ifindex, pkt->yiaddr, mask, lease, 1) < 0) {
+		fprintf(stderr, "Error fdhcp: cannot configure the address on %s\n", l->ifname);
+		exit(1);
+	}
+	if (r->router && (!l->acquired || r->router != l->router || pkt->yiaddr != l->addr)) {
+		if (nl_route4(l->ifindex, r->router) < 0)
+			fprintf(stderr, "Warning fdhcp: cannot configure the default route on %s\n", l->ifname);
+	}
+
+	if (!l->acquired || pkt->yiaddr != l->addr)
+		fmessage("DHCP: %s: %d.%d.%d.%d/%d, lease %u s\n", l->ifname,
+			PRINT_IP(ntohl(pkt->yiaddr)), __builtin_popcount(mask), lease);
+
+	l->addr = pkt->yiaddr;
+	l->mask = mask;
+	l->router = r->router;
+	l->server = r->server;
+	l->state = STATE_BOUND;
+	l->acquired = 1;
+
+	// name servers
+	int i;
+	l->dns_cnt = 0;
+	for (i = 0; i < r->dns_cnt; i++)
+		inet_ntop(AF_INET, &r->dns[i], l->dns[l->dns_cnt++], INET6_ADDRSTRLEN);
+	strcpy(l->domain, r->domain);
+	lease_dns_changed();
+
+	lease_timer(l, l->t1_at);
+}
+
+// in REQUESTING and RENEWING the reply must come from the server that sent the
+// selected OFFER; in REBINDING any server can extend the lease (RFC 2131 4.4.5)
+static int wrong_server(const Lease *l, const Dhcp4Reply *r) {
+	if (l->state == STATE_REBINDING || !r->server)
+		return 0;
+	return r->server != l->server;
+}
+
+void dhcp4_receive(Lease *l) {
+	Dhcp4Packet pkt;
+	ssize_t len;
+	while ((len = recv(l->sock, &pkt, sizeof(pkt), 0)) > 0) {
+		if (len < (ssize_t) offsetof(Dhcp4Packet, options) ||
+		    pkt.op != BOOTREPLY || pkt.xid != l->xid ||
+		    memcmp(pkt.chaddr, l->mac, 6) != 0 ||
+		    pkt.cookie != htonl(DHCP_COOKIE))
+			continue;
+
+		Dhcp4Reply r;
+		parse_options(&pkt, len, &r);
+
+		if (l->state == STATE_SELECTING && r.type == DHCPOFFER && r.server && pkt.yiaddr) {
+			if (arg_debug)
+				printf("fdhcp: %s: DHCPOFFER %d.%d.%d.%d, DHCPREQUEST\n", l->ifname, PRINT_IP(ntohl(pkt.yiaddr)));
+			l->offered = pkt.yiaddr;
+			l->server = r.server;
+			l->state = STATE_REQUESTING;
+			l->rto = RTO_INIT;
+			l->tries = 1;
+			send_message(l, DHCPREQUEST);
+			lease_retransmit(l, 0);
+		}
+		else if ((r.type == DHCPACK || r.type == DHCPNAK) && wrong_server(l, &r)) {
+			if (arg_debug)
+				printf("fdhcp: %s: reply from server %d.%d.%d.%d ignored\n",
+				       l->ifname, PRINT_IP(ntohl(r.server)));
+		}
+		else if ((l->state == STATE_REQUESTING || l->state == STATE_RENEWING ||
+			  l->state == STATE_REBINDING) && r.type == DHCPACK && pkt.yiaddr) {
+			if (arg_debug)
+				printf("fdhcp: %s: DHCPACK\n", l->ifname);
+			if (!r.server)
+				r.server = l->server;
+			bind_lease(l, &pkt, &r);
+		}
+		else if ((l->state == STATE_REQUESTING || l->state == STATE_RENEWING ||
+			  l->state == STATE_REBINDING) && r.type == DHCPNAK) {
+			if (arg_debug)
+				printf("fdhcp: %s: DHCPNAK\n", l->ifname);
+			if (l->addr) {
+				nl_addr4(l->ifindex, l->addr, l->mask, 0, 0);
+				l->addr = 0;
+			}
+			start_discover(l);
+		}
+	}
+}
+
+void dhcp4_timeout(Lease *l) {
+	uint64_t now = now_ms();
+
+	switch (l->state) {
+	case STATE_INIT:
+	case STATE_SELECTING:
+		if (l->state == STATE_INIT) {
+			start_discover(l);
+			break;
+		}
+		send_message(l, DHCPDISCOVER);
+		lease_retransmit(l, 0);
+		break;
+
+	case STATE_REQUESTING:
+		if (l->tries++ >= REQUEST_TRIES) {
+			start_discover(l);
+			break;
+		}
+		send_message(l, DHCPREQUEST);
+		lease_retransmit(l, 0);
+		break;
+
+	case STATE_BOUND:
+		if (l->t1_at == 0)	// infinite lease
+			break;
+		l->state = STATE_RENEWING;
+		l->xid = new_xid();
+		l->start = now;
+		l->rto = 1000;
+		// fall through
+	case STATE_RENEWING:
+		if (now >= l->t2_at) {
+			l->state = STATE_REBINDING;
+			l->rto = 1000;
+		}
+		else {
+			if (arg_debug)
+				printf("fdhcp: %s: renewing\n", l->ifname);
+			send_message(l, DHCPREQUEST);
+			lease_retransmit(l, l->t2_at);
+			break;
+		}
+		// fall through
+	case STATE_REBINDING:
+		if (now >= l->expire_at) {
+			fmessage("DHCP: %s: lease expired\n", l->ifname);
+			nl_addr4(l->ifindex, l->addr, l->mask, 0, 0);
+			l->addr = 0;
+			start_discover(l);
+			break;
+		}
+		if (arg_debug)
+			printf("fdhcp: %s: rebinding\n", l->ifname);
+		send_message(l, DHCPREQUEST);
+		lease_retransmit(l, l->expire_at);
+		break;
+	}
+}
@@ -0,0 +1,459 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+// DHCPv6 client, RFC 8415, one non-temporary address (IA_NA) per interface
+//
+// The interface needs a usable link-local address before we start,
+// firejail runs "fnet waitll" first.
+
+#include "fdhcp.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+
+#define DHCP6_CLIENT_PORT 546
+#define DHCP6_SERVER_PORT 547
+
+// message types
+#define SOLICIT 1
+#define ADVERTISE 2
+#define REQUEST 3
+#define RENEW 5
+#define REBIND 6
+#define REPLY 7
+
+// options
+#define OPT_CLIENTID 1
+#define OPT_SERVERID 2
+#define OPT_IA_NA 3
+#define OPT_IAADDR 5
+#define OPT_ORO 6
+#define OPT_ELAPSED_TIME 8
+#define OPT_STATUS_CODE 13
+#define OPT_RAPID_COMMIT 14
+#define OPT_DNS_SERVERS 23
+#define OPT_DOMAIN_LIST 24
+
+#define MAX_MSG 1500
+
+// information extracted from a server message
+typedef struct {
+	int type;
+	int status;
+	int rapid_commit;
+	const uint8_t *serverid;
+	size_t serverid_len;
+	int has_addr;
+	struct in6_addr addr;
+	uint32_t t1;
+	uint32_t t2;
+	uint32_t preferred;
+	uint32_t valid;
+	int dns_cnt;
+	struct in6_addr dns[MAX_DNS];
+	char domain[256];
+} Dhcp6Reply;
+
+static uint32_t new_xid(void) {
+	uint32_t xid;
+	if (getrandom(&xid, sizeof(xid), 0) != sizeof(xid))
+		xid = (uint32_t) now_ms() ^ (uint32_t) getpid();
+	return xid & 0xffffff;
+}
+
+void dhcp6_init(Lease *l) {
+	l->sock = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (l->sock == -1)
+		errExit("socket");
+
+	int on = 1;
+	if (setsockopt(l->sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1 ||
+	    setsockopt(l->sock, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on)) == -1)
+		errExit("setsockopt");
+	if (setsockopt(l->sock, SOL_SOCKET, SO_BINDTODEVICE, l->ifname, strlen(l->ifname) + 1) == -1)
+		errExit("setsockopt SO_BINDTODEVICE");
+	if (setsockopt(l->sock, IPPROTO_IPV6, IPV6_MULTICAST_IF, &l->ifindex, sizeof(l->ifindex)) == -1)
+		errExit("setsockopt IPV6_MULTICAST_IF");
+
+	struct sockaddr_in6 sin6;
+	memset(&sin6, 0, sizeof(sin6));
+	sin6.sin6_family = AF_INET6;
+	sin6.sin6_port = htons(DHCP6_CLIENT_PORT);
+	sin6.sin6_addr = in6addr_any;
+	if (bind(l->sock, (struct sockaddr *) &sin6, sizeof(sin6)) == -1)
+		errExit("bind");
+
+	l->state = STATE_INIT;
+}
+
+static uint8_t *add_option(uint8_t *ptr, uint16_t code, uint16_t len, const void *data) {
+	uint16_t v = htons(code);
+	memcpy(ptr, &v, 2);
+	v = htons(len);
+	memcpy(ptr + 2, &v, 2);
+	if (len)
+		memcpy(ptr + 4, data, len);
+	return ptr + 4 + len;
+}
+
+static uint8_t *add_clientid(uint8_t *ptr, const Lease *l) {
+	// DUID-LL
+	uint8_t duid[10] = { 0, 3, 0, 1 };
+	memcpy(duid + 4, l->mac, 6);
+	return add_option(ptr, OPT_CLIENTID, sizeof(duid), duid);
+}
+
+static void send_message(Lease *l, int type) {
+	uint8_t msg[512];
+	msg[0] = (uint8_t) type;
+	msg[1] = (l->xid >> 16) & 0xff;
+	msg[2] = (l->xid >> 8) & 0xff;
+	msg[3] = l->xid & 0xff;
+	uint8_t *ptr = msg + 4;
+
+	ptr = add_clientid(ptr, l);
+	if ((type == REQUEST || type == RENEW) && l->serverid_len)
+		ptr = add_option(ptr, OPT_SERVERID, l->serverid_len, l->serverid);
+
+	// elapsed time in hundredths of a second
+	uint64_t elapsed = (now_ms() - l->start) / 10;
+	uint16_t el = htons((elapsed > 0xffff) ? 0xffff : (uint16_t) elapsed);
+	ptr = add_option(ptr, OPT_ELAPSED_TIME, 2, &el);
+
+	uint16_t oro[2] = { htons(OPT_DNS_SERVERS), htons(OPT_DOMAIN_LIST) };
+	ptr = add_option(ptr, OPT_ORO, sizeof(oro), oro);
+
+	if (type == SOLICIT)
+		ptr = add_option(ptr, OPT_RAPID_COMMIT, 0, NULL);
+
+	// IA_NA, with the address we want for everything but SOLICIT
+	uint8_t ia[12 + 4 + 24];
+	uint32_t iaid = htonl((uint32_t) l->ifindex);
+	memcpy(ia, &iaid, 4);
+	memset(ia + 4, 0, 8);	// T1 and T2 are set by the server
+	uint16_t ia_len = 12;
+	if (type != SOLICIT) {
+		const struct in6_addr *addr = (type == REQUEST) ? &l->offered6 : &l->addr6;
+		uint8_t iaaddr[24];
+		memcpy(iaaddr, addr, 16);
+		memset(iaaddr + 16, 0, 8);
+		add_option(ia + 12, OPT_IAADDR, sizeof(iaaddr), iaaddr);
+		ia_len += 4 + sizeof(iaaddr);
+	}
+	ptr = add_option(ptr, OPT_IA_NA, ia_len, ia);
+
+	struct sockaddr_in6 dest;
+	memset(&dest, 0, sizeof(dest));
+	dest.sin6_family = AF_INET6;
+	dest.sin6_port = htons(DHCP6_SERVER_PORT);
+	inet_pton(AF_INET6, "ff02::1:2", &dest.sin6_addr);	// All_DHCP_Relay_Agents_and_Servers
+	dest.sin6_scope_id = l->ifindex;
+
+	if (sendto(l->sock, msg, ptr - msg, 0, (struct sockaddr *) &dest, sizeof(dest)) == -1 && arg_debug)
+		printf("fdhcp: %s: sendto: %s\n", l->ifname, strerror(errno));
+}
+
+static void start_solicit(Lease *l) {
+	l->state = STATE_SELECTING;
+	l->xid = new_xid();
+	l->start = now_ms();
+	l->rto = RTO_INIT;
+	l->tries = 0;
+	l->serverid_len = 0;
+	if (arg_debug)
+		printf("fdhcp: %s: SOLICIT\n", l->ifname);
+	send_message(l, SOLICIT);
+	lease_retransmit(l, 0);
+}
+
+static uint16_t get16(const uint8_t *ptr) {
+	return (uint16_t) (ptr[0] << 8 | ptr[1]);
+}
+
+static uint32_t get32(const uint8_t *ptr) {
+	return (uint32_t) ptr[0] << 24 | (uint32_t) ptr[1] << 16 | (uint32_t) ptr[2] << 8 | ptr[3];
+}
+
+// decode the first name of a domain search list
+static void decode_domain(const uint8_t *data, size_t len, char *out, size_t outlen) {
+	size_t i = 0;
+	size_t o = 0;
+	while (i < len && data[i] != 0) {
+		size_t label = data[i++];
+		if (label > 63 || i + label > len)
+			break;
+		if (o && o < outlen - 1)
+			out[o++] = '.';
+		size_t j;
+		for (j = 0; j < label && o < outlen - 1; j++) {
+			uint8_t c = data[i + j];
+			if (!isalnum(c) && c != '-')
+				goto out;
+			out[o++] = c;
+		}
+		i += label;
+	}
+out:
+	out[o] = '\0';
+}
+
+static void parse_ia_na(const uint8_t *data, size_t len, Dhcp6Reply *r) {
+	if (len < 12)
+		return;
+	r->t1 = get32(data + 4);
+	r->t2 = get32(data + 8);
+
+	size_t i = 12;
+	while (i + 4 <= len) {
+		uint16_t code = get16(data + i);
+		uint16_t olen = get16(data + i + 2);
+		const uint8_t *odata = data + i + 4;
+		if (i + 4 + olen > len)
+			break;
+		if (code == OPT_IAADDR && olen >= 24) {
+			memcpy(&r->addr, odata, 16);
+			r->preferred = get32(odata + 16);
+			r->valid = get32(odata + 20);
+			r->has_addr = (r->valid != 0);
+		}
+		else if (code == OPT_STATUS_CODE && olen >= 2 && get16(odata) != 0)
+			r->status = get16(odata);
+		i += 4 + olen;
+	}
+}
+
+static int parse_message(const uint8_t *msg, size_t len, const Lease *l, Dhcp6Reply *r) {
+	memset(r, 0, sizeof(Dhcp6Reply));
+	if (len < 4)
+		return -1;
+	r->type = msg[0];
+	uint32_t xid = (uint32_t) msg[1] << 16 | (uint32_t) msg[2] << 8 | msg[3];
+	if (xid != l->xid)
+		return -1;
+
+	int clientid_ok = 0;
+	size_t i = 4;
+	while (i + 4 <= len) {
+		uint16_t code = get16(msg + i);
+		uint16_t olen = get16(msg + i + 2);
+		const uint8_t *data = msg + i + 4;
+		if (i + 4 + olen > len)
+			return -1;
+
+		switch (code) {
+		case OPT_CLIENTID:
+			if (olen == 10 && memcmp(data + 4, l->mac, 6) == 0)
+				clientid_ok = 1;
+			break;
+		case OPT_SERVERID:
+			if (olen <= sizeof(l->serverid)) {
+				r->serverid = data;
+				r->serverid_len = olen;
+			}
+			break;
+		case OPT_IA_NA:
+			if (olen >= 4 && get32(data) == (uint32_t) l->ifindex)
+				parse_ia_na(data, olen, r);
+			break;
+		case OPT_STATUS_CODE:
+			if (olen >= 2 && get16(data) != 0)
+				r->status = get16(data);
+			break;
+		case OPT_RAPID_COMMIT:
+			r->rapid_commit = 1;
+			break;
+		case OPT_DNS_SERVERS: {
+			int j;
+			for (j = 0; j + 16 <= olen && r->dns_cnt < MAX_DNS; j += 16)
+				memcpy(&r->dns[r->dns_cnt++], data + j, 16);
+			break;
+		}
+		case OPT_DOMAIN_LIST:
+			decode_domain(data, olen, r->domain, sizeof(r->domain));
+			break;
+		default:
+			break;
+		}
+		i += 4 + olen;
+	}
+
+	if (!clientid_ok || !r->serverid)
+		return -1;
+	return 0;
+}
+
+static void bind_lease(Lease *l, const Dhcp6Reply *r) {
+	if (l->acquired && memcmp(&l->addr6, &r->addr, 16) != 0)
+		nl_addr6(l->ifindex, &l->addr6, 0, 0, 0);
+
+	uint64_t now = now_ms();
+	if (r->valid == 0xffffffff) {	// infinite
+		l->t1_at = l->t2_at = l->expire_at = 0;
+	}
+	else {
+		// T1 and T2 set to 0 leave the times to the client
+		uint32_t t1 = (r->t1 && r->t1 <= r->preferred) ? r->t1 : r->preferred / 2;
+		uint32_t t2 = (r->t2 && r->t2 > t1 && r->t2 <= r->valid) ? r->t2 : r->preferred / 5 * 4;
+		if (t2 <= t1)
+			t2 = t1 + 1;
+		l->t1_at = now + (uint64_t) t1 * 1000;
+		l->t2_at = now + (uint64_t) t2 * 1000;
+		l->expire_at = now + (uint64_t) r->valid * 1000;
+	}
+
+	if (nl_addr6(l->ifindex, &r->addr, r->preferred, r->valid, 1) < 0) {
+		fprintf(stderr, "Error fdhcp: cannot configure the IPv6 address on %s\n", l->ifname);
+		exit(1);
+	}
+
+	if (!l->acquired || memcmp(&l->addr6, &r->addr, 16) != 0) {
+		char buf[INET6_ADDRSTRLEN];
+		inet_ntop(AF_INET6, &r->addr, buf, sizeof(buf));
+		fmessage("DHCPv6: %s: %s, lease %u s\n", l->ifname, buf, r->valid);
+	}
+
+	l->addr6 = r->addr;
+	memcpy(l->serverid, r->serverid, r->serverid_len);
+	l->serverid_len = r->serverid_len;
+	l->state = STATE_BOUND;
+	l->acquired = 1;
+
+	int i;
+	l->dns_cnt = 0;
+	for (i = 0; i < r->dns_cnt; i++)
+		inet_ntop(AF_INET6, &r->dns[i], l->dns[l->dns_cnt++], INET6_ADDRSTRLEN);
+	strcpy(l->domain, r->domain);
+	lease_dns_changed();
+
+	lease_timer(l, l->t1_at);
+}
+
+// in REQUESTING and RENEWING the reply must come from the server that sent the
+// selected ADVERTISE; in REBINDING any server can extend the lease (RFC 8415 18.2.5)
+static int wrong_server(const Lease *l, const Dhcp6Reply *r) {
+	if (l->state != STATE_REQUESTING && l->state != STATE_RENEWING)
+		return 0;
+	return r->serverid_len != l->serverid_len ||
+		memcmp(r->serverid, l->serverid, l->serverid_len) != 0;
+}
+
+void dhcp6_receive(Lease *l) {
+	uint8_t msg[MAX_MSG];
+	ssize_t len;
+	while ((len = recv(l->sock, msg, sizeof(msg), 0)) > 0) {
+		Dhcp6Reply r;
+		if (parse_message(msg, len, l, &r))
+			continue;
+
+		if (l->state == STATE_SELECTING && r.type == ADVERTISE && r.has_addr && !r.status) {
+			if (arg_debug)
+				printf("fdhcp: %s: ADVERTISE, REQUEST\n", l->ifname);
+			l->offered6 = r.addr;
+			memcpy(l->serverid, r.serverid, r.serverid_len);
+			l->serverid_len = r.serverid_len;
+			l->state = STATE_REQUESTING;
+			l->xid = new_xid();
+			l->rto = RTO_INIT;
+			l->tries = 1;
+			send_message(l, REQUEST);
+			lease_retransmit(l, 0);
+		}
+		else if (r.type == REPLY && wrong_server(l, &r)) {
+			if (arg_debug)
+				printf("fdhcp: %s: REPLY from another server ignored\n", l->ifname);
+		}
+		else if (r.type == REPLY &&
+			 ((l->state == STATE_SELECTING && r.rapid_commit) ||
+			  l->state == STATE_REQUESTING || l->state == STATE_RENEWING ||
+			  l->state == STATE_REBINDING)) {
+			if (r.status || !r.has_addr) {
+				if (arg_debug)
+					printf("fdhcp: %s: REPLY with status %d\n", l->ifname, r.status);
+				if (l->state == STATE_RENEWING || l->state == STATE_REBINDING)
+					nl_addr6(l->ifindex, &l->addr6, 0, 0, 0);
+				start_solicit(l);
+				continue;
+			}
+			if (arg_debug)
+				printf("fdhcp: %s: REPLY\n", l->ifname);
+			bind_lease(l, &r);
+		}
+	}
+}
+
+void dhcp6_timeout(Lease *l) {
+	uint64_t now = now_ms();
+
+	switch (l->state) {
+	case STATE_INIT:
+		start_solicit(l);
+		break;
+
+	case STATE_SELECTING:
+		send_message(l, SOLICIT);
+		lease_retransmit(l, 0);
+		break;
+
+	case STATE_REQUESTING:
+		if (l->tries++ >= REQUEST_TRIES) {
+			start_solicit(l);
+			break;
+		}
+		send_message(l, REQUEST);
+		lease_retransmit(l, 0);
+		break;
+
+	case STATE_BOUND:
+		if (l->t1_at == 0)	// infinite lease
+			break;
+		l->state = STATE_RENEWING;
+		l->xid = new_xid();
+		l->start = now;
+		l->rto = 1000;
+		// fall through
+	case STATE_RENEWING:
+		if (now >= l->t2_at) {
+			l->state = STATE_REBINDING;
+			l->xid = new_xid();
+			l->rto = 1000;
+		}
+		else {
+			if (arg_debug)
+				printf("fdhcp: %s: RENEW\n", l->ifname);
+			send_message(l, RENEW);
+			lease_retransmit(l, l->t2_at);
+			break;
+		}
+		// fall through
+	case STATE_REBINDING:
+		if (now >= l->expire_at) {
+			fmessage("DHCPv6: %s: lease expired\n", l->ifname);
+			nl_addr6(l->ifindex, &l->addr6, 0, 0, 0);
+			start_solicit(l);
+			break;
+		}
+		if (arg_debug)
+			printf("fdhcp: %s: REBIND\n", l->ifname);
+		send_message(l, REBIND);
+		lease_retransmit(l, l->expire_at);
+		break;
+	}
+}
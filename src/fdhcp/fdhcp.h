@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef FDHCP_H
+#define FDHCP_H
+
+#include "../include/common.h"
+#include "../include/message.h"
+#include <net/if.h>
+#include <netinet/in.h>
+#include <stdarg.h>
+
+#define MAX_LEASES 8		// four interfaces, IPv4 and IPv6
+#define MAX_DNS 4
+#define ACQUIRE_TIMEOUT 30	// seconds allowed for the initial exchange
+
+// retransmission timers, much shorter than the RFC values: the server is
+// usually on the same bridge, and the sandbox start is waiting for us
+#define RTO_INIT 200		// ms
+#define RTO_MAX 4000		// ms, address acquisition
+#define RTO_MAX_RENEW 60000	// ms, renewing and rebinding
+#define REQUEST_TRIES 5		// requests sent before starting over
+
+typedef enum {
+	STATE_INIT = 0,
+	STATE_SELECTING,	// DHCPDISCOVER / SOLICIT sent
+	STATE_REQUESTING,	// DHCPREQUEST / REQUEST sent
+	STATE_BOUND,
+	STATE_RENEWING,
+	STATE_REBINDING
+} State;
+
+typedef struct {
+	int family;		// AF_INET or AF_INET6
+	char ifname[IFNAMSIZ];
+	int ifindex;
+	unsigned char mac[6];
+	int sock;
+	int timer;		// timerfd
+	State state;
+	uint32_t xid;
+	unsigned rto;		// current retransmission timeout, ms
+	int tries;
+	uint64_t start;		// start of the current exchange, ms
+	int acquired;		// set after the first lease
+
+	// lease, times in ms since boot
+	uint64_t t1_at;
+	uint64_t t2_at;
+	uint64_t expire_at;
+
+	// IPv4
+	uint32_t addr;		// network byte order
+	uint32_t offered;
+	uint32_t mask;
+	uint32_t router;
+	uint32_t server;
+
+	// IPv6
+	struct in6_addr addr6;
+	struct in6_addr offered6;
+	unsigned char serverid[128];
+	size_t serverid_len;
+
+	// DNS
+	int dns_cnt;
+	char dns[MAX_DNS][INET6_ADDRSTRLEN];
+	char domain[256];
+} Lease;
+
+// main.c
+extern int arg_debug;
+extern int arg_quiet;
+uint64_t now_ms(void);
+void lease_timer(Lease *l, uint64_t at);
+void lease_retransmit(Lease *l, uint64_t deadline);
+void lease_dns_changed(void);
+
+// dhcp4.c
+void dhcp4_init(Lease *l);
+void dhcp4_receive(Lease *l);
+void dhcp4_timeout(Lease *l);
+
+// dhcp6.c
+void dhcp6_init(Lease *l);
+void dhcp6_receive(Lease *l);
+void dhcp6_timeout(Lease *l);
+
+// netlink.c
+int nl_addr4(int ifindex, uint32_t addr, uint32_t mask, uint32_t lifetime, int add);
+int nl_route4(int ifindex, uint32_t gw);
+int nl_addr6(int ifindex, const struct in6_addr *addr, uint32_t preferred, uint32_t valid, int add);
+
+#endif
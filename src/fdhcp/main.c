@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+// fdhcp - DHCPv4/DHCPv6 client running inside the sandbox
+//
+// All interfaces are handled by a single epoll loop. The process stays in the
+// foreground until every interface has a lease, so firejail can simply wait
+// for it; it then forks in the background and keeps renewing the leases.
+
+#include "fdhcp.h"
+#include "../include/rundefs.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+int arg_debug = 0;
+int arg_quiet = 0;
+
+static Lease leases[MAX_LEASES];
+static int lease_cnt = 0;
+static int dns_changed = 0;
+
+static const char *const usage_str =
+	"Usage: fdhcp [-4 dev] [-6 dev] ...\n"
+	"\t-4 dev - acquire an IPv4 address on interface dev\n"
+	"\t-6 dev - acquire an IPv6 address on interface dev\n";
+
+static void usage(void) {
+	puts(usage_str);
+}
+
+uint64_t now_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_BOOTTIME, &ts);
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// arm the lease timer for an absolute time in ms since boot; 0 disarms the timer
+void lease_timer(Lease *l, uint64_t at) {
+	struct itimerspec its;
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = at / 1000;
+	its.it_value.tv_nsec = (at % 1000) * 1000000;
+	if (timerfd_settime(l->timer, TFD_TIMER_ABSTIME, &its, NULL) == -1)
+		errExit("timerfd_settime");
+}
+
+// schedule the next retransmission, no later than deadline (0 - no deadline)
+void lease_retransmit(Lease *l, uint64_t deadline) {
+	uint64_t at = now_ms() + l->rto;
+	if (deadline && at > deadline)
+		at = deadline;
+	lease_timer(l, at);
+
+	unsigned max = (l->state == STATE_RENEWING || l->state == STATE_REBINDING) ? RTO_MAX_RENEW : RTO_MAX;
+	l->rto *= 2;
+	if (l->rto > max)
+		l->rto = max;
+}
+
+void lease_dns_changed(void) {
+	dns_changed = 1;
+}
+
+// rewrite /etc/resolv.conf using the name servers received on all interfaces;
+// inside the sandbox this is the private copy built by firejail
+static void resolv_update(void) {
+	dns_changed = 0;
+
+	int i, j;
+	int cnt = 0;
+	for (i = 0; i < lease_cnt; i++)
+		cnt += leases[i].dns_cnt;
+	if (cnt == 0)
+		return;
+
+	FILE *fp = fopen("/etc/resolv.conf", "we");
+	if (!fp) {
+		fprintf(stderr, "Warning fdhcp: cannot update /etc/resolv.conf\n");
+		return;
+	}
+	for (i = 0; i < lease_cnt; i++) {
+		if (*leases[i].domain) {
+			fprintf(fp, "search %s\n", leases[i].domain);
+			break;
+		}
+	}
+	for (i = 0; i < lease_cnt; i++)
+		for (j = 0; j < leases[i].dns_cnt; j++)
+			fprintf(fp, "nameserver %s\n", leases[i].dns[j]);
+	fclose(fp);
+}
+
+static void lease_new(int family, const char *ifname) {
+	if (lease_cnt >= MAX_LEASES) {
+		fprintf(stderr, "Error fdhcp: too many interfaces\n");
+		exit(1);
+	}
+	if (strlen(ifname) >= IFNAMSIZ) {
+		fprintf(stderr, "Error fdhcp: invalid network device name %s\n", ifname);
+		exit(1);
+	}
+
+	Lease *l = &leases[lease_cnt++];
+	memset(l, 0, sizeof(Lease));
+	l->family = family;
+	strcpy(l->ifname, ifname);
+
+	int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (sock == -1)
+		errExit("socket");
+	struct ifreq ifr;
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+	if (ioctl(sock, SIOCGIFINDEX, &ifr) == -1) {
+		fprintf(stderr, "Error fdhcp: cannot find interface %s\n", ifname);
+		exit(1);
+	}
+	l->ifindex = ifr.ifr_ifindex;
+	if (ioctl(sock, SIOCGIFHWADDR, &ifr) == -1)
+		errExit("ioctl SIOCGIFHWADDR");
+	memcpy(l->mac, ifr.ifr_hwaddr.sa_data, 6);
+	close(sock);
+
+	l->timer = timerfd_create(CLOCK_BOOTTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (l->timer == -1)
+		errExit("timerfd_create");
+
+	if (family == AF_INET)
+		dhcp4_init(l);
+	else
+		dhcp6_init(l);
+}
+
+static int all_acquired(void) {
+	int i;
+	for (i = 0; i < lease_cnt; i++)
+		if (!leases[i].acquired)
+			return 0;
+	return 1;
+}
+
+// continue in the background; the parent records our pid for firejail and exits
+static void daemonize(void) {
+	fflush(0);
+	pid_t child = fork();
+	if (child == -1)
+		errExit("fork");
+	if (child) {
+		FILE *fp = fopen(RUN_DHCP_PID_FILE, "we");
+		if (!fp) {
+			fprintf(stderr, "Error fdhcp: cannot create %s\n", RUN_DHCP_PID_FILE);
+			kill(child, SIGKILL);
+			exit(1);
+		}
+		fprintf(fp, "%d\n", child);
+		fclose(fp);
+		_exit(0);
+	}
+
+	setsid();
+	if (!arg_debug) {
+		int fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+		if (fd != -1) {
+			dup2(fd, STDIN_FILENO);
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			close(fd);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		usage();
+		return 1;
+	}
+	if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-?") ==0) {
+		usage();
+		return 0;
+	}
+
+	warn_dumpable();
+
+	char *quiet = getenv("FIREJAIL_QUIET");
+	if (quiet && strcmp(quiet, "yes") == 0)
+		arg_quiet = 1;
+	char *debug = getenv("FIREJAIL_DEBUG");
+	if (debug && strcmp(debug, "yes") == 0)
+		arg_debug = 1;
+
+	int i;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-4") == 0 && i + 1 < argc)
+			lease_new(AF_INET, argv[++i]);
+		else if (strcmp(argv[i], "-6") == 0 && i + 1 < argc)
+			lease_new(AF_INET6, argv[++i]);
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	int epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (epfd == -1)
+		errExit("epoll_create1");
+	for (i = 0; i < lease_cnt; i++) {
+		// event data: lease index, lowest bit set for the timer
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.u64 = (uint64_t) i << 1;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, leases[i].sock, &ev) == -1)
+			errExit("epoll_ctl");
+		ev.data.u64 = ((uint64_t) i << 1) | 1;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, leases[i].timer, &ev) == -1)
+			errExit("epoll_ctl");
+
+		// first transmission
+		lease_timer(&leases[i], now_ms());
+	}
+
+	int background = 0;
+	uint64_t acquire_end = now_ms() + ACQUIRE_TIMEOUT * 1000;
+	while (1) {
+		int timeout = -1;
+		if (!background) {
+			uint64_t now = now_ms();
+			timeout = (now >= acquire_end) ? 0 : (int) (acquire_end - now);
+		}
+
+		struct epoll_event events[MAX_LEASES * 2];
+		int n = epoll_wait(epfd, events, MAX_LEASES * 2, timeout);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			errExit("epoll_wait");
+		}
+		if (n == 0 && !background) {
+			for (i = 0; i < lease_cnt; i++)
+				if (!leases[i].acquired)
+					fprintf(stderr, "Error fdhcp: no DHCP%s lease on %s\n",
+						(leases[i].family == AF_INET) ? "" : "v6", leases[i].ifname);
+			exit(1);
+		}
+
+		for (i = 0; i < n; i++) {
+			Lease *l = &leases[events[i].data.u64 >> 1];
+			if (events[i].data.u64 & 1) {
+				uint64_t expirations;
+				if (read(l->timer, &expirations, sizeof(expirations)) != sizeof(expirations))
+					continue;
+				if (l->family == AF_INET)
+					dhcp4_timeout(l);
+				else
+					dhcp6_timeout(l);
+			}
+			else {
+				if (l->family == AF_INET)
+					dhcp4_receive(l);
+				else
+					dhcp6_receive(l);
+			}
+		}
+
+		if (dns_changed)
+			resolv_update();
+
+		if (!background && all_acquired()) {
+			daemonize();
+			background = 1;
+		}
+	}
+
+	return 0;
+}
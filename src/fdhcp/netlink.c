@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "fdhcp.h"
+#include "../include/libnetlink.h"
+
+struct addr_req {
+	struct nlmsghdr n;
+	struct ifaddrmsg ifa;
+	char buf[256];
+};
+
+struct route_req {
+	struct nlmsghdr n;
+	struct rtmsg r;
+	char buf[256];
+};
+
+static struct rtnl_handle rth = { .fd = -1 };
+
+static int nl_talk(struct nlmsghdr *n) {
+	if (rth.fd == -1 && rtnl_open(&rth, 0) < 0) {
+		fprintf(stderr, "Error fdhcp: cannot open netlink\n");
+		exit(1);
+	}
+	return rtnl_talk(&rth, n, 0, 0, NULL);
+}
+
+static int mask2prefix(uint32_t mask) {
+	mask = ntohl(mask);
+	int prefix = 0;
+	while (mask & 0x80000000) {
+		prefix++;
+		mask <<= 1;
+	}
+	return prefix;
+}
+
+// the lifetime of the address is the lease time, the kernel removes the address
+// if we are not around to renew it
+static void add_cacheinfo(struct nlmsghdr *n, int maxlen, uint32_t preferred, uint32_t valid) {
+	struct ifa_cacheinfo ci;
+	memset(&ci, 0, sizeof(ci));
+	ci.ifa_prefered = preferred;
+	ci.ifa_valid = valid;
+	addattr_l(n, maxlen, IFA_CACHEINFO, &ci, sizeof(ci));
+}
+
+// add (or update) and remove IPv4 addresses
+int nl_addr4(int ifindex, uint32_t addr, uint32_t mask, uint32_t lifetime, int add) {
+	struct addr_req req;
+	memset(&req, 0, sizeof(req));
+	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+	req.n.nlmsg_flags = NLM_F_REQUEST | ((add) ? NLM_F_CREATE | NLM_F_REPLACE : 0);
+	req.n.nlmsg_type = (add) ? RTM_NEWADDR : RTM_DELADDR;
+	req.ifa.ifa_family = AF_INET;
+	req.ifa.ifa_prefixlen = mask2prefix(mask);
+	req.ifa.ifa_scope = RT_SCOPE_UNIVERSE;
+	req.ifa.ifa_index = ifindex;
+
+	addattr_l(&req.n, sizeof(req), IFA_LOCAL, &addr, 4);
+	addattr_l(&req.n, sizeof(req), IFA_ADDRESS, &addr, 4);
+	if (add) {
+		uint32_t brd = addr | ~mask;
+		addattr_l(&req.n, sizeof(req), IFA_BROADCAST, &brd, 4);
+		add_cacheinfo(&req.n, sizeof(req), lifetime, lifetime);
+	}
+
+	return nl_talk(&req.n);
+}
+
+// set the default route
+int nl_route4(int ifindex, uint32_t gw) {
+	struct route_req req;
+	memset(&req, 0, sizeof(req));
+	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+	req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_CREATE | NLM_F_REPLACE;
+	req.n.nlmsg_type = RTM_NEWROUTE;
+	req.r.rtm_family = AF_INET;
+	req.r.rtm_table = RT_TABLE_MAIN;
+	req.r.rtm_protocol = RTPROT_DHCP;
+	req.r.rtm_scope = RT_SCOPE_UNIVERSE;
+	req.r.rtm_type = RTN_UNICAST;
+	req.r.rtm_dst_len = 0;
+
+	addattr_l(&req.n, sizeof(req), RTA_GATEWAY, &gw, 4);
+	addattr_l(&req.n, sizeof(req), RTA_OIF, &ifindex, 4);
+
+	return nl_talk(&req.n);
+}
+
+// add (or update) and remove IPv6 addresses; DHCPv6 doesn't carry
+// a prefix length, the on-link prefix comes from router advertisements
+int nl_addr6(int ifindex, const struct in6_addr *addr, uint32_t preferred, uint32_t valid, int add) {
+	struct addr_req req;
+	memset(&req, 0, sizeof(req));
+	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+	req.n.nlmsg_flags = NLM_F_REQUEST | ((add) ? NLM_F_CREATE | NLM_F_REPLACE : 0);
+	req.n.nlmsg_type = (add) ? RTM_NEWADDR : RTM_DELADDR;
+	req.ifa.ifa_family = AF_INET6;
+	req.ifa.ifa_prefixlen = 128;
+	req.ifa.ifa_scope = RT_SCOPE_UNIVERSE;
+	req.ifa.ifa_index = ifindex;
+
+	addattr_l(&req.n, sizeof(req), IFA_ADDRESS, addr, sizeof(struct in6_addr));
+	if (add)
+		add_cacheinfo(&req.n, sizeof(req), preferred, valid);
+
+	return nl_talk(&req.n);
+}
@@ -19,37 +19,95 @@
 */
 #include"fids.h"
 
+// Exclude prefixes are kept in a sorted array. An entry starting with another entry
+// is redundant and dropped, so a file name can only match the last entry less than or
+// equal to it, and the lookup is a binary search. The config file adds entries between
+// scans; the array is rebuilt on the first check after an addition.
 typedef struct db_exclude_t {
-	struct db_exclude_t *next;
 	char *fname;
-	int len;
+	size_t len;
 } DB_EXCLUDE;
 static DB_EXCLUDE *database = NULL;
+static int db_cnt = 0;
+static int db_max = 0;
+static int db_sorted = 1;
 
 void db_exclude_add(const char *fname) {
 	assert(fname);
 
-	DB_EXCLUDE *ptr = malloc(sizeof(DB_EXCLUDE));
-	if (!ptr)
-		errExit("malloc");
+	if (db_cnt == db_max) {
+		db_max = (db_max) ? 2 * db_max : 64;
+		database = realloc(database, db_max * sizeof(DB_EXCLUDE));
+		if (!database)
+			errExit("realloc");
+	}
 
+	DB_EXCLUDE *ptr = &database[db_cnt++];
 	ptr->fname = strdup(fname);
 	if (!ptr->fname)
 		errExit("strdup");
 	ptr->len = strlen(fname);
-	ptr->next = database;
-	database = ptr;
+	db_sorted = 0;
+}
+
+static int compare(const void *a, const void *b) {
+	return strcmp(((const DB_EXCLUDE *) a)->fname, ((const DB_EXCLUDE *) b)->fname);
+}
+
+static void db_exclude_compile(void) {
+	qsort(database, db_cnt, sizeof(DB_EXCLUDE), compare);
+
+	// an entry starting with a kept entry always follows it directly in the sorted array
+	int i;
+	int cnt = 0;
+	for (i = 0; i < db_cnt; i++) {
+		if (cnt && strncmp(database[i].fname, database[cnt - 1].fname, database[cnt - 1].len) == 0) {
+			free(database[i].fname);
+			continue;
+		}
+		database[cnt++] = database[i];
+	}
+	db_cnt = cnt;
+	db_sorted = 1;
+}
+
+// index of the first entry greater than fname, or greater than or equal to fname if equal is set
+static int db_search(const char *fname, int equal) {
+	if (!db_sorted)
+		db_exclude_compile();
+
+	int low = 0;
+	int high = db_cnt;
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		int rv = strcmp(database[mid].fname, fname);
+		if (rv < 0 || (rv == 0 && !equal))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
 }
 
 int db_exclude_check(const char *fname) {
 	assert(fname);
 
-	DB_EXCLUDE *ptr = database;
-	while (ptr != NULL) {
-		if (strncmp(fname, ptr->fname, ptr->len) == 0)
-			return 1;
-		ptr = ptr->next;
-	}
+	int i = db_search(fname, 0) - 1;
+	return (i >= 0 && strncmp(fname, database[i].fname, database[i].len) == 0);
+}
+
+// return 1 if some entry starts with "dir/", the files under dir need to be checked
+int db_exclude_subtree(const char *dir) {
+	assert(dir);
+
+	char *key;
+	if (asprintf(&key, "%s/", dir) == -1)
+		errExit("asprintf");
+	size_t len = strlen(key);
 
-	return 0;
+	// the entries starting with key follow each other, beginning with the first one >= key
+	int i = db_search(key, 1);
+	int rv = (i < db_cnt && strncmp(database[i].fname, key, len) == 0);
+	free(key);
+	return rv;
 }
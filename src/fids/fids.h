@@ -40,6 +40,7 @@ void db_missing(void);
 // db_exclude.c
 void db_exclude_add(const char *fname);
 int db_exclude_check(const char *fname);
+int db_exclude_subtree(const char *dir);
 
 
 // blake2b.c
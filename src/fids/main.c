@@ -102,6 +102,7 @@ static void file_checksum(const char *fname) {
 	int mmapped = 0;
 	if (size == 0) {
 		// empty files don't mmap - use "empty" string as the file content
+		close(fd);
 		size = 6; // strlen("empty") + 1
 	}
 	else {
@@ -139,14 +140,15 @@ static void file_checksum(const char *fname) {
 	fflush(0);
 }
 
-void list_directory(const char *fname) {
+// check is 0 if no exclude entry applies to fname and the files under it
+static void list_directory(const char *fname, int check) {
 	assert(fname);
 	if (dir_level > MAX_DIR_LEVEL) {
 		fprintf(stderr, "Warning fids: maximum depth level exceeded for %s\n", fname);
 		return;
 	}
 
-	if (db_exclude_check(fname))
+	if (check && db_exclude_check(fname))
 		return;
 
 	if (is_link(fname))
@@ -163,6 +165,10 @@ void list_directory(const char *fname) {
 	if (!(dir = opendir(fname)))
 		return;
 
+	// skip the exclude checks for the directory entries if no exclude entry is under this directory
+	if (check)
+		check = db_exclude_subtree(fname);
+
 	dir_level++;
 	while ((entry = readdir(dir)) != NULL) {
 		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
@@ -170,7 +176,7 @@ void list_directory(const char *fname) {
 		char *path;
 		if (asprintf(&path, "%s/%s", fname, entry->d_name) == -1)
 			errExit("asprintf");
-		list_directory(path);
+		list_directory(path, check);
 		free(path);
 	}
 	closedir(dir);
@@ -196,7 +202,7 @@ void globbing(const char *fname) {
 		char *path = globbuf.gl_pathv[i];
 		assert(path);
 
-		list_directory(path);
+		list_directory(path, 1);
 	}
 
 	globfree(&globbuf);
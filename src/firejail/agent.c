@@ -0,0 +1,602 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "firejail.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+
+// --join-agent: a process started in the sandbox next to the application, already in
+// all namespaces and with the capabilities, cpu affinity and seccomp filters of the
+// sandbox loaded. It listens on a root-owned unix socket in RUN_FIREJAIL_AGENT_DIR,
+// and --join sends it the command instead of switching namespaces itself.
+// The same requests are used to start the application of a warm sandbox (pool.c).
+#define AGENT_MAGIC 0x4147464a	// "JFGA"
+#define AGENT_VERSION 1
+#define AGENT_MAX_DATA (4 * 1024 * 1024)
+
+// client -> agent; the client stdin, stdout and stderr are attached with SCM_RIGHTS
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t argc;
+	uint32_t envc;
+	uint32_t len;	// size of the data following the header: cwd, argv and environment,
+			// all strings NUL terminated
+} AgentRequest;
+
+// agent -> client
+#define AGENT_STARTED 1		// value: pid, nsec: request to start latency
+#define AGENT_EXITED 2		// value: wait status
+typedef struct {
+	uint32_t type;
+	int32_t value;
+	uint64_t nsec;
+} AgentReply;
+// after AGENT_STARTED the client forwards the signals it receives as int32_t values
+
+extern int just_run_the_shell;
+pid_t agent_pid = 0;
+static int agent_fd = -1;
+
+static char *agent_socket_name(pid_t pid) {
+	char *fname;
+	if (asprintf(&fname, "%s/%d", RUN_FIREJAIL_AGENT_DIR, pid) == -1)
+		errExit("asprintf");
+	return fname;
+}
+
+static int read_all(int fd, void *buf, size_t len) {
+	char *ptr = buf;
+	while (len) {
+		ssize_t rv = read(fd, ptr, len);
+		if (rv == -1 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+			return -1;
+		ptr += rv;
+		len -= rv;
+	}
+	return 0;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+	const char *ptr = buf;
+	while (len) {
+		ssize_t rv = write(fd, ptr, len);
+		if (rv == -1 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+			return -1;
+		ptr += rv;
+		len -= rv;
+	}
+	return 0;
+}
+
+static uint64_t nsec_since(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) (now.tv_sec - start->tv_sec) * 1000000000ULL + now.tv_nsec - start->tv_nsec;
+}
+
+static void socket_address(struct sockaddr_un *addr, const char *fname) {
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (strlen(fname) >= sizeof(addr->sun_path)) {
+		fprintf(stderr, "Error: invalid socket name %s\n", fname);
+		exit(1);
+	}
+	strcpy(addr->sun_path, fname);
+}
+
+// create a listening socket owned by root, open to everybody; the credentials
+// of the peer are checked for every connection
+int agent_listen(const char *fname) {
+	assert(fname);
+	struct sockaddr_un addr;
+	socket_address(&addr, fname);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		errExit("socket");
+
+	EUID_ROOT();
+	int rv = unlink(fname);	// left over by a process that was killed
+	(void) rv;
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1)
+		errExit("bind");
+	if (chmod(fname, 0666) == -1)
+		errExit("chmod");
+	if (listen(fd, 64) == -1)
+		errExit("listen");
+	EUID_USER();
+	return fd;
+}
+
+// accept a connection from the user running the sandbox; return -1 if the
+// connection was rejected
+int agent_accept(int fd) {
+	int conn = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+	if (conn == -1) {
+		if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN)
+			return -1;
+		errExit("accept4");
+	}
+
+	struct ucred cr;
+	socklen_t len = sizeof(cr);
+	if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cr, &len) == -1 || cr.uid != getuid()) {
+		close(conn);
+		return -1;
+	}
+	return conn;
+}
+
+// called by the parent before the sandbox is cloned; the listening socket is
+// inherited by the sandbox process
+void agent_create(void) {
+	EUID_ASSERT();
+	char *fname = agent_socket_name(getpid());
+	agent_fd = agent_listen(fname);
+	if (arg_debug)
+		printf("Join agent socket %s\n", fname);
+	free(fname);
+}
+
+// the parent doesn't need the socket after the sandbox was cloned
+void agent_close(void) {
+	if (agent_fd != -1) {
+		close(agent_fd);
+		agent_fd = -1;
+	}
+}
+
+void agent_delete(pid_t pid) {
+	char *fname = agent_socket_name(pid);
+	int rv = unlink(fname);
+	(void) rv;
+	free(fname);
+}
+
+//***********************************************
+// requests, running in the sandbox
+//***********************************************
+// read a request; return -1 if the request is not valid
+int agent_read_command(int conn, AgentCommand *cmd) {
+	assert(cmd);
+	AgentRequest req;
+	char cbuf[CMSG_SPACE(sizeof(cmd->fds))];
+	struct iovec iov = { .iov_base = &req, .iov_len = sizeof(req) };
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+	if (recvmsg(conn, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC) != sizeof(req))
+		return -1;
+	clock_gettime(CLOCK_MONOTONIC, &cmd->start);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(cmd->fds)))
+		return -1;
+	memcpy(cmd->fds, CMSG_DATA(cmsg), sizeof(cmd->fds));
+
+	if (req.magic != AGENT_MAGIC || req.version != AGENT_VERSION ||
+	    req.len == 0 || req.len > AGENT_MAX_DATA || req.argc == 0 ||
+	    req.argc > req.len || req.envc > req.len)
+		return -1;
+	char *data = malloc(req.len);
+	if (!data)
+		errExit("malloc");
+	if (read_all(conn, data, req.len) || data[req.len - 1] != '\0')
+		return -1;
+
+	// cwd, argv, env; argv[0] is a placeholder for the program index used by start_application()
+	cmd->argc = req.argc + 1;
+	cmd->argv = calloc(req.argc + 2, sizeof(char *));
+	cmd->envp = calloc(req.envc + 1, sizeof(char *));
+	if (!cmd->argv || !cmd->envp)
+		errExit("calloc");
+	cmd->argv[0] = "firejail";
+	char *ptr = data;
+	char *end = data + req.len;
+	cmd->cwd = ptr;
+	ptr += strlen(ptr) + 1;
+	uint32_t i;
+	for (i = 0; i < req.argc; i++) {
+		if (ptr >= end)
+			return -1;
+		cmd->argv[i + 1] = ptr;
+		ptr += strlen(ptr) + 1;
+	}
+	for (i = 0; i < req.envc; i++) {
+		if (ptr >= end)
+			return -1;
+		cmd->envp[i] = ptr;
+		ptr += strlen(ptr) + 1;
+	}
+	if (ptr != end)
+		return -1;
+	return 0;
+}
+
+// switch the current process to the stdio, directory, environment and program of the request
+void agent_apply_command(AgentCommand *cmd) {
+	assert(cmd);
+	int i;
+	for (i = 0; i < 3; i++) {
+		if (dup2(cmd->fds[i], i) == -1)
+			errExit("dup2");
+	}
+	for (i = 0; i < 3; i++) {
+		if (cmd->fds[i] > 2)
+			close(cmd->fds[i]);
+	}
+
+	if (chdir(cmd->cwd) == -1) {
+		if (chdir("/") == -1)
+			errExit("chdir");
+		if (cfg.homedir) {
+			int rv = chdir(cfg.homedir);
+			(void) rv;
+		}
+	}
+
+	if (clearenv())
+		errExit("clearenv");
+	for (i = 0; cmd->envp[i]; i++)
+		putenv(cmd->envp[i]);
+
+	cfg.original_argv = cmd->argv;
+	cfg.original_argc = cmd->argc;
+	cfg.original_program_index = 1;
+	just_run_the_shell = 0;
+	arg_doubledash = 0;
+	arg_appimage = 0;
+}
+
+int agent_reply(int conn, int exited, int value, const struct timespec *start) {
+	AgentReply reply = {
+		.type = (exited) ? AGENT_EXITED : AGENT_STARTED,
+		.value = value,
+		.nsec = nsec_since(start)
+	};
+	return write_all(conn, &reply, sizeof(reply));
+}
+
+//***********************************************
+// agent, running in the sandbox
+//***********************************************
+static void __attribute__((noreturn)) agent_exec(AgentCommand *cmd) {
+	// the signals forwarded by the client might be ignored by the sandbox
+	signal(SIGCHLD, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGHUP, SIG_DFL);
+	signal(SIGQUIT, SIG_DFL);
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigprocmask(SIG_SETMASK, &mask, NULL);
+	prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+
+	// the same steps as the application started by the sandbox
+	agent_apply_command(cmd);
+	arg_debug = 0;
+	arg_quiet = 1;
+	start_application(0, -1, NULL);
+	__builtin_unreachable();
+}
+
+static void __attribute__((noreturn)) agent_handle(int conn) {
+	AgentCommand cmd;
+	if (agent_read_command(conn, &cmd))
+		_exit(1);
+
+	// SIGCHLD is read from a signalfd together with the client messages
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	signal(SIGCHLD, SIG_DFL);
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+	int sfd = signalfd(-1, &mask, SFD_CLOEXEC);
+	if (sfd == -1)
+		errExit("signalfd");
+
+	// the pipe is closed by a successful execve
+	int pfd[2];
+	if (pipe2(pfd, O_CLOEXEC) == -1)
+		errExit("pipe2");
+	pid_t child = fork();
+	if (child == -1)
+		errExit("fork");
+	if (child == 0) {
+		close(pfd[0]);
+		close(conn);
+		close(sfd);
+		agent_exec(&cmd);
+	}
+	close(pfd[1]);
+	int i;
+	for (i = 0; i < 3; i++)
+		close(cmd.fds[i]);
+	char c;
+	while (read(pfd[0], &c, 1) == -1 && errno == EINTR)
+		;
+	close(pfd[0]);
+
+	if (agent_reply(conn, 0, child, &cmd.start))
+		kill(child, SIGKILL);
+
+	while (1) {
+		struct pollfd pfds[2] = {
+			{ .fd = conn, .events = POLLIN },
+			{ .fd = sfd, .events = POLLIN }
+		};
+		if (poll(pfds, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			errExit("poll");
+		}
+
+		if (pfds[1].revents) {
+			struct signalfd_siginfo si;
+			if (read(sfd, &si, sizeof(si)) == -1 && errno != EAGAIN)
+				errExit("read");
+			int status;
+			if (waitpid(child, &status, WNOHANG) == child) {
+				int rv = agent_reply(conn, 1, status, &cmd.start);
+				(void) rv;
+				_exit(0);
+			}
+		}
+		if (pfds[0].revents) {
+			int32_t sig;
+			if (read_all(conn, &sig, sizeof(sig))) {
+				// the client is gone, same as the parent death signal for --join
+				kill(child, SIGKILL);
+				_exit(0);
+			}
+			if (sig > 0 && sig < NSIG)
+				kill(child, sig);
+		}
+	}
+}
+
+static void __attribute__((noreturn)) agent_main(void) {
+	prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+	// the connection handlers are reaped automatically
+	signal(SIGCHLD, SIG_IGN);
+
+	while (1) {
+		int conn = agent_accept(agent_fd);
+		if (conn == -1)
+			continue;
+
+		pid_t pid = fork();
+		if (pid == -1)
+			errExit("fork");
+		if (pid == 0) {
+			close(agent_fd);
+			agent_handle(conn);
+		}
+		close(conn);
+	}
+}
+
+// called by the sandbox right before the application is started
+void agent_start(void) {
+	if (agent_fd == -1)
+		return;
+
+	// the agent runs --join commands, it is subject to the same configuration
+	if (!checkcfg(CFG_JOIN) && getuid() != 0) {
+		fwarning("join feature is disabled in Firejail configuration file, the join agent was not started\n");
+		close(agent_fd);
+		agent_fd = -1;
+		return;
+	}
+
+	pid_t pid = fork();
+	if (pid == -1)
+		errExit("fork");
+	if (pid == 0)
+		agent_main();
+
+	agent_pid = pid;
+	close(agent_fd);
+	agent_fd = -1;
+	if (arg_debug)
+		printf("Join agent started as pid %d\n", agent_pid);
+}
+
+//***********************************************
+// client
+//***********************************************
+static int client_fd = -1;
+static pid_t client_signal_pid = 0;
+static volatile sig_atomic_t client_last_signal = 0;
+
+static void client_signal(int sig) {
+	client_last_signal = sig;
+	if (client_signal_pid > 0)
+		kill(client_signal_pid, sig);
+	else {
+		int32_t val = sig;
+		int rv = write(client_fd, &val, sizeof(val));
+		(void) rv;
+	}
+}
+
+// send argv[index..argc-1] to the socket fname; return the connection, or -1 if
+// there is nobody listening on the socket or the request was not accepted
+int agent_request(const char *fname, int argc, char **argv, int index, int *value, uint64_t *nsec) {
+	EUID_ASSERT();
+	assert(fname);
+	assert(index < argc);
+	struct sockaddr_un addr;
+	socket_address(&addr, fname);
+
+	// the socket has to belong to root
+	struct stat s;
+	if (lstat(fname, &s) == -1 || !S_ISSOCK(s.st_mode) || s.st_uid != 0)
+		return -1;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		errExit("socket");
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+		close(fd);
+		return -1;
+	}
+
+	// request data
+	char *cwd = getcwd(NULL, 0);
+	if (!cwd && !(cwd = strdup("/")))
+		errExit("strdup");
+	size_t len = strlen(cwd) + 1;
+	int i;
+	for (i = index; i < argc; i++)
+		len += strlen(argv[i]) + 1;
+	unsigned envc = 0;
+	for (i = 0; environ[i]; i++, envc++)
+		len += strlen(environ[i]) + 1;
+	if (len > AGENT_MAX_DATA) {
+		free(cwd);
+		close(fd);
+		return -1;
+	}
+
+	char *data = malloc(len);
+	if (!data)
+		errExit("malloc");
+	char *ptr = data;
+	ptr = stpcpy(ptr, cwd) + 1;
+	for (i = index; i < argc; i++)
+		ptr = stpcpy(ptr, argv[i]) + 1;
+	for (i = 0; environ[i]; i++)
+		ptr = stpcpy(ptr, environ[i]) + 1;
+	free(cwd);
+
+	AgentRequest req = {
+		.magic = AGENT_MAGIC,
+		.version = AGENT_VERSION,
+		.argc = argc - index,
+		.envc = envc,
+		.len = len
+	};
+	int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+	char cbuf[CMSG_SPACE(sizeof(fds))];
+	memset(cbuf, 0, sizeof(cbuf));
+	struct iovec iov = { .iov_base = &req, .iov_len = sizeof(req) };
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	AgentReply reply;
+	if (sendmsg(fd, &msg, MSG_NOSIGNAL) != sizeof(req) ||
+	    write_all(fd, data, len) ||
+	    read_all(fd, &reply, sizeof(reply)) ||
+	    reply.type != AGENT_STARTED) {
+		// the connection is closed if the request is not acceptable
+		free(data);
+		close(fd);
+		return -1;
+	}
+	free(data);
+	*value = reply.value;
+	*nsec = reply.nsec;
+	return fd;
+}
+
+// wait for the program started by agent_request() and exit with its status;
+// signals are forwarded through the connection, or to signal_pid if not 0
+void agent_wait(int fd, pid_t signal_pid) {
+	client_fd = fd;
+	client_signal_pid = signal_pid;
+	signal(SIGPIPE, SIG_IGN);
+	int sigs[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGUSR1, SIGUSR2 };
+	int i;
+	for (i = 0; i < (int) (sizeof(sigs) / sizeof(sigs[0])); i++) {
+		struct sigaction sga;
+		memset(&sga, 0, sizeof(sga));
+		sga.sa_handler = client_signal;
+		sga.sa_flags = SA_RESTART;
+		sigaction(sigs[i], &sga, NULL);
+	}
+
+	AgentReply reply;
+	if (read_all(fd, &reply, sizeof(reply)) || reply.type != AGENT_EXITED) {
+		// the sandbox was shut down by the signal
+		if (client_last_signal)
+			exit(128 + client_last_signal);
+		fprintf(stderr, "Error: lost the connection to the sandbox\n");
+		exit(1);
+	}
+
+	int status = reply.value;
+	if (WIFEXITED(status))
+		status = WEXITSTATUS(status);
+	else if (WIFSIGNALED(status))
+		status = 128 + WTERMSIG(status);
+	else
+		status = -1;
+	flush_stdin();
+	exit(status);
+}
+
+// run the command through the agent of the sandbox; returns if the sandbox
+// doesn't have an agent or the agent refused the request
+void agent_join(pid_t pid, int argc, char **argv, int index) {
+	EUID_ASSERT();
+	if (index >= argc)
+		return;	// interactive shells need a controlling terminal, use the regular join
+	if (strcmp(argv[index], "--") == 0 && ++index >= argc)
+		return;
+	if (*argv[index] == '-')
+		return;
+
+	char *fname = agent_socket_name(pid);
+	int value;
+	uint64_t nsec;
+	int fd = agent_request(fname, argc, argv, index, &value, &nsec);
+	free(fname);
+	if (fd == -1)
+		return;
+
+	fmessage("Started pid %d in sandbox %d by the join agent in %.2f ms\n",
+		value, pid, (double) nsec / 1000000);
+	agent_wait(fd, 0);
+}
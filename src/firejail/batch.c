@@ -0,0 +1,586 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "firejail.h"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+// --batch=manifest starts one sandbox for every line in the manifest file. The command
+// line options and the profile are processed once in the parent, which forks a firejail
+// process for every entry right before the network setup in main(). The seccomp filters
+// built by fseccomp and fsec-optimize in the first sandbox are saved in shared memory
+// and copied by the other sandboxes instead of running the helpers again.
+//
+// Manifest format, one sandbox per line:
+//	[profile command; profile command; ... --] program [arguments]
+// Only the profile commands in batch_commands[] are accepted. Program arguments are
+// separated by blanks; single or double quotes group blanks into one argument, there
+// are no escape sequences.
+#define BATCH_CACHE_SIZE (8 * 1024 * 1024)
+#define MAXBUF 4096
+
+static const char *batch_commands[] = {
+	"name ",
+	"hostname ",
+	"net ",
+	"veth-name ",
+	"ip ",
+	"ip6 ",
+	"mac ",
+	"mtu ",
+	"netmask ",
+	"defaultgw ",
+	"dns ",
+	"env ",
+	"cpu ",
+	"nice ",
+	"timeout ",
+	NULL
+};
+
+typedef struct {
+	int lineno;
+	char **settings;	// profile commands, NULL terminated
+	char **argv;		// argv[0] is a placeholder, the program is argv[1]
+	int argc;
+	pid_t pid;
+	int exited;
+	int status;
+} BatchEntry;
+
+// shared between the parent and all sandboxes
+typedef struct {
+	volatile int complete;		// the filters of the first sandbox are in the cache
+	size_t used;			// bytes used in data
+	char data[BATCH_CACHE_SIZE];	// cache entries
+} BatchShared;
+
+// cache entry: BatchRecord, key, then nfiles times (BatchRecord with the name length
+// in keylen and the file size in size, file name, file content)
+typedef struct {
+	uint32_t keylen;
+	uint32_t nfiles;
+	int64_t size;	// -1 if the file was not created
+} BatchRecord;
+
+extern int just_run_the_shell;
+char *arg_batch = NULL;			// manifest file
+int arg_batch_jobs = 0;			// number of sandboxes started in parallel
+static BatchShared *shared = NULL;
+static uint64_t *startup_ns = NULL;	// shared, time from fork to application start
+static int batch_index = -1;		// sandbox: entry index
+static struct timespec batch_fork_time;	// sandbox: time the entry was forked
+
+static uint64_t nsec_since(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) (now.tv_sec - start->tv_sec) * 1000000000ULL + now.tv_nsec - start->tv_nsec;
+}
+
+//***********************************************
+// manifest
+//***********************************************
+// split the program arguments in place
+static char **split_args(char *str, int *count, const char *fname, int lineno) {
+	int n = 0;
+	int max = 8;
+	char **rv = malloc(max * sizeof(char *));
+	if (!rv)
+		errExit("malloc");
+
+	char *src = str;
+	while (1) {
+		while (*src == ' ' || *src == '\t')
+			src++;
+		if (*src == '\0')
+			break;
+		if (n + 2 > max) {
+			max *= 2;
+			rv = realloc(rv, max * sizeof(char *));
+			if (!rv)
+				errExit("realloc");
+		}
+
+		char *dst = src;
+		rv[n++] = dst;
+		char quote = 0;
+		while (*src && (quote || (*src != ' ' && *src != '\t'))) {
+			if (quote && *src == quote)
+				quote = 0;
+			else if (!quote && (*src == '\'' || *src == '"'))
+				quote = *src;
+			else
+				*dst++ = *src;
+			src++;
+		}
+		if (quote) {
+			fprintf(stderr, "Error: %s:%d: unterminated quoted string\n", fname, lineno);
+			exit(1);
+		}
+		if (*src)
+			src++;
+		*dst = '\0';
+	}
+	rv[n] = NULL;
+	*count = n;
+	return rv;
+}
+
+static char **split(char *str, const char *delim) {
+	int n = 0;
+	int max = 8;
+	char **rv = malloc(max * sizeof(char *));
+	if (!rv)
+		errExit("malloc");
+	char *ptr = strtok(str, delim);
+	while (ptr) {
+		if (n + 2 > max) {
+			max *= 2;
+			rv = realloc(rv, max * sizeof(char *));
+			if (!rv)
+				errExit("realloc");
+		}
+		rv[n++] = ptr;
+		ptr = strtok(NULL, delim);
+	}
+	rv[n] = NULL;
+	return rv;
+}
+
+static BatchEntry *batch_read(const char *fname, int *count) {
+	FILE *fp = fopen(fname, "re");
+	if (!fp) {
+		fprintf(stderr, "Error: cannot open batch manifest %s\n", fname);
+		exit(1);
+	}
+
+	BatchEntry *entries = NULL;
+	int n = 0;
+	int lineno = 0;
+	char buf[MAXBUF];
+	while (fgets(buf, MAXBUF, fp)) {
+		lineno++;
+		char *ptr = strchr(buf, '\n');
+		if (ptr)
+			*ptr = '\0';
+		char *line = buf;
+		while (*line == ' ' || *line == '\t')
+			line++;
+		if (*line == '\0' || *line == '#')
+			continue;
+		line = strdup(line);
+		if (!line)
+			errExit("strdup");
+
+		entries = realloc(entries, (n + 1) * sizeof(BatchEntry));
+		if (!entries)
+			errExit("realloc");
+		BatchEntry *e = &entries[n++];
+		memset(e, 0, sizeof(BatchEntry));
+		e->lineno = lineno;
+
+		// settings
+		char *program = line;
+		char *settings = NULL;
+		if (strncmp(line, "-- ", 3) == 0)
+			program = line + 3;
+		else if ((ptr = strstr(line, " -- ")) != NULL) {
+			*ptr = '\0';
+			settings = line;
+			program = ptr + 4;
+		}
+		if (settings) {
+			e->settings = split(settings, ";");
+			char **s;
+			for (s = e->settings; *s; s++) {
+				while (**s == ' ' || **s == '\t')
+					(*s)++;
+				char *end = *s + strlen(*s);
+				while (end > *s && (end[-1] == ' ' || end[-1] == '\t'))
+					*--end = '\0';
+				int i;
+				for (i = 0; batch_commands[i]; i++) {
+					if (strncmp(*s, batch_commands[i], strlen(batch_commands[i])) == 0)
+						break;
+				}
+				if (!batch_commands[i]) {
+					fprintf(stderr, "Error: %s:%d: \"%s\" is not allowed in a batch manifest\n",
+						fname, lineno, *s);
+					exit(1);
+				}
+			}
+		}
+
+		// program, with a placeholder for argv[0]
+		char **argv = split_args(program, &e->argc, fname, lineno);
+		if (e->argc == 0) {
+			fprintf(stderr, "Error: %s:%d: no program specified\n", fname, lineno);
+			exit(1);
+		}
+		e->argv = malloc((e->argc + 2) * sizeof(char *));
+		if (!e->argv)
+			errExit("malloc");
+		e->argv[0] = "firejail";
+		memcpy(e->argv + 1, argv, (e->argc + 1) * sizeof(char *));
+		e->argc++;
+		free(argv);
+	}
+	fclose(fp);
+
+	if (n == 0) {
+		fprintf(stderr, "Error: batch manifest %s is empty\n", fname);
+		exit(1);
+	}
+	*count = n;
+	return entries;
+}
+
+//***********************************************
+// seccomp filter cache, used by sbox_run_v()
+//***********************************************
+static int cached_helper(char * const arg[]) {
+	if (!shared || batch_index == -1)
+		return 0;
+	return strcmp(arg[0], PATH_FSECCOMP) == 0 || strcmp(arg[0], PATH_FSEC_OPTIMIZE) == 0;
+}
+
+static int is_output(const char *arg) {
+	return strncmp(arg, RUN_SECCOMP_DIR "/", strlen(RUN_SECCOMP_DIR) + 1) == 0;
+}
+
+static char *helper_key(char * const arg[]) {
+	size_t len = 1;
+	int i;
+	for (i = 0; arg[i]; i++)
+		len += strlen(arg[i]) + 1;
+	char *key = malloc(len);
+	if (!key)
+		errExit("malloc");
+	char *ptr = key;
+	for (i = 0; arg[i]; i++) {
+		if (i)
+			*ptr++ = ' ';
+		ptr = stpcpy(ptr, arg[i]);
+	}
+	return key;
+}
+
+// replace the helper run by the files saved by the first sandbox; return 1 if found
+int batch_helper_cached(char * const arg[]) {
+	if (!cached_helper(arg) || !shared->complete)
+		return 0;
+
+	char *key = helper_key(arg);
+	uint32_t keylen = strlen(key);
+	size_t offset = 0;
+	while (offset < shared->used) {
+		BatchRecord rec;
+		memcpy(&rec, shared->data + offset, sizeof(rec));
+		offset += sizeof(rec);
+		const char *k = shared->data + offset;
+		offset += rec.keylen;
+
+		int match = (rec.keylen == keylen && memcmp(k, key, keylen) == 0);
+		uint32_t i;
+		for (i = 0; i < rec.nfiles; i++) {
+			BatchRecord frec;
+			memcpy(&frec, shared->data + offset, sizeof(frec));
+			offset += sizeof(frec);
+			char *name = strndup(shared->data + offset, frec.keylen);
+			if (!name)
+				errExit("strndup");
+			offset += frec.keylen;
+			if (match && frec.size >= 0) {
+				int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+				if (fd == -1 || write(fd, shared->data + offset, frec.size) != frec.size) {
+					fprintf(stderr, "Error: cannot write %s\n", name);
+					exit(1);
+				}
+				close(fd);
+			}
+			if (frec.size > 0)
+				offset += frec.size;
+			free(name);
+		}
+		if (match) {
+			if (arg_debug)
+				printf("sbox run: %s, using the filter built by the first sandbox\n", key);
+			free(key);
+			return 1;
+		}
+	}
+	free(key);
+	return 0;
+}
+
+static int append(const void *buf, size_t len) {
+	if (shared->used + len > sizeof(shared->data))
+		return -1;
+	memcpy(shared->data + shared->used, buf, len);
+	shared->used += len;
+	return 0;
+}
+
+// save the files written by the helper; only the first sandbox writes in the cache
+void batch_helper_store(char * const arg[]) {
+	if (!cached_helper(arg) || batch_index != 0 || shared->complete)
+		return;
+
+	size_t start = shared->used;
+	char *key = helper_key(arg);
+	BatchRecord rec = { .keylen = strlen(key), .nfiles = 0, .size = 0 };
+	int i;
+	for (i = 0; arg[i]; i++) {
+		if (is_output(arg[i]))
+			rec.nfiles++;
+	}
+	if (append(&rec, sizeof(rec)) || append(key, rec.keylen))
+		goto full;
+	free(key);
+
+	for (i = 0; arg[i]; i++) {
+		if (!is_output(arg[i]))
+			continue;
+		BatchRecord frec = { .keylen = strlen(arg[i]), .nfiles = 0, .size = -1 };
+		char *data = NULL;
+		int fd = open(arg[i], O_RDONLY | O_CLOEXEC);
+		if (fd != -1) {
+			struct stat s;
+			if (fstat(fd, &s) == -1)
+				errExit("fstat");
+			frec.size = s.st_size;
+			if (s.st_size) {
+				data = malloc(s.st_size);
+				if (!data)
+					errExit("malloc");
+				if (read(fd, data, s.st_size) != s.st_size)
+					errExit("read");
+			}
+			close(fd);
+		}
+		if (append(&frec, sizeof(frec)) || append(arg[i], frec.keylen) ||
+		    (frec.size > 0 && append(data, frec.size))) {
+			free(data);
+			goto full;
+		}
+		free(data);
+	}
+	return;
+
+full:
+	// the other sandboxes run the helper themselves
+	shared->used = start;
+}
+
+//***********************************************
+// sandbox
+//***********************************************
+// called by the sandbox right before the application is started
+void batch_started(void) {
+	if (batch_index == -1)
+		return;
+	startup_ns[batch_index] = nsec_since(&batch_fork_time);
+	if (batch_index == 0)
+		shared->complete = 1;
+}
+
+// configure the entry in the new firejail process
+static void batch_child(BatchEntry *e, int index, const char *fname) {
+	batch_index = index;
+	sandbox_pid = getpid();
+	if (!arg_debug)
+		arg_quiet = 1;
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+
+	char **s;
+	for (s = e->settings; s && *s; s++) {
+		char *line = strdup(*s);	// referenced by cfg after the call
+		if (!line)
+			errExit("strdup");
+		if (profile_check_line(line, e->lineno, fname))
+			profile_add(line);
+	}
+	net_check_cfg();
+
+	extract_command_name(1, e->argv);
+	cfg.original_argv = e->argv;
+	cfg.original_argc = e->argc;
+	build_cmdline(&cfg.command_line, &cfg.window_title, e->argc, e->argv, 1, true);
+	just_run_the_shell = 0;
+}
+
+//***********************************************
+// parent
+//***********************************************
+static volatile sig_atomic_t batch_stop = 0;
+
+static void batch_signal(int sig) {
+	(void) sig;
+	batch_stop = 1;
+}
+
+static pid_t batch_fork(BatchEntry *entries, int index, const char *fname) {
+	clock_gettime(CLOCK_MONOTONIC, &batch_fork_time);
+	pid_t pid = fork();
+	if (pid == -1)
+		errExit("fork");
+	if (pid == 0)
+		batch_child(&entries[index], index, fname);
+	return pid;
+}
+
+static void batch_report(BatchEntry *entries, int count, uint64_t total) {
+	int i;
+	int started = 0;
+	int failed = 0;
+	uint64_t min = UINT64_MAX, max = 0, sum = 0;
+
+	printf("\nBatch startup report\n");
+	for (i = 0; i < count; i++) {
+		BatchEntry *e = &entries[i];
+		printf("  line %d, pid %d, %s: ", e->lineno, e->pid, e->argv[1]);
+		if (startup_ns[i]) {
+			double ms = (double) startup_ns[i] / 1000000;
+			printf("started in %.2f ms, ", ms);
+			started++;
+			sum += startup_ns[i];
+			if (startup_ns[i] < min)
+				min = startup_ns[i];
+			if (startup_ns[i] > max)
+				max = startup_ns[i];
+		}
+		else
+			printf("not started, ");
+		if (e->pid == 0)
+			printf("skipped\n");
+		else
+			printf("exit status %d\n", e->status);
+		if (e->pid == 0 || e->status)
+			failed++;
+	}
+
+	printf("%d sandboxes, %d started, %d failed, %d in parallel\n", count, started, failed, arg_batch_jobs);
+	if (started)
+		printf("Startup time: min %.2f ms, avg %.2f ms, max %.2f ms\n",
+			(double) min / 1000000, (double) sum / started / 1000000, (double) max / 1000000);
+	printf("Total time: %.2f ms\n", (double) total / 1000000);
+}
+
+// run the batch; returns only in the firejail process of a new sandbox
+void batch_main(void) {
+	EUID_ASSERT();
+	assert(arg_batch);
+	if (cfg.original_program_index) {
+		fprintf(stderr, "Error: --batch doesn't take a program, the programs are listed in the manifest\n");
+		exit(1);
+	}
+	if (cfg.name) {
+		fprintf(stderr, "Error: --batch and --name are mutually exclusive, use name in the manifest\n");
+		exit(1);
+	}
+	if (arg_batch_jobs == 0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		arg_batch_jobs = (n > 0) ? n : 1;
+	}
+
+	int count;
+	BatchEntry *entries = batch_read(arg_batch, &count);
+	size_t size = sizeof(BatchShared) + count * sizeof(uint64_t);
+	void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+		errExit("mmap");
+	shared = mem;
+	startup_ns = (uint64_t *) (shared + 1);
+
+	struct sigaction sga;
+	memset(&sga, 0, sizeof(sga));
+	sga.sa_handler = batch_signal;
+	sigaction(SIGINT, &sga, NULL);
+	sigaction(SIGTERM, &sga, NULL);
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	// the first sandbox fills the filter cache
+	entries[0].pid = batch_fork(entries, 0, arg_batch);
+	if (entries[0].pid == 0)
+		return;
+	int running = 1;
+	while (!shared->complete && !batch_stop) {
+		int status;
+		pid_t rv = waitpid(entries[0].pid, &status, WNOHANG);
+		if (rv == entries[0].pid) {
+			entries[0].status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+			entries[0].exited = 1;
+			running = 0;
+			break;
+		}
+		usleep(1000);
+	}
+
+	int next = 1;
+	while (running || next < count) {
+		while (!batch_stop && running < arg_batch_jobs && next < count) {
+			entries[next].pid = batch_fork(entries, next, arg_batch);
+			if (entries[next].pid == 0)
+				return;
+			running++;
+			next++;
+		}
+		if (batch_stop) {
+			int i;
+			for (i = 0; i < next; i++) {
+				if (entries[i].pid && !entries[i].exited)
+					kill(entries[i].pid, SIGTERM);
+			}
+			next = count;
+		}
+		if (!running)
+			break;
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid == -1) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		int i;
+		for (i = 0; i < next; i++) {
+			if (entries[i].pid == pid) {
+				entries[i].status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+				entries[i].exited = 1;
+				running--;
+				break;
+			}
+		}
+	}
+
+	batch_report(entries, count, nsec_since(&start));
+	int i;
+	for (i = 0; i < count; i++) {
+		if (entries[i].pid == 0 || entries[i].status)
+			exit(1);
+	}
+	exit(0);
+}
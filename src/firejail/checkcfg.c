@@ -63,6 +63,8 @@ int checkcfg(int val) {
 		cfg_val[CFG_SECCOMP_LOG] = 0;
 		cfg_val[CFG_PRIVATE_LIB] = 0;
 		cfg_val[CFG_TRACELOG] = 0;
+		cfg_val[CFG_FS_TEMPLATE] = 0;
+		cfg_val[CFG_TMPFS_NOSWAP] = 0;
 
 		// open configuration file
 		const char *fname = SYSCONFDIR "/firejail.config";
@@ -109,6 +111,9 @@ int checkcfg(int val) {
 			PARSE_YESNO(CFG_CHROOT, "chroot")
 			PARSE_YESNO(CFG_FIREJAIL_PROMPT, "firejail-prompt")
 			PARSE_YESNO(CFG_FORCE_NONEWPRIVS, "force-nonewprivs")
+			PARSE_YESNO(CFG_FS_TEMPLATE, "fs-template")
+			PARSE_YESNO(CFG_POOL, "pool")
+			PARSE_YESNO(CFG_TMPFS_NOSWAP, "tmpfs-noswap")
 			PARSE_YESNO(CFG_SECCOMP, "seccomp")
 			PARSE_YESNO(CFG_NETWORK, "network")
 			PARSE_YESNO(CFG_RESTRICTED_NETWORK, "restricted-network")
@@ -121,6 +126,7 @@ int checkcfg(int val) {
 			PARSE_YESNO(CFG_PRIVATE_ETC, "private-etc")
 			PARSE_YESNO(CFG_PRIVATE_HOME, "private-home")
 			PARSE_YESNO(CFG_PRIVATE_LIB, "private-lib")
+			PARSE_YESNO(CFG_PRIVATE_LIB_COPY, "private-lib-copy")
 			PARSE_YESNO(CFG_PRIVATE_OPT, "private-opt")
 			PARSE_YESNO(CFG_PRIVATE_SRV, "private-srv")
 			PARSE_YESNO(CFG_DISABLE_MNT, "disable-mnt")
@@ -267,10 +267,7 @@ void fs_chroot(const char *rootdir) {
 		errExit("chroot");
 
 	// mount a new proc filesystem
-	if (arg_debug)
-		printf("Mounting /proc filesystem representing the PID namespace\n");
-	if (mount("proc", "/proc", "proc", MS_NOSUID | MS_NOEXEC | MS_NODEV | MS_REC, NULL) < 0)
-		errExit("mounting /proc");
+	fs_mount_proc();
 
 	// create all other /run/firejail files and directories
 	preproc_build_firejail_dir();
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include "firejail.h"
+#include "../include/gcov_wrapper.h"
+#include <sys/wait.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#define MAX_CLEANUP_WORKERS 8
+
+static int remove_entry_at(int dirfd, const char *name, unsigned char type);
+
+// remove everything under the directory referenced by fd
+// symbolic links are removed, never followed
+// returns the number of entries that could not be removed
+static int remove_contents(int fd) {
+	int dupfd = dup(fd);
+	if (dupfd == -1)
+		return 1;
+	DIR *dir = fdopendir(dupfd);
+	if (!dir) {
+		close(dupfd);
+		return 1;
+	}
+
+	int errors = 0;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 ||
+		    strcmp(entry->d_name, "..") == 0)
+			continue;
+		errors += remove_entry_at(fd, entry->d_name, entry->d_type);
+	}
+	closedir(dir);
+
+	return errors;
+}
+
+static int remove_entry_at(int dirfd, const char *name, unsigned char type) {
+	// try the cheap case first, unlinkat fails with EISDIR on directories
+	if (type != DT_DIR) {
+		if (unlinkat(dirfd, name, 0) == 0)
+			return 0;
+		if (errno != EISDIR)
+			return 1;
+	}
+
+	int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (fd == -1)
+		return 1;
+	int errors = remove_contents(fd);
+	close(fd);
+
+	if (unlinkat(dirfd, name, AT_REMOVEDIR) == -1)
+		errors++;
+	return errors;
+}
+
+// remove the content of the directory referenced by dirfd; top level entries
+// are distributed over several worker processes
+// returns the number of entries that could not be removed
+int remove_tree_parallel(int dirfd) {
+	int dupfd = dup(dirfd);
+	if (dupfd == -1)
+		errExit("dup");
+	DIR *dir = fdopendir(dupfd);
+	if (!dir)
+		errExit("fdopendir");
+
+	// collect the top level entries
+	size_t cnt = 0;
+	size_t size = 64;
+	char **names = malloc(size * sizeof(char *));
+	unsigned char *types = malloc(size);
+	if (!names || !types)
+		errExit("malloc");
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 ||
+		    strcmp(entry->d_name, "..") == 0)
+			continue;
+		if (cnt == size) {
+			size *= 2;
+			names = realloc(names, size * sizeof(char *));
+			types = realloc(types, size);
+			if (!names || !types)
+				errExit("realloc");
+		}
+		names[cnt] = strdup(entry->d_name);
+		if (!names[cnt])
+			errExit("strdup");
+		types[cnt] = entry->d_type;
+		cnt++;
+	}
+	closedir(dir);
+
+	long workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if (workers > MAX_CLEANUP_WORKERS)
+		workers = MAX_CLEANUP_WORKERS;
+	if (workers > (long) cnt)
+		workers = (long) cnt;
+
+	int errors = 0;
+	size_t i;
+	if (workers <= 1) {
+		for (i = 0; i < cnt; i++)
+			errors += remove_entry_at(dirfd, names[i], types[i]);
+	}
+	else {
+		pid_t pids[MAX_CLEANUP_WORKERS];
+		long w;
+		for (w = 0; w < workers; w++) {
+			pids[w] = fork();
+			if (pids[w] == -1)
+				errExit("fork");
+			if (pids[w] == 0) {
+				int rv = 0;
+				for (i = w; i < cnt; i += workers)
+					rv += remove_entry_at(dirfd, names[i], types[i]);
+				__gcov_flush();
+				_exit(rv ? 1 : 0);
+			}
+		}
+
+		for (w = 0; w < workers; w++) {
+			int status;
+			if (waitpid(pids[w], &status, 0) == -1 ||
+			    !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				errors++;
+		}
+	}
+
+	if (arg_debug)
+		printf("%zu top level entries removed using %ld worker(s), %d error(s)\n",
+		       cnt, (workers > 1) ? workers : 1, errors);
+
+	for (i = 0; i < cnt; i++)
+		free(names[i]);
+	free(names);
+	free(types);
+	return errors;
+}
+
+// start a process detached from the caller: new session, standard streams
+// redirected to /dev/null, and reparented as soon as the caller exits;
+// file descriptors in keep_list are left open in the new process
+// returns 0 in the detached process and 1 in the caller
+int fork_detached(int *keep_list, size_t sz) {
+	pid_t child = fork();
+	if (child == -1)
+		errExit("fork");
+	if (child == 0) {
+		if (setsid() == -1)
+			_exit(1);
+		// a second fork makes sure we never reacquire a controlling terminal,
+		// and allows the caller to reap the intermediate process right away
+		pid_t grandchild = fork();
+		if (grandchild == -1)
+			_exit(1);
+		if (grandchild)
+			_exit(0);
+
+		// callers waiting for EOF on our stdout or stderr should not be kept waiting
+		int fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+		if (fd == -1)
+			_exit(1);
+		if (dup2(fd, STDIN_FILENO) == -1 ||
+		    dup2(fd, STDOUT_FILENO) == -1 ||
+		    dup2(fd, STDERR_FILENO) == -1)
+			_exit(1);
+		close(fd);
+		close_all(keep_list, sz);
+		return 0;
+	}
+
+	waitpid(child, NULL, 0);
+	return 1;
+}
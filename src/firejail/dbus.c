@@ -19,11 +19,14 @@
 */
 #ifdef HAVE_DBUSPROXY
 #include "firejail.h"
+#include "../include/gcov_wrapper.h"
 #include <sys/mount.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/syscall.h>
 #include <errno.h>
+#include <poll.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
@@ -389,17 +392,70 @@ void dbus_proxy_start(void) {
 	}
 }
 
+// wait for a process we cannot reap; pidfd is -1 if pidfd_open is not available
+static void wait_for_exit(pid_t pid, int pidfd) {
+	if (pidfd != -1) {
+		struct pollfd pfd = { .fd = pidfd, .events = POLLIN };
+		while (poll(&pfd, 1, -1) == -1 && errno == EINTR)
+			;
+		return;
+	}
+
+	// poll for up to 5 seconds
+	int i;
+	for (i = 0; i < 500 && kill(pid, 0) == 0; i++)
+		usleep(10000);
+}
+
+static void unlink_socket(const char *path, ino_t ino) {
+	struct stat s;
+	// the file might belong by now to a new sandbox reusing our pid
+	if (path && lstat(path, &s) == 0 && S_ISSOCK(s.st_mode) && s.st_ino == ino)
+		unlink(path);
+}
+
+static ino_t socket_ino(const char *path) {
+	struct stat s;
+	if (path && lstat(path, &s) == 0)
+		return s.st_ino;
+	return 0;
+}
+
+// Closing the status pipe tells xdg-dbus-proxy to shut down. The shutdown is
+// not waited for: a detached process removes the proxy sockets once the proxy
+// is gone, and the proxy itself is reaped after we exit.
 void dbus_proxy_stop(void) {
 	if (dbus_proxy_pid == 0)
 		return;
 	assert(dbus_proxy_status_fd >= 0);
+
+	int pidfd = -1;
+#ifdef SYS_pidfd_open
+	pidfd = syscall(SYS_pidfd_open, dbus_proxy_pid, 0);
+#endif
+	ino_t user_ino = socket_ino(dbus_user_proxy_socket);
+	ino_t system_ino = socket_ino(dbus_system_proxy_socket);
+
 	if (close(dbus_proxy_status_fd) == -1)
 		errExit("close");
-	int status;
-	if (waitpid(dbus_proxy_pid, &status, 0) == -1)
-		errExit("waitpid");
-	if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
-		fwarning("xdg-dbus-proxy returned %s\n", WEXITSTATUS(status));
+
+	if (fork_detached(&pidfd, (pidfd == -1) ? 0 : 1) == 0) {
+		// drop privileges
+		if (setresgid(-1, getgid(), getgid()) != 0)
+			_exit(1);
+		if (setresuid(-1, getuid(), getuid()) != 0)
+			_exit(1);
+
+		wait_for_exit(dbus_proxy_pid, pidfd);
+		unlink_socket(dbus_user_proxy_socket, user_ino);
+		unlink_socket(dbus_system_proxy_socket, system_ino);
+
+		__gcov_flush();
+		_exit(0);
+	}
+
+	if (pidfd != -1)
+		close(pidfd);
 	dbus_proxy_pid = 0;
 	dbus_proxy_status_fd = -1;
 	if (dbus_user_proxy_socket != NULL) {
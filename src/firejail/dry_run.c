@@ -0,0 +1,782 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// --dry-run, --cost: walk the parsed profile the same way the sandbox setup does,
+// and count the operations it would perform. Nothing is mounted or copied; fldd is
+// run to find the libraries for private-lib. The counts are based on the files and
+// mount points present on this host.
+#include "firejail.h"
+#include "../include/seccomp.h"
+#include "../include/syscall.h"
+#include <sys/stat.h>
+#include <fnmatch.h>
+#include <ftw.h>
+#include <glob.h>
+
+typedef enum {
+	SECT_BASE = 0,
+	SECT_PROFILE,
+	SECT_WHITELIST,
+	SECT_HOME,
+	SECT_DEV,
+	SECT_ETC,
+	SECT_BIN,
+	SECT_LIB,
+	SECT_OPT,
+	SECT_SRV,
+	SECT_SECCOMP,
+	SECT_NETWORK,
+	SECT_MAX
+} Section;
+
+static const char * const sect_name[SECT_MAX] = {
+	"base filesystem",
+	"profile",
+	"whitelist",
+	"home",
+	"private-dev",
+	"private-etc",
+	"private-bin",
+	"private-lib",
+	"private-opt",
+	"private-srv",
+	"seccomp",
+	"network",
+};
+
+typedef struct {
+	unsigned mounts;		// mount(2) calls, remounts included
+	unsigned copies;		// files copied
+	unsigned long long bytes;	// bytes copied
+	unsigned helpers;		// sbox_run() invocations
+	unsigned globs;			// glob(3) expansions
+	unsigned syscalls;		// syscalls in seccomp filters
+} Cost;
+
+static Cost cost[SECT_MAX];
+static Section sect = SECT_BASE;
+static MountData *mtab = NULL;
+static size_t mtab_cnt = 0;
+
+static void plan(const char *op, const char *path) {
+	if (arg_dry_run)
+		printf("  %s %s\n", op, path);
+	else if (arg_debug)
+		printf("%s: %s %s\n", sect_name[sect], op, path);
+}
+
+static void plan_mount(const char *op, const char *path) {
+	cost[sect].mounts++;
+	plan(op, path);
+}
+
+static void plan_helper(const char *helper, const char *args) {
+	cost[sect].helpers++;
+	plan(gnu_basename(helper), args);
+}
+
+// tmpfs on path, with the options configured for dir by tmpfs-options
+static void plan_tmpfs(const char *path, const char *dir) {
+	const char *options = tmpfs_options(dir);
+	if (!options) {
+		plan_mount("tmpfs", path);
+		return;
+	}
+
+	char *str;
+	if (asprintf(&str, "%s (%s)", path, options) == -1)
+		errExit("asprintf");
+	plan_mount("tmpfs", str);
+	free(str);
+}
+
+// mount points at or below path; a recursive remount touches each of them
+static unsigned count_mounts(const char *path) {
+	if (!mtab)
+		mtab = get_mount_table(&mtab_cnt);
+
+	size_t len = strlen(path);
+	unsigned rv = 0;
+	size_t i;
+	for (i = 0; i < mtab_cnt; i++) {
+		if (strncmp(mtab[i].dir, path, len) == 0 &&
+		    (mtab[i].dir[len] == '\0' || mtab[i].dir[len] == '/'))
+			rv++;
+	}
+	return rv;
+}
+
+static void plan_remount(const char *op, const char *path) {
+	struct stat s;
+	if (stat(path, &s) == -1)
+		return;
+	unsigned cnt = count_mounts(path);
+	cost[sect].mounts += (cnt)? cnt: 1;
+	plan(op, path);
+}
+
+//***********************************************
+// copies
+//***********************************************
+static int copy_cb(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
+	(void) fpath;
+	(void) ftwbuf;
+	if (typeflag == FTW_F && S_ISREG(sb->st_mode)) {
+		cost[sect].copies++;
+		cost[sect].bytes += sb->st_size;
+	}
+	else if (typeflag == FTW_SL)
+		cost[sect].copies++;
+	return 0;
+}
+
+// one file or directory tree, without a helper if from_template is set
+static void plan_copy(const char *path, int follow_link, int from_template) {
+	struct stat s;
+	if ((follow_link ? stat : lstat)(path, &s) == -1)
+		return;
+	if (!from_template) {
+		cost[sect].helpers++;
+		plan("copy", path);
+	}
+	if (S_ISDIR(s.st_mode))
+		nftw(path, copy_cb, 32, FTW_PHYS);
+	else if (S_ISREG(s.st_mode)) {
+		cost[sect].copies++;
+		cost[sect].bytes += s.st_size;
+	}
+	else
+		cost[sect].copies++;
+}
+
+// comma separated list of globbing patterns relative to dir; with from_template set,
+// only the files generated for the sandbox are copied by fcopy
+static void plan_copy_list(const char *dir, const char *list, int follow_link, int from_template) {
+	char *dlist = strdup(list);
+	if (!dlist)
+		errExit("strdup");
+	char *ptr = strtok(dlist, ",");
+	while (ptr) {
+		char *pattern;
+		if (asprintf(&pattern, "%s/%s", dir, ptr) == -1)
+			errExit("asprintf");
+		glob_t globbuf;
+		cost[sect].globs++;
+		if (glob(pattern, GLOB_NOSORT | GLOB_PERIOD, NULL, &globbuf) == 0) {
+			size_t i;
+			for (i = 0; i < globbuf.gl_pathc; i++) {
+				const char *base = gnu_basename(globbuf.gl_pathv[i]);
+				if (strcmp(base, ".") && strcmp(base, ".."))
+					plan_copy(globbuf.gl_pathv[i], follow_link,
+						from_template && !fs_template_generated(globbuf.gl_pathv[i]));
+			}
+			globfree(&globbuf);
+		}
+		free(pattern);
+		ptr = strtok(NULL, ",");
+	}
+	free(dlist);
+}
+
+//***********************************************
+// filesystem
+//***********************************************
+static void plan_basic_fs(void) {
+	sect = SECT_BASE;
+
+	plan_mount("mount", "/proc");
+	if (cfg.chrootdir) {
+		plan_mount("chroot", cfg.chrootdir);
+		return;
+	}
+#ifdef HAVE_OVERLAYFS
+	if (arg_overlay) {
+		fs_overlayfs_plan(plan_mount);
+		return;
+	}
+#endif
+
+	uid_t uid = getuid();
+	if (!arg_writable_etc) {
+		plan_remount("read-only", "/etc");
+		if (uid)
+			plan_remount("noexec", "/etc");
+	}
+	if (!arg_writable_var) {
+		plan_remount("read-only", "/var");
+		if (uid)
+			plan_remount("noexec", "/var");
+	}
+	static const char * const rodirs[] = {
+		"/usr", "/bin", "/sbin", "/lib", "/lib64", "/lib32", "/libx32", NULL
+	};
+	int i;
+	for (i = 0; rodirs[i]; i++) {
+		if (!is_link(rodirs[i]))
+			plan_remount("read-only", rodirs[i]);
+	}
+
+	// fs_var_*()
+	static const char * const vardirs[] = {
+		"/var/lock", "/var/tmp", "/var/log", "/var/lib/dhcp", "/var/lib/nginx",
+		"/var/lib/snmp", "/var/lib/sudo", "/var/cache/apache2", "/var/cache/lighttpd", NULL
+	};
+	for (i = 0; vardirs[i]; i++) {
+		if (strcmp(vardirs[i], "/var/tmp") == 0 && arg_keep_var_tmp)
+			continue;
+		if (strcmp(vardirs[i], "/var/log") == 0 && arg_writable_var_log)
+			continue;
+		if (is_dir(vardirs[i]) && !is_link(vardirs[i]))
+			plan_mount("tmpfs", vardirs[i]);
+	}
+}
+
+static int noblacklisted(const char *path, char **noblacklist, size_t cnt) {
+	size_t i;
+	for (i = 0; i < cnt; i++) {
+		if (fnmatch(noblacklist[i], path, FNM_PATHNAME) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static void plan_glob(const char *op, const char *pattern, char **noblacklist, size_t cnt) {
+	glob_t globbuf;
+	cost[sect].globs++;
+	if (glob(pattern, GLOB_NOCHECK | GLOB_NOSORT | GLOB_PERIOD, NULL, &globbuf))
+		return;
+
+	size_t i;
+	for (i = 0; i < globbuf.gl_pathc; i++) {
+		const char *path = globbuf.gl_pathv[i];
+		const char *base = gnu_basename(path);
+		struct stat s;
+		if (strcmp(base, ".") == 0 || strcmp(base, "..") == 0 || stat(path, &s) == -1)
+			continue;
+		if (strncmp(op, "blacklist", 9) == 0) {
+			// disable_file() resolves symlinks and never blacklists firejail itself
+			char *fname = realpath(path, NULL);
+			if (fname && strcmp(fname, BINDIR "/firejail") &&
+			    !noblacklisted(path, noblacklist, cnt))
+				plan_mount(op, fname);
+			free(fname);
+		}
+		else if (strcmp(op, "tmpfs") == 0)
+			plan_tmpfs(path, path);
+		else
+			plan_remount(op, path);
+	}
+	globfree(&globbuf);
+}
+
+// same walk as fs_blacklist()
+static void plan_profile(void) {
+	sect = SECT_PROFILE;
+
+	size_t cnt = 0;
+	size_t size = 32;
+	char **noblacklist = malloc(size * sizeof(*noblacklist));
+	if (!noblacklist)
+		errExit("malloc");
+
+	ProfileEntry *entry;
+	for (entry = cfg.profile; entry; entry = entry->next) {
+		const char *op = NULL;
+		const char *ptr = NULL;
+		if (strncmp(entry->data, "noblacklist ", 12) == 0) {
+			if (cnt == size) {
+				size *= 2;
+				noblacklist = realloc(noblacklist, size * sizeof(*noblacklist));
+				if (!noblacklist)
+					errExit("realloc");
+			}
+			noblacklist[cnt++] = expand_macros(entry->data + 12);
+			continue;
+		}
+		else if (strncmp(entry->data, "blacklist ", 10) == 0) {
+			op = "blacklist";
+			ptr = entry->data + 10;
+		}
+		else if (strncmp(entry->data, "blacklist-nolog ", 16) == 0) {
+			op = "blacklist-nolog";
+			ptr = entry->data + 16;
+		}
+		else if (strncmp(entry->data, "read-only ", 10) == 0) {
+			op = "read-only";
+			ptr = entry->data + 10;
+		}
+		else if (strncmp(entry->data, "read-write ", 11) == 0) {
+			op = "read-write";
+			ptr = entry->data + 11;
+		}
+		else if (strncmp(entry->data, "noexec ", 7) == 0) {
+			op = "noexec";
+			ptr = entry->data + 7;
+		}
+		else if (strncmp(entry->data, "tmpfs ", 6) == 0) {
+			op = "tmpfs";
+			ptr = entry->data + 6;
+		}
+		else if (strncmp(entry->data, "bind ", 5) == 0) {
+			plan_mount("bind", entry->data + 5);
+			continue;
+		}
+		else
+			continue;
+
+		char *name = expand_macros(ptr);
+		if (strncmp(name, "${PATH}", 7) == 0) {
+			char **paths = build_paths();
+			int i;
+			for (i = 0; paths[i]; i++) {
+				char *fname;
+				if (asprintf(&fname, "%s%s", paths[i], name + 7) == -1)
+					errExit("asprintf");
+				plan_glob(op, fname, noblacklist, cnt);
+				free(fname);
+			}
+		}
+		else
+			plan_glob(op, name, noblacklist, cnt);
+		free(name);
+	}
+
+	size_t i;
+	for (i = 0; i < cnt; i++)
+		free(noblacklist[i]);
+	free(noblacklist);
+}
+
+// top level directory of a whitelisted path, as used by fs_whitelist()
+static char *whitelist_topdir(const char *path) {
+	size_t len = strlen(cfg.homedir);
+	if (strncmp(path, cfg.homedir, len) == 0 && path[len] == '/')
+		return strdup(cfg.homedir);
+
+	char *runuser;
+	if (asprintf(&runuser, "/run/user/%u", getuid()) == -1)
+		errExit("asprintf");
+	len = strlen(runuser);
+	if (strncmp(path, runuser, len) == 0 && path[len] == '/')
+		return runuser;
+	free(runuser);
+
+	if (strncmp(path, "/sys/module/", 12) == 0)
+		return strdup("/sys/module");
+
+	char *rv = strdup(path);
+	if (!rv)
+		errExit("strdup");
+	char *ptr = strchr(rv + 1, '/');
+	if (ptr)
+		*ptr = '\0';
+	return rv;
+}
+
+static void plan_whitelist_entry(const char *pattern, char ***topdirs, size_t *tcnt) {
+	glob_t globbuf;
+	cost[sect].globs++;
+	if (glob(pattern, GLOB_NOSORT | GLOB_PERIOD, NULL, &globbuf))
+		return;
+
+	size_t i, j;
+	for (i = 0; i < globbuf.gl_pathc; i++) {
+		const char *path = globbuf.gl_pathv[i];
+		char *top = whitelist_topdir(path);
+		for (j = 0; j < *tcnt; j++) {
+			if (strcmp((*topdirs)[j], top) == 0)
+				break;
+		}
+		if (j == *tcnt) {
+			*topdirs = realloc(*topdirs, (*tcnt + 1) * sizeof(char *));
+			if (!*topdirs)
+				errExit("realloc");
+			(*topdirs)[(*tcnt)++] = top;
+			plan_mount("tmpfs", top);
+		}
+		else
+			free(top);
+		if (strcmp(path, (*topdirs)[j]) != 0)
+			plan_mount("whitelist", path);
+	}
+	globfree(&globbuf);
+}
+
+static void plan_whitelist(void) {
+	sect = SECT_WHITELIST;
+	char **topdirs = NULL;
+	size_t tcnt = 0;
+
+	ProfileEntry *entry;
+	for (entry = cfg.profile; entry; entry = entry->next) {
+		if (strncmp(entry->data, "whitelist ", 10) == 0) {
+			char *name = expand_macros(entry->data + 10);
+			plan_whitelist_entry(name, &topdirs, &tcnt);
+			free(name);
+		}
+	}
+
+	// private-tmp is implemented as a whitelist
+	if (arg_private_tmp) {
+		plan_whitelist_entry("/tmp/.X11-unix", &topdirs, &tcnt);
+		plan_whitelist_entry("/tmp/sndio", &topdirs, &tcnt);
+		plan_whitelist_entry("/tmp/pulse-*", &topdirs, &tcnt);
+		int found = 0;
+		size_t i;
+		for (i = 0; i < tcnt; i++)
+			found |= strcmp(topdirs[i], "/tmp") == 0;
+		if (!found)
+			plan_mount("tmpfs", "/tmp");
+	}
+
+	size_t i;
+	for (i = 0; i < tcnt; i++)
+		free(topdirs[i]);
+	free(topdirs);
+}
+
+// same as fs_private_dir_list(): with --fs-template, an up to date template replaces
+// the copies made by fcopy
+static void plan_private_dir(const char *private_dir, const char *private_run_dir, const char *private_list) {
+	int from_template = 0;
+	if (arg_fs_template) {
+		EUID_ROOT();
+		from_template = fs_template_check(private_dir, private_run_dir, private_list);
+		EUID_USER();
+	}
+	if (from_template)
+		plan("template", private_dir);
+	plan_copy_list(private_dir, private_list, 1, from_template);
+	plan_mount("bind", private_dir);
+	plan_mount("tmpfs", private_run_dir);
+}
+
+#ifdef HAVE_PRIVATE_LIB
+// operations reported by fs_private_lib_plan()
+static void plan_lib(const char *op, const char *path) {
+	struct stat s;
+	if (strcmp(op, "fldd") == 0)
+		plan_helper(PATH_FLDD, path);
+	else if (strcmp(op, "copy") == 0) {
+		plan(op, path);
+		if (stat(path, &s) == 0) {
+			cost[sect].copies++;
+			cost[sect].bytes += s.st_size;
+		}
+	}
+	else
+		plan_mount(op, path);
+}
+#endif
+
+static void plan_private(void) {
+	sect = SECT_HOME;
+	uid_t uid = getuid();
+	if (arg_private) {
+		if (cfg.home_private) {
+			plan_mount("bind", cfg.home_private);
+			plan_mount("tmpfs", "/root");
+		}
+		else if (cfg.home_private_keep) {
+			// fs_private_home_list()
+			if (tmpfs_options(cfg.homedir))
+				plan_tmpfs(RUN_HOME_DIR, cfg.homedir);
+			plan_copy_list(cfg.homedir, cfg.home_private_keep, 0, 0);
+			plan_mount("bind", cfg.homedir);
+			if (uid)
+				plan_mount("tmpfs", "/root");
+			else if (!arg_allusers)
+				plan_mount("tmpfs", "/home");
+			plan_mount("tmpfs", RUN_HOME_DIR);
+		}
+		else {
+			// fs_private()
+			plan_tmpfs("/root", (uid == 0)? cfg.homedir: "/root");
+			if (!arg_allusers)
+				plan_tmpfs("/home", (uid != 0 && strncmp(cfg.homedir, "/home/", 6) == 0)? cfg.homedir: "/home");
+		}
+	}
+	if (arg_private_cache) {
+		char *cache;
+		if (asprintf(&cache, "%s/.cache", cfg.homedir) == -1)
+			errExit("asprintf");
+		plan_tmpfs(cache, cache);
+		free(cache);
+	}
+
+	if (arg_private_dev) {
+		sect = SECT_DEV;
+		plan_mount("tmpfs", "/dev");
+		static const char * const devs[] = {
+			"/dev/null", "/dev/zero", "/dev/full", "/dev/random", "/dev/urandom",
+			"/dev/tty", "/dev/pts", "/dev/log", "/dev/snd", "/dev/dri", NULL
+		};
+		int i;
+		for (i = 0; devs[i]; i++) {
+			if (access(devs[i], F_OK) == 0)
+				plan_mount("bind", devs[i]);
+		}
+
+		// process_dev_shm(): the old /dev/shm is kept only for jack sockets
+		glob_t globbuf;
+		cost[sect].globs++;
+		int jack = glob("/dev/shm/jack*", GLOB_NOSORT, NULL, &globbuf) == 0;
+		if (jack)
+			globfree(&globbuf);
+		if (jack || arg_keep_dev_shm)
+			plan_mount("bind", "/dev/shm");
+		else if (tmpfs_options("/dev/shm"))
+			plan_tmpfs("/dev/shm", "/dev/shm");
+	}
+
+	if (cfg.chrootdir || arg_overlay)
+		return;
+
+	if (arg_private_etc && cfg.etc_private_keep) {
+		sect = SECT_ETC;
+		char *list = fs_etc_build(strdup(cfg.etc_private_keep));
+		plan_private_dir("/etc", RUN_ETC_DIR, list);
+		if (access("/usr/etc", F_OK) == 0)
+			plan_private_dir("/usr/etc", RUN_USR_ETC_DIR, list);
+		free(list);
+	}
+
+	if (arg_private_bin && cfg.bin_private_keep) {
+		sect = SECT_BIN;
+		static const char * const paths[] = {
+			"/usr/local/bin", "/usr/bin", "/bin", "/usr/games", "/usr/local/games",
+			"/usr/local/sbin", "/usr/sbin", "/sbin", NULL
+		};
+		char *dlist = strdup(cfg.bin_private_keep);
+		if (!dlist)
+			errExit("strdup");
+		char *ptr = strtok(dlist, ",");
+		while (ptr) {
+			int i;
+			for (i = 0; paths[i]; i++) {
+				if (checkcfg(CFG_PRIVATE_BIN_NO_LOCAL) && strstr(paths[i], "local/"))
+					continue;
+				char *fname;
+				if (asprintf(&fname, "%s/%s", paths[i], ptr) == -1)
+					errExit("asprintf");
+				struct stat s;
+				int found = stat(fname, &s) == 0 && !S_ISDIR(s.st_mode);
+				if (found) {
+					plan_copy(fname, 1, 0);
+					// the programs are added to the private-lib list, see fs_bin.c
+					char *tmp;
+					if (asprintf(&tmp, "%s%s%s,%s", (cfg.bin_private_lib)? cfg.bin_private_lib: "",
+					    (cfg.bin_private_lib)? ",": "", ptr, fname) == -1)
+						errExit("asprintf");
+					free(cfg.bin_private_lib);
+					cfg.bin_private_lib = tmp;
+				}
+				free(fname);
+				if (found)
+					break;
+			}
+			ptr = strtok(NULL, ",");
+		}
+		free(dlist);
+		int i;
+		for (i = 0; paths[i]; i++) {
+			if (is_dir(paths[i]))
+				plan_mount("bind", paths[i]);
+		}
+	}
+
+#ifdef HAVE_PRIVATE_LIB
+	if (arg_private_lib && !arg_appimage) {
+		sect = SECT_LIB;
+		fs_private_lib_plan(plan_lib);
+	}
+#endif
+
+	if (arg_private_opt && cfg.opt_private_keep) {
+		sect = SECT_OPT;
+		plan_private_dir("/opt", RUN_OPT_DIR, cfg.opt_private_keep);
+	}
+
+	if (arg_private_srv && cfg.srv_private_keep) {
+		sect = SECT_SRV;
+		plan_private_dir("/srv", RUN_SRV_DIR, cfg.srv_private_keep);
+	}
+}
+
+//***********************************************
+// seccomp
+//***********************************************
+static void count_syscall(int fd, int syscall, int arg, void *ptrarg, bool native) {
+	(void) fd;
+	(void) syscall;
+	(void) arg;
+	(void) native;
+	(*(unsigned *) ptrarg)++;
+}
+
+static unsigned count_syscalls(const char *list, bool native) {
+	unsigned cnt = 0;
+	if (list && *list)
+		syscall_check_list(list, count_syscall, -1, 0, &cnt, native);
+	return cnt;
+}
+
+static void plan_seccomp(void) {
+	sect = SECT_SECCOMP;
+
+	if (cfg.protocol) {
+		plan_helper(PATH_FSECCOMP, "protocol build");
+		cost[sect].syscalls++;
+	}
+
+	if (arg_seccomp) {
+		if (cfg.seccomp_list_keep) {
+			plan_helper(PATH_FSECCOMP, "keep");
+			cost[sect].syscalls += count_syscalls(cfg.seccomp_list_keep, true);
+		}
+		else if (cfg.seccomp_list_drop) {
+			plan_helper(PATH_FSECCOMP, "drop");
+			plan_helper(PATH_FSEC_OPTIMIZE, "drop filter");
+			cost[sect].syscalls += count_syscalls(cfg.seccomp_list_drop, true);
+		}
+		else {
+			cost[sect].syscalls += count_syscalls(arg_allow_debuggers? "@default": "@default,@default-nodebuggers", true);
+			if ((cfg.seccomp_list && *cfg.seccomp_list) || arg_seccomp_error_action != DEFAULT_SECCOMP_ERROR_ACTION) {
+				plan_helper(PATH_FSECCOMP, "default drop");
+				plan_helper(PATH_FSEC_OPTIMIZE, "default filter");
+				cost[sect].syscalls += count_syscalls(cfg.seccomp_list, true);
+			}
+			else
+				plan("load", "precompiled default filter");
+		}
+	}
+	if (arg_seccomp32) {
+		const char *list = cfg.seccomp_list_keep32? cfg.seccomp_list_keep32: cfg.seccomp_list_drop32;
+		plan_helper(PATH_FSECCOMP, "32 bit filter");
+		if (!cfg.seccomp_list_keep32)
+			plan_helper(PATH_FSEC_OPTIMIZE, "32 bit filter");
+		cost[sect].syscalls += count_syscalls(list, false);
+	}
+	if (arg_memory_deny_write_execute && arg_seccomp_error_action != EPERM) {
+		plan_helper(PATH_FSECCOMP, "memory-deny-write-execute");
+		plan_helper(PATH_FSECCOMP, "memory-deny-write-execute.32");
+	}
+	if (cfg.restrict_namespaces) {
+		plan_helper(PATH_FSECCOMP, "restrict-namespaces");
+		plan_helper(PATH_FSECCOMP, "restrict-namespaces.32");
+	}
+}
+
+//***********************************************
+// network
+//***********************************************
+static void plan_bridge(Bridge *br) {
+	if (!br->configured)
+		return;
+	plan_helper(PATH_FNET_MAIN, (br->macvlan)? "create macvlan": "create veth");
+	if (!br->arg_ip_none && !br->arg_ip_dhcp)
+		plan_helper(PATH_FNET, "config interface");
+	if (br->ip6sandbox)
+		plan_helper(PATH_FNET, "config ipv6");
+	if (br->ip6dad)
+		plan_helper(PATH_FNET, "config dad");
+	if (mac_not_zero(br->macsandbox))
+		plan_helper(PATH_FNET, "config mac");
+	if (br->veth_queues != 0 && net_veth_queues(br) > 1)
+		plan_helper(PATH_FNET, "config offload");
+	if (br->arg_ip_dhcp || br->arg_ip6_dhcp)
+		plan_helper(PATH_FDHCP, br->devsandbox? br->devsandbox: br->dev);
+}
+
+static void plan_network(void) {
+	sect = SECT_NETWORK;
+	if (!any_bridge_configured() && !any_interface_configured() && !arg_nonetwork)
+		return;
+
+	plan_helper(PATH_FNET, "ifup lo");
+	plan_bridge(&cfg.bridge0);
+	plan_bridge(&cfg.bridge1);
+	plan_bridge(&cfg.bridge2);
+	plan_bridge(&cfg.bridge3);
+
+	Interface *ifs[] = { &cfg.interface0, &cfg.interface1, &cfg.interface2, &cfg.interface3 };
+	int i;
+	for (i = 0; i < 4; i++) {
+		if (ifs[i]->configured) {
+			plan_helper(PATH_FNET_MAIN, "moveif");
+			if (ifs[i]->ip)
+				plan_helper(PATH_FNET, "config interface");
+		}
+	}
+
+	if (arg_netfilter) {
+		plan_helper(PATH_FNETFILTER, "ipv4 rules");
+		plan_helper("iptables-restore", "");
+	}
+	if (arg_netfilter6) {
+		plan_helper(PATH_FNETFILTER, "ipv6 rules");
+		plan_helper("ip6tables-restore", "");
+	}
+	if (!arg_quiet && (any_bridge_configured() || any_interface_configured()))
+		plan_helper(PATH_FNET, "printif");
+}
+
+void dry_run(void) {
+	EUID_ASSERT();
+
+	if (arg_dry_run)
+		printf("Planned operations for %s:\n", cfg.command_name);
+
+	plan_basic_fs();
+	plan_private();
+	plan_profile();
+	plan_whitelist();
+	plan_seccomp();
+	plan_network();
+
+	if (arg_dry_run)
+		printf("\n");
+	if (!arg_cost)
+		exit(0);
+
+	// cost table
+	Cost total;
+	memset(&total, 0, sizeof(total));
+	printf("Startup cost estimate for %s:\n", cfg.command_name);
+	printf("  %-16s %7s %7s %12s %8s %6s %9s\n",
+		"", "mounts", "copies", "bytes", "helpers", "globs", "syscalls");
+	int i;
+	for (i = 0; i < SECT_MAX; i++) {
+		Cost *c = &cost[i];
+		if (!c->mounts && !c->copies && !c->helpers && !c->globs && !c->syscalls)
+			continue;
+		printf("  %-16s %7u %7u %12llu %8u %6u %9u\n", sect_name[i],
+			c->mounts, c->copies, c->bytes, c->helpers, c->globs, c->syscalls);
+		total.mounts += c->mounts;
+		total.copies += c->copies;
+		total.bytes += c->bytes;
+		total.helpers += c->helpers;
+		total.globs += c->globs;
+		total.syscalls += c->syscalls;
+	}
+	printf("  %-16s %7u %7u %12llu %8u %6u %9u\n", "total",
+		total.mounts, total.copies, total.bytes, total.helpers, total.globs, total.syscalls);
+	exit(0);
+}
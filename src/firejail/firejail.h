@@ -22,6 +22,7 @@
 #include "../include/common.h"
 #include "../include/euid_common.h"
 #include "../include/rundefs.h"
+#include "../include/message.h"
 #include <linux/limits.h> // Note: Plain limits.h may break ARG_MAX (see #4583)
 #include <stdarg.h>
 #include <sys/stat.h>
@@ -103,12 +104,14 @@ typedef struct bridge_t {
 	int mtu;		// interface mtu
 
 	char *veth_name;	// veth name for the device connected to the bridge
+	int veth_queues;	// --veth-queues: 0 single queue, -1 one queue per sandbox CPU
 
 	// inside the sandbox
 	char *devsandbox;	// name of the device inside the sandbox
 	uint32_t ipsandbox;	// ip address inside the sandbox
 	uint32_t masksandbox;	// network mask inside the sandbox
 	char *ip6sandbox;	// ipv6 address inside the sandbox
+	char *ip6dad;		// IPv6 duplicate address detection: NULL (kernel default), "off", "optimistic"
 	uint8_t macsandbox[6]; // mac address inside the sandbox
 	uint32_t iprange_start;// iprange arp scan start range
 	uint32_t iprange_end;	// iprange arp scan end range
@@ -288,6 +291,8 @@ extern int arg_debug;		// print debug messages
 extern int arg_debug_blacklists;	// print debug messages for blacklists
 extern int arg_debug_whitelists;	// print debug messages for whitelists
 extern int arg_debug_private_lib;	// print debug messages for private-lib
+extern int arg_dry_run;	// print planned operations and exit
+extern int arg_cost;	// print the startup cost estimate and exit
 extern int arg_nonetwork;	// --net=none
 extern int arg_command;	// -c
 extern int arg_overlay;		// overlay option
@@ -309,6 +314,7 @@ extern char *arg_caps_list;		// optional caps list
 
 extern int arg_trace;		// syscall tracing support
 extern char *arg_tracefile;	// syscall tracing file
+extern int arg_trace_fanotify;	// file access tracing using fanotify
 extern int arg_tracelog;	// blacklist tracing support
 extern int arg_rlimit_cpu;	// rlimit cpu
 extern int arg_rlimit_nofile;	// rlimit nofile
@@ -319,6 +325,8 @@ extern int arg_rlimit_as;	//rlimit as
 extern int arg_nogroups;	// disable supplementary groups
 extern int arg_nonewprivs;	// set the NO_NEW_PRIVS prctl
 extern int arg_noroot;		// create a new user namespace and disable root user
+extern int arg_join_agent;	// start the --join agent in the sandbox
+extern int arg_prefetch;	// prefetch the application files during setup
 extern int arg_netfilter;	// enable netfilter
 extern int arg_netfilter6;	// enable netfilter6
 extern char *arg_netfilter_file;	// netfilter file
@@ -335,6 +343,7 @@ extern int arg_private_tmp;	// private tmp directory
 extern int arg_private_lib;	// private lib directory
 extern int arg_private_cwd;	// private working directory
 extern int arg_scan;		// arp-scan all interfaces
+extern unsigned arg_scan_rate;	// arp-scan probes per second, 0 for the default rate
 extern int arg_whitelist;	// whitelist command
 extern int arg_nosound;	// disable sound
 extern int arg_novideo; //disable video devices in /dev
@@ -347,6 +356,7 @@ extern int arg_nice;		// nice value configured
 extern int arg_ipc;		// enable ipc namespace
 extern int arg_writable_etc;	// writable etc
 extern int arg_keep_config_pulse;	// disable automatic ~/.config/pulse init
+extern int arg_fs_template;	// reuse private directories built by a previous sandbox
 extern int arg_keep_shell_rc;	// do not copy shell configuration from /etc/skel
 extern int arg_writable_var;	// writable var
 extern int arg_keep_var_tmp; // don't overwrite /var/tmp
@@ -357,6 +367,7 @@ extern int arg_apparmor;	// apparmor
 extern char *apparmor_profile;	// apparmor profile
 extern bool apparmor_replace; // whether apparmor should replace the profile (legacy behavior)
 extern int arg_allow_debuggers;	// allow debuggers
+extern int arg_proc_subset;	// /proc with process directories only
 extern int arg_x11_block;	// block X11
 extern int arg_x11_xorg;	// use X11 security extension
 extern int arg_allusers;	// all user home directories visible
@@ -409,6 +420,8 @@ void start_application(int no_sandbox, int fd, char *set_sandbox_status) __attri
 
 // network_main.c
 void net_configure_sandbox_ip(Bridge *br);
+#define MAX_VETH_QUEUES 256
+int net_veth_queues(Bridge *br);
 void net_configure_veth_pair(Bridge *br, const char *ifname, pid_t child);
 void net_check_cfg(void);
 void net_dns_print(pid_t pid) __attribute__((noreturn));
@@ -421,6 +434,8 @@ void net_if_up(const char *ifname);
 void net_if_down(const char *ifname);
 void net_if_ip(const char *ifname, uint32_t ip, uint32_t mask, int mtu);
 void net_if_ip6(const char *ifname, const char *addr6);
+void net_if_dad(const char *ifname, const char *mode);
+void net_if_offload(const char *ifname);
 int net_get_if_addr(const char *bridge, uint32_t *ip, uint32_t *mask, uint8_t mac[6], int *mtu);
 int net_add_route(uint32_t dest, uint32_t mask, uint32_t gw);
 uint32_t network_get_defaultgw(void);
@@ -451,6 +466,8 @@ void fs_blacklist(void);
 void fs_tmpfs(const char *dir, unsigned check_owner);
 // remount noexec/nodev/nosuid or read-only or read-write
 void fs_remount(const char *dir, OPERATION op, int rec);
+// mount a new /proc filesystem
+void fs_mount_proc(void);
 // mount /proc and /sys directories
 void fs_proc_sys_dev_boot(void);
 // blacklist firejail configuration and runtime directories
@@ -464,6 +481,7 @@ void fs_mnt(const int enforce);
 // fs_overlayfs.c
 char *fs_check_overlay_dir(const char *subdirname, int allow_reuse);
 void fs_overlayfs(void);
+void fs_overlayfs_plan(void (*cb)(const char *op, const char *path));
 int remove_overlay_directory(void);
 
 // chroot.c
@@ -517,6 +535,11 @@ void process_rootfs_chroot(ProcessHandle process);
 int process_rootfs_stat(ProcessHandle process, const char *fname, struct stat *s);
 int process_rootfs_open(ProcessHandle process, const char *fname);
 
+// join_state.c
+void join_state_save(void);
+int join_state_read(ProcessHandle sandbox, uint64_t *caps, unsigned *display);
+void join_state_load_seccomp(void);
+
 // join.c
 ProcessHandle pin_sandbox_process(pid_t pid);
 void join(pid_t pid, int argc, char **argv, int index) __attribute__((noreturn));
@@ -534,6 +557,67 @@ int arp_check(const char *dev, uint32_t destaddr);
 // assign an IP address using arp scanning
 uint32_t arp_assign(const char *dev, Bridge *br);
 
+// tmpfs_opts.c
+void tmpfs_options_add(const char *arg);
+const char *tmpfs_options(const char *dir);
+char *tmpfs_options_build(const char *dir, const char *defaults);
+void tmpfs_options_err(const char *dir) __attribute__((noreturn));
+void tmpfs_options_check(void);
+
+// agent.c
+typedef struct {
+	char *cwd;
+	char **argv;		// argv[0] is a placeholder, the program is argv[1]
+	int argc;
+	char **envp;
+	int fds[3];		// stdin, stdout and stderr of the client
+	struct timespec start;	// time the request was received
+} AgentCommand;
+extern pid_t agent_pid;
+int agent_listen(const char *fname);
+int agent_accept(int fd);
+void agent_create(void);
+void agent_close(void);
+void agent_delete(pid_t pid);
+int agent_read_command(int conn, AgentCommand *cmd);
+void agent_apply_command(AgentCommand *cmd);
+int agent_reply(int conn, int exited, int value, const struct timespec *start);
+void agent_start(void);
+int agent_request(const char *fname, int argc, char **argv, int index, int *value, uint64_t *nsec);
+void agent_wait(int fd, pid_t signal_pid) __attribute__((noreturn));
+void agent_join(pid_t pid, int argc, char **argv, int index);
+
+// pool.c
+extern char *arg_pool;
+void pool_set(const char *arg);
+void pool_close(void);
+void pool_wait(void);
+void pool_started(void);
+void pool_done(int status);
+void pool_main(void);
+void pool_launch(const char *name, int argc, char **argv, int index) __attribute__((noreturn));
+
+// batch.c
+extern char *arg_batch;
+extern int arg_batch_jobs;
+int batch_helper_cached(char * const arg[]);
+void batch_helper_store(char * const arg[]);
+void batch_started(void);
+void batch_main(void);
+
+// prefetch.c
+extern pid_t prefetch_pid;
+void prefetch_start(void);
+
+// trace_fanotify.c
+extern pid_t trace_fanotify_pid;
+void trace_fanotify_start(void);
+void trace_fanotify_app(pid_t app_pid);
+void trace_fanotify_stop(void);
+
+// dry_run.c
+void dry_run(void) __attribute__((noreturn));
+
 // macros.c
 char *expand_macros(const char *path);
 char *resolve_macro(const char *name);
@@ -545,7 +629,6 @@ int macro_id(const char *name);
 // util.c
 void errLogExit(char* fmt, ...) __attribute__((noreturn));
 void fwarning(char* fmt, ...);
-void fmessage(char* fmt, ...);
 long long unsigned parse_arg_size(char *str);
 int check_can_drop_all_groups();
 void drop_privs(int force_nogroups);
@@ -621,6 +704,7 @@ typedef struct {
 MountData *get_last_mount(void);
 int get_mount_id(int fd);
 char **build_mount_array(const int mountid, const char *path);
+MountData *get_mount_table(size_t *cnt);
 
 // fs_var.c
 void fs_var_log(void);	// mounting /var/log
@@ -658,6 +742,8 @@ void fs_private_home_list(void);
 char *seccomp_check_list(const char *str);
 int seccomp_install_filters(void);
 int seccomp_load(const char *fname);
+struct sock_filter;
+void seccomp_load_prog(const char *name, struct sock_filter *filter, unsigned short entries);
 int seccomp_filter_drop(bool native);
 int seccomp_filter_keep(bool native);
 int seccomp_filter_mdwx(bool native);
@@ -724,6 +810,14 @@ void fs_machineid(void);
 void fs_private_dir_copy(const char *private_dir, const char *private_run_dir, const char *private_list);
 void fs_private_dir_mount(const char *private_dir, const char *private_run_dir);
 void fs_private_dir_list(const char *private_dir, const char *private_run_dir, const char *private_list);
+void fs_private_dir_check_name(const char *fname);
+
+// fs_template.c
+void fs_template_init(void);
+int fs_template_restore(const char *private_dir, const char *private_run_dir, const char *private_list, char **state);
+void fs_template_save(const char *private_dir, const char *private_run_dir, const char *private_list, const char *state);
+int fs_template_generated(const char *path);
+int fs_template_check(const char *private_dir, const char *private_run_dir, const char *private_list);
 
 // no_sandbox.c
 int check_namespace_virt(void);
@@ -762,6 +856,7 @@ void fs_private_bin_list(void);
 int is_firejail_link(const char *fname);
 char *find_in_path(const char *program);
 void fs_private_lib(void);
+void fs_private_lib_plan(void (*cb)(const char *op, const char *path));
 
 // protocol.c
 void protocol_filter_save(void);
@@ -825,6 +920,7 @@ void sandboxfs(int op, pid_t pid, const char *path1, const char *path2) __attrib
 
 // checkcfg.c
 #define DEFAULT_ARP_PROBES 2
+#define DEFAULT_FILE_COPY_LIMIT 500 // MB
 enum {
 	CFG_FILE_TRANSFER = 0,
 	CFG_X11,
@@ -843,6 +939,10 @@ enum {
 	CFG_PRIVATE_ETC,
 	CFG_PRIVATE_HOME,
 	CFG_PRIVATE_LIB,
+	CFG_PRIVATE_LIB_COPY,
+	CFG_FS_TEMPLATE,
+	CFG_POOL,
+	CFG_TMPFS_NOSWAP,
 	CFG_PRIVATE_OPT,
 	CFG_PRIVATE_SRV,
 	CFG_FIREJAIL_PROMPT,
@@ -893,6 +993,7 @@ void build_appimage_cmdline(char **command_line, char **window_title, int argc,
 // programs
 #define PATH_FNET_MAIN (LIBDIR "/firejail/fnet")		// when called from main thread
 #define PATH_FNET (RUN_FIREJAIL_LIB_DIR "/fnet")	// when called from sandbox thread
+#define PATH_FDHCP (RUN_FIREJAIL_LIB_DIR "/fdhcp")	// when called from sandbox thread
 
 #define PATH_FNETFILTER (RUN_FIREJAIL_LIB_DIR "/fnetfilter")
 
@@ -931,6 +1032,10 @@ int sbox_run(unsigned filter, int num, ...);
 int sbox_run_v(unsigned filter, char * const arg[]);
 void sbox_exec_v(unsigned filter, char * const arg[]) __attribute__((noreturn));
 
+// cleanup.c
+int remove_tree_parallel(int dirfd);
+int fork_detached(int *keep_list, size_t sz);
+
 // run_files.c
 void delete_run_files(pid_t pid);
 void delete_bandwidth_run_file(pid_t pid);
@@ -951,9 +1056,7 @@ void dbus_set_system_bus_env(void);
 void dbus_apply_policy(void);
 
 // dhcp.c
-extern pid_t dhclient4_pid;
-extern pid_t dhclient6_pid;
-void dhcp_store_exec(void);
+extern pid_t dhcp_pid;
 void dhcp_start(void);
 
 // selinux.c
@@ -491,9 +491,12 @@ void fs_tmpfs(const char *dir, unsigned check_owner) {
 		exit(1);
 	}
 	// preserve ownership, mode
-	char *options;
-	if (asprintf(&options, "mode=%o,uid=%u,gid=%u", s.st_mode & 07777, s.st_uid, s.st_gid) == -1)
+	char *defaults;
+	if (asprintf(&defaults, "mode=%o,uid=%u,gid=%u", s.st_mode & 07777, s.st_uid, s.st_gid) == -1)
 		errExit("asprintf");
+	// add size, huge pages etc. from tmpfs-options
+	char *options = tmpfs_options_build(dir, defaults);
+	free(defaults);
 	// preserve mount flags, but remove read-only flag
 	struct statvfs buf;
 	if (fstatvfs(fd, &buf) == -1)
@@ -505,7 +508,7 @@ void fs_tmpfs(const char *dir, unsigned check_owner) {
 		errExit("asprintf");
 	EUID_ROOT();
 	if (mount("tmpfs", proc, "tmpfs", flags|MS_NOSUID|MS_NODEV, options) < 0)
-		errExit("mounting tmpfs");
+		tmpfs_options_err(dir);
 	EUID_USER();
 	// check the last mount operation
 	MountData *mdata = get_last_mount();
@@ -715,15 +718,40 @@ void fs_mnt(const int enforce) {
 
 
 // mount /proc and /sys directories
-void fs_proc_sys_dev_boot(void) {
+// mount a new proc filesystem representing the PID namespace
+void fs_mount_proc(void) {
+	if (arg_proc_subset) {
+		// Linux 5.8: only the process directories, processes of other users are not visible
+		if (arg_debug)
+			printf("Mounting /proc filesystem with process directories only\n");
+		if (mount("proc", "/proc", "proc", MS_NOSUID | MS_NOEXEC | MS_NODEV | MS_REC,
+			  "subset=pid,hidepid=invisible") == 0) {
+			fs_logger("mount /proc subset=pid,hidepid=invisible");
+			return;
+		}
+		if (errno != EINVAL)
+			errExit("mounting /proc");
+		fwarning("proc-subset requires Linux 5.8 or newer, mounting a full /proc filesystem\n");
+		arg_proc_subset = 0;
+	}
 
-	// remount /proc/sys readonly
 	if (arg_debug)
-		printf("Mounting read-only /proc/sys\n");
-	if (mount("/proc/sys", "/proc/sys", NULL, MS_BIND | MS_REC, NULL) < 0 ||
-	    mount(NULL, "/proc/sys", NULL, MS_BIND | MS_REMOUNT | MS_RDONLY | MS_NOSUID | MS_NOEXEC | MS_NODEV | MS_REC, NULL) < 0)
-		errExit("mounting /proc/sys");
-	fs_logger("read-only /proc/sys");
+		printf("Mounting /proc filesystem representing the PID namespace\n");
+	if (mount("proc", "/proc", "proc", MS_NOSUID | MS_NOEXEC | MS_NODEV | MS_REC, NULL) < 0)
+		errExit("mounting /proc");
+}
+
+void fs_proc_sys_dev_boot(void) {
+
+	// remount /proc/sys readonly; a subset /proc has no /proc/sys
+	if (!arg_proc_subset) {
+		if (arg_debug)
+			printf("Mounting read-only /proc/sys\n");
+		if (mount("/proc/sys", "/proc/sys", NULL, MS_BIND | MS_REC, NULL) < 0 ||
+		    mount(NULL, "/proc/sys", NULL, MS_BIND | MS_REMOUNT | MS_RDONLY | MS_NOSUID | MS_NOEXEC | MS_NODEV | MS_REC, NULL) < 0)
+			errExit("mounting /proc/sys");
+		fs_logger("read-only /proc/sys");
+	}
 
 	/* Mount a version of /sys that describes the network namespace */
 	if (arg_debug)
@@ -752,28 +780,31 @@ void fs_proc_sys_dev_boot(void) {
 	disable_file(BLACKLIST_FILE, "/sys/kernel/vmcoreinfo");
 	disable_file(BLACKLIST_FILE, "/sys/kernel/uevent_helper");
 
-	// various /proc/sys files
-	disable_file(BLACKLIST_FILE, "/proc/sys/security");
-	disable_file(BLACKLIST_FILE, "/proc/sys/efi/vars");
-	disable_file(BLACKLIST_FILE, "/proc/sys/fs/binfmt_misc");
-	disable_file(BLACKLIST_FILE, "/proc/sys/kernel/core_pattern");
-	disable_file(BLACKLIST_FILE, "/proc/sys/kernel/modprobe");
-	disable_file(BLACKLIST_FILE, "/proc/sysrq-trigger");
-	disable_file(BLACKLIST_FILE, "/proc/sys/kernel/hotplug");
-	disable_file(BLACKLIST_FILE, "/proc/sys/vm/panic_on_oom");
-
-	// various /proc files
-	disable_file(BLACKLIST_FILE, "/proc/irq");
-	disable_file(BLACKLIST_FILE, "/proc/bus");
-	// move /proc/config.gz to disable-common.inc
-	//disable_file(BLACKLIST_FILE, "/proc/config.gz");
-	disable_file(BLACKLIST_FILE, "/proc/sched_debug");
-	disable_file(BLACKLIST_FILE, "/proc/timer_list");
-	disable_file(BLACKLIST_FILE, "/proc/timer_stats");
-	disable_file(BLACKLIST_FILE, "/proc/kcore");
-	disable_file(BLACKLIST_FILE, "/proc/kallsyms");
-	disable_file(BLACKLIST_FILE, "/proc/mem");
-	disable_file(BLACKLIST_FILE, "/proc/kmem");
+	// none of the /proc files below are present in a subset /proc
+	if (!arg_proc_subset) {
+		// various /proc/sys files
+		disable_file(BLACKLIST_FILE, "/proc/sys/security");
+		disable_file(BLACKLIST_FILE, "/proc/sys/efi/vars");
+		disable_file(BLACKLIST_FILE, "/proc/sys/fs/binfmt_misc");
+		disable_file(BLACKLIST_FILE, "/proc/sys/kernel/core_pattern");
+		disable_file(BLACKLIST_FILE, "/proc/sys/kernel/modprobe");
+		disable_file(BLACKLIST_FILE, "/proc/sysrq-trigger");
+		disable_file(BLACKLIST_FILE, "/proc/sys/kernel/hotplug");
+		disable_file(BLACKLIST_FILE, "/proc/sys/vm/panic_on_oom");
+
+		// various /proc files
+		disable_file(BLACKLIST_FILE, "/proc/irq");
+		disable_file(BLACKLIST_FILE, "/proc/bus");
+		// move /proc/config.gz to disable-common.inc
+		//disable_file(BLACKLIST_FILE, "/proc/config.gz");
+		disable_file(BLACKLIST_FILE, "/proc/sched_debug");
+		disable_file(BLACKLIST_FILE, "/proc/timer_list");
+		disable_file(BLACKLIST_FILE, "/proc/timer_stats");
+		disable_file(BLACKLIST_FILE, "/proc/kcore");
+		disable_file(BLACKLIST_FILE, "/proc/kallsyms");
+		disable_file(BLACKLIST_FILE, "/proc/mem");
+		disable_file(BLACKLIST_FILE, "/proc/kmem");
+	}
 
 	// remove kernel symbol information
 	if (!arg_allow_debuggers) {
@@ -819,7 +850,8 @@ void fs_proc_sys_dev_boot(void) {
 	if (getuid() != 0) {
 		// disable /dev/kmsg and /proc/kmsg
 		disable_file(BLACKLIST_FILE, "/dev/kmsg");
-		disable_file(BLACKLIST_FILE, "/proc/kmsg");
+		if (!arg_proc_subset)
+			disable_file(BLACKLIST_FILE, "/proc/kmsg");
 	}
 
 	EUID_ROOT();
@@ -843,6 +875,9 @@ void disable_config(void) {
 	disable_file(BLACKLIST_FILE, RUN_FIREJAIL_NAME_DIR);
 	disable_file(BLACKLIST_FILE, RUN_FIREJAIL_PROFILE_DIR);
 	disable_file(BLACKLIST_FILE, RUN_FIREJAIL_X11_DIR);
+	disable_file(BLACKLIST_FILE, RUN_FIREJAIL_AGENT_DIR);
+	disable_file(BLACKLIST_FILE, RUN_FIREJAIL_POOL_DIR);
+	disable_file(BLACKLIST_FILE, RUN_FIREJAIL_TEMPLATE_DIR);
 	EUID_ROOT();
 }
 
@@ -852,10 +887,7 @@ void fs_basic_fs(void) {
 	uid_t uid = getuid();
 
 	// mount a new proc filesystem
-	if (arg_debug)
-		printf("Mounting /proc filesystem representing the PID namespace\n");
-	if (mount("proc", "/proc", "proc", MS_NOSUID | MS_NOEXEC | MS_NODEV | MS_REC, NULL) < 0)
-		errExit("mounting /proc");
+	fs_mount_proc();
 
 	EUID_USER();
 	if (arg_debug)
@@ -167,9 +167,19 @@ static void create_link(const char *oldpath, const char *newpath) {
 static void empty_dev_shm(void) {
 	// create an empty /dev/shm directory
 	mkdir_attr("/dev/shm", 01777, 0, 0);
-	selinux_relabel_path("/dev/shm", "/dev/shm");
 	fs_logger("mkdir /dev/shm");
-	fs_logger("create /dev/shm");
+
+	// mount a sized tmpfs if tmpfs-options were specified
+	if (tmpfs_options("/dev/shm")) {
+		char *options = tmpfs_options_build("/dev/shm", "mode=1777,gid=0");
+		if (mount("tmpfs", "/dev/shm", "tmpfs", MS_NOSUID | MS_NODEV | MS_STRICTATIME, options) < 0)
+			tmpfs_options_err("/dev/shm");
+		free(options);
+		fs_logger("tmpfs /dev/shm");
+	}
+	else
+		fs_logger("create /dev/shm");
+	selinux_relabel_path("/dev/shm", "/dev/shm");
 }
 
 static void mount_dev_shm(void) {
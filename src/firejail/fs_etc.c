@@ -28,6 +28,7 @@
 #include "../include/etc_groups.h"
 
 static int etc_cnt = 0;
+static int copy_generated_only = 0;	// private directory restored from a template
 
 static void etc_copy_group(char **pptr) {
 	assert(pptr);
@@ -271,7 +272,8 @@ static void duplicate(const char *fname, const char *private_dir, const char *pr
 	if (asprintf(&src,  "%s/%s", private_dir, fname) == -1)
 		errExit("asprintf");
 
-	if (check_dir_or_file(src) == 0) {
+	if (check_dir_or_file(src) == 0 ||
+	    (copy_generated_only && !fs_template_generated(src))) {
 		free(src);
 		return;
 	}
@@ -298,7 +300,7 @@ static void duplicate(const char *fname, const char *private_dir, const char *pr
 	fs_logger2("clone", src);
 }
 
-static void duplicate_globbing(const char *fname, const char *private_dir, const char *private_run_dir) {
+void fs_private_dir_check_name(const char *fname) {
 	assert(fname);
 
 	if (*fname == '~' || *fname == '/' || strstr(fname, "..")) {
@@ -306,6 +308,11 @@ static void duplicate_globbing(const char *fname, const char *private_dir, const
 		exit(1);
 	}
 	invalid_filename(fname, 1); // no globbing
+}
+
+static void duplicate_globbing(const char *fname, const char *private_dir, const char *private_run_dir) {
+	assert(fname);
+	fs_private_dir_check_name(fname);
 
 	char *pattern;
 	if (asprintf(&pattern,  "%s/%s", private_dir, fname) == -1)
@@ -353,6 +360,12 @@ void fs_private_dir_copy(const char *private_dir, const char *private_run_dir, c
 	// copy the list of files in the new etc directory
 	// using a new child process with root privileges
 	if (*private_list != '\0') {
+		// reuse the tree built by a previous sandbox, only the files
+		// generated for this sandbox are copied
+		char *state = NULL;
+		copy_generated_only = arg_fs_template &&
+			fs_template_restore(private_dir, private_run_dir, private_list, &state);
+
 		if (arg_debug)
 			printf("Copying files in the new %s directory:\n", private_dir);
 
@@ -373,6 +386,11 @@ void fs_private_dir_copy(const char *private_dir, const char *private_run_dir, c
 			duplicate_globbing(ptr, private_dir, private_run_dir);
 		free(dlist);
 		fs_logger_print();
+
+		if (state && !copy_generated_only)
+			fs_template_save(private_dir, private_run_dir, private_list, state);
+		free(state);
+		copy_generated_only = 0;
 	}
 }
 
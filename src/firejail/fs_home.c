@@ -376,20 +376,25 @@ void fs_private(void) {
 	int aflag = store_asoundrc();
 
 	EUID_ROOT();
-	// mask /root
+	// mask /root; tmpfs-options apply when it is the home directory
 	if (arg_debug)
 		printf("Mounting a new /root directory\n");
-	if (mount("tmpfs", "/root", "tmpfs", MS_NOSUID | MS_NODEV | MS_NOEXEC | MS_STRICTATIME,  "mode=700,gid=0") < 0)
-		errExit("mounting /root directory");
+	char *options = tmpfs_options_build((u == 0)? homedir: "/root", "mode=700,gid=0");
+	if (mount("tmpfs", "/root", "tmpfs", MS_NOSUID | MS_NODEV | MS_NOEXEC | MS_STRICTATIME, options) < 0)
+		tmpfs_options_err((u == 0)? homedir: "/root");
+	free(options);
 	selinux_relabel_path("/root", "/root");
 	fs_logger("tmpfs /root");
 
-	// mask /home
+	// mask /home; the new home directory is created in this filesystem
 	if (!arg_allusers) {
 		if (arg_debug)
 			printf("Mounting a new /home directory\n");
-		if (mount("tmpfs", "/home", "tmpfs", MS_NOSUID | MS_NODEV | MS_NOEXEC | MS_STRICTATIME,  "mode=755,gid=0") < 0)
-			errExit("mounting /home directory");
+		const char *hdir = (u != 0 && strncmp(homedir, "/home/", 6) == 0)? homedir: "/home";
+		options = tmpfs_options_build(hdir, "mode=755,gid=0");
+		if (mount("tmpfs", "/home", "tmpfs", MS_NOSUID | MS_NODEV | MS_NOEXEC | MS_STRICTATIME, options) < 0)
+			tmpfs_options_err(hdir);
+		free(options);
 		selinux_relabel_path("/home", "/home");
 		fs_logger("tmpfs /home");
 	}
@@ -596,6 +601,17 @@ void fs_private_home_list(void) {
 	EUID_ROOT();
 	// create /run/firejail/mnt/home directory
 	mkdir_attr(RUN_HOME_DIR, 0755, uid, gid);
+	// build the new home in a separate tmpfs if tmpfs-options were specified
+	if (tmpfs_options(homedir)) {
+		char *defaults;
+		if (asprintf(&defaults, "mode=755,uid=%u,gid=%u", uid, gid) == -1)
+			errExit("asprintf");
+		char *options = tmpfs_options_build(homedir, defaults);
+		if (mount("tmpfs", RUN_HOME_DIR, "tmpfs", MS_NOSUID | MS_NODEV | MS_STRICTATIME, options) < 0)
+			tmpfs_options_err(homedir);
+		free(options);
+		free(defaults);
+	}
 	selinux_relabel_path(RUN_HOME_DIR, homedir);
 
 	// save the current log
@@ -26,6 +26,10 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <glob.h>
+#include <sys/sendfile.h>
+#include <dirent.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
 #define MAXBUF 4096
 
 extern void fslib_install_stdc(void);
@@ -90,6 +94,35 @@ char *find_in_path(const char *program) {
 #ifdef HAVE_PRIVATE_LIB
 static int lib_cnt = 0;
 static int dir_cnt = 0;
+static int mount_cnt = 0;
+static unsigned long long copy_size = 0;
+static unsigned long long copy_limit = 0;
+
+// --dry-run: the operations are passed to fslib_plan instead of being performed,
+// and the names installed in RUN_LIB_DIR are tracked in memory
+void (*fslib_plan)(const char *op, const char *path) = NULL;
+static char **planned = NULL;
+static int planned_cnt = 0;
+
+// return 1 if dest was installed already, otherwise add it to the list
+static int plan_installed(const char *dest) {
+	int i;
+	for (i = 0; i < planned_cnt; i++) {
+		if (strcmp(planned[i], dest) == 0)
+			return 1;
+	}
+	planned = realloc(planned, (planned_cnt + 1) * sizeof(char *));
+	if (!planned)
+		errExit("realloc");
+	if (!(planned[planned_cnt++] = strdup(dest)))
+		errExit("strdup");
+	return 0;
+}
+
+// name of the i-th file or directory installed in --dry-run, NULL after the last one
+const char *fslib_planned(int i) {
+	return (i < planned_cnt)? planned[i]: NULL;
+}
 
 static const char *masked_lib_dirs[] = {
 	"/usr/lib64",
@@ -142,6 +175,15 @@ static char *build_dest_name(const char *full_path) {
 static void fslib_mount_dir(const char *full_path) {
 	// create new directory and mount the original on top of it
 	char *dest = build_dest_name(full_path);
+	if (fslib_plan) {
+		if (!plan_installed(dest)) {
+			fslib_plan("bind", full_path);
+			dir_cnt++;
+			mount_cnt++;
+		}
+		free(dest);
+		return;
+	}
 	if (mkdir(dest, 0755) == -1) {
 		if (errno == EEXIST) { // directory has been mounted already, nothing to do
 			free(dest);
@@ -157,19 +199,98 @@ static void fslib_mount_dir(const char *full_path) {
 		errExit("mount bind");
 	free(dest);
 	dir_cnt++;
+	mount_cnt++;
+}
+
+// return 1 if the library can be copied in the tmpfs instead of being mounted
+static int copy_allowed(const struct stat *s) {
+	if (!checkcfg(CFG_PRIVATE_LIB_COPY))
+		return 0;
+
+	if (copy_limit == 0) {
+		// the same limit is used by fcopy in several --private-* options
+		const char *cl = env_get("FIREJAIL_FILE_COPY_LIMIT");
+		copy_limit = ((cl)? strtoull(cl, NULL, 10): DEFAULT_FILE_COPY_LIMIT) * 1024 * 1024;
+	}
+
+	return S_ISREG(s->st_mode) && s->st_uid == 0 &&
+		copy_size + s->st_size <= copy_limit;
+}
+
+// copy the library in the tmpfs instead of mounting it; return 0 if the file was copied
+// the copy is not backed by the host page cache, every sandbox keeps its own pages in RAM
+static int fslib_copy_file(const char *full_path, int dst) {
+	if (!checkcfg(CFG_PRIVATE_LIB_COPY))
+		return -1;
+
+	// if full_path is a symbolic link, open will follow it
+	int src = open(full_path, O_RDONLY|O_CLOEXEC);
+	if (src == -1)
+		return -1;
+	struct stat s;
+	if (fstat(src, &s) == -1 || !copy_allowed(&s)) {
+		close(src);
+		return -1;
+	}
+
+	// in-kernel copy, no user space buffers
+	off_t len = s.st_size;
+	while (len > 0) {
+		ssize_t rv = sendfile(dst, src, NULL, len);
+		if (rv <= 0)
+			break;
+		len -= rv;
+	}
+	close(src);
+	if (len) {
+		if (ftruncate(dst, 0) == -1)
+			errExit("ftruncate");
+		return -1;
+	}
+
+	if (fchmod(dst, s.st_mode & 0755) == -1)
+		errExit("fchmod");
+	copy_size += s.st_size;
+	return 0;
 }
 
 static void fslib_mount_file(const char *full_path) {
-	// create new file and mount the original on top of it
+	// create new file and copy the original or mount it on top
 	char *dest = build_dest_name(full_path);
-	int fd = open(dest, O_RDONLY|O_CREAT|O_EXCL|O_CLOEXEC, S_IRUSR | S_IWUSR);
+	if (fslib_plan) {
+		struct stat s;
+		if (!plan_installed(dest)) {
+			if (stat(full_path, &s) == 0 && copy_allowed(&s)) {
+				fslib_plan("copy", full_path);
+				copy_size += s.st_size;
+			}
+			else {
+				fslib_plan("bind", full_path);
+				mount_cnt++;
+			}
+			lib_cnt++;
+		}
+		free(dest);
+		return;
+	}
+	int fd = open(dest, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, S_IRUSR | S_IWUSR);
 	if (fd == -1) {
-		if (errno == EEXIST) { // file has been mounted already, nothing to do
+		if (errno == EEXIST) { // file has been installed already, nothing to do
 			free(dest);
 			return;
 		}
 		errExit("open");
 	}
+
+	if (fslib_copy_file(full_path, fd) == 0) {
+		close(fd);
+		if (arg_debug || arg_debug_private_lib)
+			printf("    copying %s to %s\n", full_path, dest);
+		selinux_relabel_path(dest, full_path);
+		free(dest);
+		lib_cnt++;
+		return;
+	}
 	close(fd);
 
 	if (arg_debug || arg_debug_private_lib)
@@ -179,6 +300,7 @@ static void fslib_mount_file(const char *full_path) {
 		errExit("mount bind");
 	free(dest);
 	lib_cnt++;
+	mount_cnt++;
 }
 
 void fslib_mount(const char *full_path) {
@@ -197,11 +319,59 @@ void fslib_mount(const char *full_path) {
 		fslib_mount_file(full_path);
 }
 
+// --dry-run: RUN_LIB_FILE and PATH_FLDD exist only in the sandbox, fldd is started
+// from LIBDIR and prints the list on stdout
+static void plan_libs(const char *full_path, unsigned user) {
+	fslib_plan("fldd", full_path);
+
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC) == -1)
+		errExit("pipe2");
+	pid_t child = fork();
+	if (child < 0)
+		errExit("fork");
+	if (child == 0) {
+		if (user)
+			drop_privs(1);
+		if (dup2(fds[1], STDOUT_FILENO) == -1)
+			errExit("dup2");
+		prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
+		execl(LIBDIR "/firejail/fldd", LIBDIR "/firejail/fldd", full_path, NULL);
+		_exit(1);
+	}
+	close(fds[1]);
+
+	FILE *fp = fdopen(fds[0], "r");
+	if (!fp)
+		errExit("fdopen");
+	char buf[MAXBUF];
+	while (fgets(buf, MAXBUF, fp)) {
+		char *ptr = strchr(buf, '\n');
+		if (ptr)
+			*ptr = '\0';
+
+		trim_trailing_slash_or_dot(buf);
+		fslib_mount(buf);
+	}
+	fclose(fp);
+	waitpid(child, NULL, 0);
+}
+
 // requires full path for lib
 // it could be a library or an executable
 // lib is not copied, only libraries used by it
 void fslib_mount_libs(const char *full_path, unsigned user) {
 	assert(full_path);
+	// --dry-run: LIBDIR/firejail is mounted on RUN_FIREJAIL_LIB_DIR only in the sandbox
+	size_t len = strlen(RUN_FIREJAIL_LIB_DIR);
+	if (fslib_plan && strncmp(full_path, RUN_FIREJAIL_LIB_DIR "/", len + 1) == 0) {
+		char *fname;
+		if (asprintf(&fname, "%s/firejail%s", LIBDIR, full_path + len) == -1)
+			errExit("asprintf");
+		fslib_mount_libs(fname, user);
+		free(fname);
+		return;
+	}
 	// if library/executable does not exist or the user does not have read access to it
 	// print a warning and exit the function.
 	if (access(full_path, F_OK)) {
@@ -217,6 +387,10 @@ void fslib_mount_libs(const char *full_path, unsigned user) {
 
 	if (arg_debug || arg_debug_private_lib)
 		printf("    fslib_mount_libs %s\n", full_path);
+	if (fslib_plan) {
+		plan_libs(full_path, user);
+		return;
+	}
 	// create an empty RUN_LIB_FILE and allow the user to write to it
 	unlink(RUN_LIB_FILE);			  // in case is there
 	create_empty_file_as_root(RUN_LIB_FILE, 0644);
@@ -356,23 +530,266 @@ void fslib_install_list(const char *lib_list) {
 	fs_logger_print();
 }
 
+#ifdef __x86_64__
+// glibc ld.so.cache, new format; see elf/dl-cache.h in glibc sources;
+// the flags and the multiarch directory are specific to amd64
+#define LDCACHE_MAGIC "glibc-ld.so.cache1.1"
+#define LDCACHE_FLAGS 0x0303	// FLAG_ELF_LIBC6 | FLAG_X8664_LIB64
+#define LDCACHE_MAX 4096
+
+typedef struct {
+	char magic[sizeof(LDCACHE_MAGIC) - 1];
+	uint32_t nlibs;
+	uint32_t len_strings;
+	uint8_t flags;		// 2 - little endian
+	uint8_t padding[3];
+	uint32_t extension_offset;
+	uint32_t unused[3];
+} LdCacheHeader;
+
+typedef struct {
+	int32_t flags;
+	uint32_t key;		// library name, offset from the start of the file
+	uint32_t value;		// library path, offset from the start of the file
+	uint32_t osversion;
+	uint64_t hwcap;
+} LdCacheEntry;
+
+typedef struct {
+	char *name;
+	char *path;
+} LdCacheLib;
+
+static LdCacheLib ldcache_libs[LDCACHE_MAX];
+static int ldcache_cnt = 0;
+
+// same ordering as _dl_cache_libcmp() in glibc: numbers are compared numerically
+static int ldcache_libcmp(const char *p1, const char *p2) {
+	while (*p1 != '\0') {
+		if (*p1 >= '0' && *p1 <= '9') {
+			if (*p2 >= '0' && *p2 <= '9') {
+				int val1 = *p1++ - '0';
+				int val2 = *p2++ - '0';
+				while (*p1 >= '0' && *p1 <= '9')
+					val1 = val1 * 10 + *p1++ - '0';
+				while (*p2 >= '0' && *p2 <= '9')
+					val2 = val2 * 10 + *p2++ - '0';
+				if (val1 != val2)
+					return val1 - val2;
+			}
+			else
+				return 1;
+		}
+		else if (*p2 >= '0' && *p2 <= '9')
+			return -1;
+		else if (*p1 != *p2)
+			return *p1 - *p2;
+		else {
+			p1++;
+			p2++;
+		}
+	}
+	return *p1 - *p2;
+}
+
+// ld.so runs a binary search on a cache sorted in descending order
+static int ldcache_compare(const void *a, const void *b) {
+	return ldcache_libcmp(((const LdCacheLib *) b)->name, ((const LdCacheLib *) a)->name);
+}
+
+#define LDCACHE_MAX_DEPTH 4
+#define LDCACHE_FILES 1
+#define LDCACHE_DIRS 2
+
+// add the libraries installed in dir; path is the directory as seen from inside the sandbox;
+// directories mounted from the host by fslib_mount_dir() are subdirectories, they are not
+// on the default search path and are listed in the cache the same way ldconfig lists them;
+// the libraries in dir are added before the ones in subdirectories
+static void ldcache_scan(const char *dir, const char *path, int depth, int mode) {
+	DIR *d = opendir(dir);
+	if (!d)
+		return;
+
+	int pass;
+	for (pass = LDCACHE_FILES; pass <= LDCACHE_DIRS; pass <<= 1) {
+		if (!(mode & pass))
+			continue;
+		rewinddir(d);
+
+		struct dirent *entry;
+		while ((entry = readdir(d)) != NULL && ldcache_cnt < LDCACHE_MAX) {
+			if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+				continue;
+
+			char *fname;
+			if (asprintf(&fname, "%s/%s", dir, entry->d_name) == -1)
+				errExit("asprintf");
+			// library names in mounted directories are symbolic links to the real file
+			struct stat s;
+			if (stat(fname, &s) == -1) {
+				free(fname);
+				continue;
+			}
+
+			if (pass == LDCACHE_DIRS) {
+				// the multiarch directory is scanned separately
+				if (S_ISDIR(s.st_mode) && entry->d_type != DT_LNK && depth < LDCACHE_MAX_DEPTH &&
+				    (depth || strcmp(entry->d_name, "x86_64-linux-gnu") != 0)) {
+					char *subpath;
+					if (asprintf(&subpath, "%s/%s", path, entry->d_name) == -1)
+						errExit("asprintf");
+					ldcache_scan(fname, subpath, depth + 1, LDCACHE_FILES | LDCACHE_DIRS);
+					free(subpath);
+				}
+				free(fname);
+				continue;
+			}
+			if (!S_ISREG(s.st_mode) || !strstr(entry->d_name, ".so")) {
+				free(fname);
+				continue;
+			}
+
+			// the first directory scanned wins, same as the default ld.so search order
+			int i;
+			for (i = 0; i < ldcache_cnt; i++) {
+				if (strcmp(ldcache_libs[i].name, entry->d_name) == 0)
+					break;
+			}
+			if (i == ldcache_cnt && is_lib_64(fname)) {
+				ldcache_libs[ldcache_cnt].name = strdup(entry->d_name);
+				if (asprintf(&ldcache_libs[ldcache_cnt].path, "%s/%s", path, entry->d_name) == -1)
+					errExit("asprintf");
+				if (!ldcache_libs[ldcache_cnt].name)
+					errExit("strdup");
+				ldcache_cnt++;
+			}
+			free(fname);
+		}
+	}
+	closedir(d);
+}
+
+// Replace /etc/ld.so.cache with a cache listing only the libraries installed in the sandbox.
+// The host cache points to libraries masked by private-lib, and ld.so tries each of them
+// before falling back to the default directories. ldconfig cannot be used here, private-bin
+// might have removed it, so the cache is written directly.
+static void install_ld_cache(void) {
+	struct stat s;
+	if (lstat("/etc/ld.so.cache", &s) != 0 || !S_ISREG(s.st_mode))
+		return;
+	if (fslib_plan) {
+		if (lib_cnt) {
+			fslib_plan("bind", "/etc/ld.so.cache");
+			fslib_plan("read-only", "/etc/ld.so.cache");
+		}
+		return;
+	}
+
+	// all the masked directories show the same content, use the shortest canonical one
+	const char *base = (is_dir("/usr/lib"))? "/usr/lib": "/lib";
+	char *path;
+	if (asprintf(&path, "%s/x86_64-linux-gnu", base) == -1)
+		errExit("asprintf");
+	ldcache_scan(RUN_LIB_DIR "/x86_64-linux-gnu", path, 0, LDCACHE_FILES);
+	ldcache_scan(RUN_LIB_DIR, base, 0, LDCACHE_FILES);
+	ldcache_scan(RUN_LIB_DIR "/x86_64-linux-gnu", path, 0, LDCACHE_DIRS);
+	ldcache_scan(RUN_LIB_DIR, base, 0, LDCACHE_DIRS);
+	free(path);
+	if (ldcache_cnt == 0)
+		return;
+	qsort(ldcache_libs, ldcache_cnt, sizeof(LdCacheLib), ldcache_compare);
+
+	// string table, placed after the header and the entries
+	uint32_t str_start = sizeof(LdCacheHeader) + ldcache_cnt * sizeof(LdCacheEntry);
+	uint32_t len_strings = 0;
+	int i;
+	for (i = 0; i < ldcache_cnt; i++)
+		len_strings += strlen(ldcache_libs[i].name) + 1 + strlen(ldcache_libs[i].path) + 1;
+
+	size_t size = str_start + len_strings;
+	char *buf = calloc(1, size);
+	if (!buf)
+		errExit("calloc");
+	LdCacheHeader *hdr = (LdCacheHeader *) buf;
+	memcpy(hdr->magic, LDCACHE_MAGIC, sizeof(hdr->magic));
+	hdr->nlibs = ldcache_cnt;
+	hdr->len_strings = len_strings;
+	hdr->flags = 2;
+
+	LdCacheEntry *e = (LdCacheEntry *) (buf + sizeof(LdCacheHeader));
+	uint32_t offset = str_start;
+	for (i = 0; i < ldcache_cnt; i++) {
+		size_t len = strlen(ldcache_libs[i].name) + 1;
+		e[i].flags = LDCACHE_FLAGS;
+		e[i].key = offset;
+		memcpy(buf + offset, ldcache_libs[i].name, len);
+		offset += len;
+
+		len = strlen(ldcache_libs[i].path) + 1;
+		e[i].value = offset;
+		memcpy(buf + offset, ldcache_libs[i].path, len);
+		offset += len;
+
+		free(ldcache_libs[i].name);
+		free(ldcache_libs[i].path);
+	}
+	assert(offset == size);
+
+	create_empty_file_as_root(RUN_LDSO_CACHE, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	int fd = open(RUN_LDSO_CACHE, O_WRONLY|O_CLOEXEC);
+	if (fd == -1)
+		errExit("open");
+	size_t done = 0;
+	while (done < size) {
+		ssize_t rv = write(fd, buf + done, size - done);
+		if (rv <= 0)
+			errExit("write");
+		done += rv;
+	}
+	close(fd);
+	free(buf);
+
+	if (arg_debug || arg_debug_private_lib)
+		printf("Mount-bind a new /etc/ld.so.cache with %d libraries\n", ldcache_cnt);
+	if (mount(RUN_LDSO_CACHE, "/etc/ld.so.cache", NULL, MS_BIND|MS_REC, NULL) < 0)
+		errExit("mount bind /etc/ld.so.cache");
+	fs_remount("/etc/ld.so.cache", MOUNT_READONLY, 0);
+	fs_logger("create /etc/ld.so.cache");
+}
+#endif
+
 static void mount_directories(void) {
-	fs_remount(RUN_LIB_DIR, MOUNT_READONLY, 1); // should be redundant except for RUN_LIB_DIR itself
+	if (fslib_plan)
+		fslib_plan("read-only", RUN_LIB_DIR);
+	else
+		fs_remount(RUN_LIB_DIR, MOUNT_READONLY, 1); // should be redundant except for RUN_LIB_DIR itself
 
 	int i = 0;
 	while (masked_lib_dirs[i]) {
-		if (is_dir(masked_lib_dirs[i])) {
+		if (is_dir(masked_lib_dirs[i]) && fslib_plan) {
+			fslib_plan("bind", masked_lib_dirs[i]);
+			mount_cnt++;
+		}
+		else if (is_dir(masked_lib_dirs[i])) {
 			if (arg_debug || arg_debug_private_lib)
 				printf("Mount-bind %s on top of %s\n", RUN_LIB_DIR, masked_lib_dirs[i]);
 			if (mount(RUN_LIB_DIR, masked_lib_dirs[i], NULL, MS_BIND|MS_REC, NULL) < 0)
 				errExit("mount bind");
 			fs_logger2("tmpfs", masked_lib_dirs[i]);
 			fs_logger2("mount", masked_lib_dirs[i]);
+			mount_cnt++;
 		}
 		i++;
 	}
 
 	// for amd64 only - we'll deal with i386 later
+	if (fslib_plan) {
+		if (is_dir("/lib32"))
+			fslib_plan("blacklist", "/lib32");
+		if (is_dir("/libx32"))
+			fslib_plan("blacklist", "/libx32");
+		return;
+	}
 	if (is_dir("/lib32")) {
 		if (mount(RUN_RO_DIR, "/lib32", "none", MS_BIND, "mode=400,gid=0") < 0)
 			errExit("disable file");
@@ -385,6 +802,17 @@ static void mount_directories(void) {
 	}
 }
 
+static void print_summary(void) {
+	fmessage("Installed %d %s and %d %s using %d %s (%llu KB copied)\n",
+		lib_cnt, (lib_cnt == 1)? "library": "libraries",
+		dir_cnt, (dir_cnt == 1)? "directory": "directories",
+		mount_cnt, (mount_cnt == 1)? "mount": "mounts",
+		copy_size / 1024);
+	if ((arg_debug || arg_debug_private_lib) && copy_size)
+		printf("Copied libraries use %llu KB of RAM, not shared with the host page cache\n",
+			copy_size / 1024);
+}
+
 void fs_private_lib(void) {
 #ifndef __x86_64__
 	fwarning("private-lib feature is currently available only on amd64 platforms\n");
@@ -396,8 +824,10 @@ void fs_private_lib(void) {
 			(cfg.original_program_index > 0)? cfg.original_argv[cfg.original_program_index]: "none", cfg.usershell);
 
 	// create /run/firejail/mnt/lib directory
-	mkdir_attr(RUN_LIB_DIR, 0755, 0, 0);
-	selinux_relabel_path(RUN_LIB_DIR, "/usr/lib");
+	if (!fslib_plan) {
+		mkdir_attr(RUN_LIB_DIR, 0755, 0, 0);
+		selinux_relabel_path(RUN_LIB_DIR, "/usr/lib");
+	}
 
 	// install standard C libraries
 	if (arg_debug || arg_debug_private_lib)
@@ -460,10 +890,33 @@ void fs_private_lib(void) {
 		printf("Installing system libraries\n");
 	fslib_install_system();
 
-	fmessage("Installed %d %s and %d %s\n", lib_cnt, (lib_cnt == 1)? "library": "libraries",
-		dir_cnt, (dir_cnt == 1)? "directory": "directories");
-
 	// mount lib filesystem
 	mount_directories();
+#ifdef __x86_64__
+	install_ld_cache();
+#endif
+
+	print_summary();
+}
+
+// --dry-run: walk the same code as fs_private_lib() and pass the operations to cb;
+// fldd is run for the program and the libraries, nothing is mounted or copied
+void fs_private_lib_plan(void (*cb)(const char *op, const char *path)) {
+	assert(cb);
+	EUID_ASSERT();
+#ifdef __x86_64__
+	fslib_plan = cb;
+	// the timing messages of the real setup are not relevant here
+	int quiet = arg_quiet;
+	arg_quiet = 1;
+	EUID_ROOT();
+	fs_private_lib();
+	EUID_USER();
+	arg_quiet = quiet;
+	fslib_plan = NULL;
+	print_summary();
+#else
+	(void) cb;
+#endif
 }
 #endif
\ No newline at end of file
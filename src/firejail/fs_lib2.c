@@ -23,6 +23,8 @@
 
 extern void fslib_mount_libs(const char *full_path, unsigned user);
 extern void fslib_mount(const char *full_path);
+extern void (*fslib_plan)(const char *op, const char *path);
+extern const char *fslib_planned(int i);
 
 //***************************************************************
 // Standard C library
@@ -110,8 +112,10 @@ void fslib_install_stdc(void) {
 	timetrace_start();
 	struct stat s;
 	if (stat("/lib/x86_64-linux-gnu", &s) == 0) {	// Debian & friends
-		mkdir_attr(RUN_LIB_DIR "/x86_64-linux-gnu", 0755, 0, 0);
-		selinux_relabel_path(RUN_LIB_DIR "/x86_64-linux-gnu", "/lib/x86_64-linux-gnu");
+		if (!fslib_plan) {
+			mkdir_attr(RUN_LIB_DIR "/x86_64-linux-gnu", 0755, 0, 0);
+			selinux_relabel_path(RUN_LIB_DIR "/x86_64-linux-gnu", "/lib/x86_64-linux-gnu");
+		}
 		stdc("/lib/x86_64-linux-gnu");
 	}
 
@@ -161,10 +165,6 @@ void fslib_install_firejail(void) {
 	// bring in firejail directory
 	fdir();
 
-	// bring in dhclient libraries
-	if (any_dhcp())
-		fslib_mount_libs(RUN_MNT_DIR "/dhclient", 1); // parse as user
-
 	// bring in xauth libraries
 	if (arg_x11_xorg)
 		fslib_mount_libs("/usr/bin/xauth", 1); // parse as user
@@ -269,38 +269,62 @@ SysLib syslibs[] = {
 	}
 };
 
-void fslib_install_system(void) {
-	// look for installed libraries
-	DIR *dir = opendir(RUN_LIB_DIR "/x86_64-linux-gnu");
-	if (!dir)
-		dir = opendir(RUN_LIB_DIR);
+static void find_syslib(const char *name) {
+	SysLib *ptr = &syslibs[0];
+	while (ptr->library) {
+		if (ptr->len == 0)
+			ptr->len = strlen(ptr->library);
 
-	if (dir) {
-		struct dirent *entry;
-		while ((entry = readdir(dir)) != NULL) {
-			if (strcmp(entry->d_name, ".") == 0)
-				continue;
-			if (strcmp(entry->d_name, "..") == 0)
-				continue;
+		if (strncmp(name, ptr->library, ptr->len) == 0) {
+			ptr->found = 1;
+			break;
+		}
 
-			SysLib *ptr = &syslibs[0];
-			while (ptr->library) {
-				if (ptr->len == 0)
-					ptr->len = strlen(ptr->library);
+		ptr++;
+	}
+}
 
-				if (strncmp(entry->d_name, ptr->library, ptr->len) == 0) {
-					ptr->found = 1;
-					break;
-				}
+// --dry-run: same as reading the directory, using the names installed so far
+static void find_syslib_planned(void) {
+	const char *libdir = RUN_LIB_DIR "/x86_64-linux-gnu/";
+	size_t len = strlen(libdir);
+	struct stat s;
+	if (stat("/lib/x86_64-linux-gnu", &s) == -1) {
+		libdir = RUN_LIB_DIR "/";
+		len = strlen(libdir);
+	}
 
-				ptr++;
-			}
+	const char *name;
+	int i;
+	for (i = 0; (name = fslib_planned(i)) != NULL; i++) {
+		if (strncmp(name, libdir, len) == 0 && !strchr(name + len, '/'))
+			find_syslib(name + len);
+	}
+}
 
+void fslib_install_system(void) {
+	// look for installed libraries
+	if (fslib_plan)
+		find_syslib_planned();
+	else {
+		DIR *dir = opendir(RUN_LIB_DIR "/x86_64-linux-gnu");
+		if (!dir)
+			dir = opendir(RUN_LIB_DIR);
+
+		if (dir) {
+			struct dirent *entry;
+			while ((entry = readdir(dir)) != NULL) {
+				if (strcmp(entry->d_name, ".") == 0)
+					continue;
+				if (strcmp(entry->d_name, "..") == 0)
+					continue;
+				find_syslib(entry->d_name);
+			}
+			closedir(dir);
 		}
-		closedir(dir);
+		else
+			assert(0);
 	}
-	else
-		assert(0);
 
 	// install required directories
 	SysLib *ptr = &syslibs[0];
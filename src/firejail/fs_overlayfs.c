@@ -23,8 +23,9 @@
 #include "../include/gcov_wrapper.h"
 #include <sys/mount.h>
 #include <sys/wait.h>
-#include <ftw.h>
 #include <errno.h>
+#include <dirent.h>
+#include <sys/statvfs.h>
 
 #include <fcntl.h>
 #ifndef O_PATH
@@ -89,36 +90,335 @@ char *fs_check_overlay_dir(const char *subdirname, int allow_reuse) {
 }
 
 
-// mount overlayfs on top of / directory
-// mounting an overlay and chrooting into it:
+// The overlay is built from one overlayfs mount for each top level directory in /
+// and for each filesystem mounted under them. /proc, /sys, /dev, /run and /tmp stay
+// shared with the host. / itself is not overlaid, it is remounted read-only.
 //
-// Old Ubuntu kernel
-// # cd ~
-// # mkdir -p overlay/root
-// # mkdir -p overlay/diff
-// # mount -t overlayfs -o lowerdir=/,upperdir=/root/overlay/diff overlayfs /root/overlay/root
-// # chroot /root/overlay/root
-// to shutdown, first exit the chroot and then  unmount the overlay
-// # exit
-// # umount /root/overlay/root
+// # mkdir -p /run/o/odiff/usr /run/o/owork/usr
+// # exec 3</usr
+// # mount -t overlay -o lowerdir=/proc/self/fd/3,upperdir=/run/o/odiff/usr,workdir=/run/o/owork/usr overlay /usr
 //
-// Kernels 3.18+
-// # cd ~
-// # mkdir -p overlay/root
-// # mkdir -p overlay/diff
-// # mkdir -p overlay/work
-// # mount -t overlay -o lowerdir=/,upperdir=/root/overlay/diff,workdir=/root/overlay/work overlay /root/overlay/root
-// # cat /etc/mtab | grep overlay
-// /root/overlay /root/overlay/root overlay rw,relatime,lowerdir=/,upperdir=/root/overlay/diff,workdir=/root/overlay/work 0 0
-// # chroot /root/overlay/root
-// to shutdown, first exit the chroot and then  unmount the overlay
-// # exit
-// # umount /root/overlay/root
-
-// to do: fix the code below
+// The lower filesystems are opened before anything is mounted, an overlay on /usr
+// does not hide a filesystem mounted on /usr/local this way. Upper and work
+// directories are passed as file descriptors as well.
+
+static const char * const skip_dirs[] = {
+	"/proc",
+	"/sys",
+	"/dev",
+	"/run",
+	"/tmp",
+	"/lost+found",
+	NULL
+};
+
+// pseudo filesystems are never overlaid
+static const char * const skip_fstypes[] = {
+	"proc",
+	"sysfs",
+	"devtmpfs",
+	"devpts",
+	"mqueue",
+	"cgroup",
+	"cgroup2",
+	"debugfs",
+	"tracefs",
+	"securityfs",
+	"pstore",
+	"bpf",
+	"autofs",
+	"fusectl",
+	"configfs",
+	"binfmt_misc",
+	"hugetlbfs",
+	"efivarfs",
+	"selinuxfs",
+	"rpc_pipefs",
+	"nsfs",
+	NULL
+};
+
+// overlayfs features, most capable first; volatile is used only for tmpfs upper directories
+static const char * const ofeatures[] = {
+	"volatile,redirect_dir=on,metacopy=on",
+	"redirect_dir=on,metacopy=on",
+	"redirect_dir=on",
+	"",
+	NULL
+};
+
+typedef struct {
+	char *dir;	// mount point
+	int fd;		// original filesystem, opened before any overlay is mounted
+	unsigned long flags;	// nosuid, nodev, noexec etc. of the original filesystem
+} OTarget;
+
+static int skip_dir(const char *dir) {
+	int i;
+	for (i = 0; skip_dirs[i]; i++) {
+		size_t len = strlen(skip_dirs[i]);
+		if (strncmp(dir, skip_dirs[i], len) == 0 && (dir[len] == '\0' || dir[len] == '/'))
+			return 1;
+	}
+	return 0;
+}
+
+static int skip_fstype(const char *fstype) {
+	int i;
+	for (i = 0; skip_fstypes[i]; i++) {
+		if (strcmp(fstype, skip_fstypes[i]) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static int otarget_cmp(const void *a, const void *b) {
+	return strcmp(((const OTarget *) a)->dir, ((const OTarget *) b)->dir);
+}
+
+// build the sorted list of directories to overlay; parents sort before children
+static OTarget *list_targets(size_t *cnt) {
+	size_t size = 64;
+	OTarget *rv = malloc(size * sizeof(*rv));
+	if (!rv)
+		errExit("malloc");
+	*cnt = 0;
+
+#define ADD_TARGET(path) \
+	do { \
+		if (*cnt == size) { \
+			size *= 2; \
+			rv = realloc(rv, size * sizeof(*rv)); \
+			if (!rv) \
+				errExit("realloc"); \
+		} \
+		if (!(rv[*cnt].dir = strdup(path))) \
+			errExit("strdup"); \
+		rv[*cnt].flags = 0; \
+		rv[(*cnt)++].fd = -1; \
+	} while (0)
+
+	// top level directories, symbolic links such as /bin -> usr/bin are covered by their target
+	DIR *dir = opendir("/");
+	if (!dir)
+		errExit("opendir");
+	struct dirent *entry;
+	while ((entry = readdir(dir))) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+		char *path;
+		if (asprintf(&path, "/%s", entry->d_name) == -1)
+			errExit("asprintf");
+		struct stat s;
+		if (lstat(path, &s) == 0 && S_ISDIR(s.st_mode) && !skip_dir(path))
+			ADD_TARGET(path);
+		free(path);
+	}
+	closedir(dir);
+
+	// filesystems mounted below them
+	size_t mcnt;
+	MountData *mnt = get_mount_table(&mcnt);
+	size_t i;
+	for (i = 0; i < mcnt; i++) {
+		if (strcmp(mnt[i].dir, "/") != 0 && !skip_fstype(mnt[i].fstype) && !skip_dir(mnt[i].dir))
+			ADD_TARGET(mnt[i].dir);
+		free(mnt[i].fsname);
+		free(mnt[i].dir);
+		free(mnt[i].fstype);
+	}
+	free(mnt);
+#undef ADD_TARGET
+
+	// sort and remove duplicates
+	qsort(rv, *cnt, sizeof(*rv), otarget_cmp);
+	size_t j = 0;
+	for (i = 0; i < *cnt; i++) {
+		if (j && strcmp(rv[j - 1].dir, rv[i].dir) == 0) {
+			free(rv[i].dir);
+			continue;
+		}
+		rv[j++] = rv[i];
+	}
+	*cnt = j;
+	return rv;
+}
+
+// list the directories to overlay and open the original filesystems
+static OTarget *build_targets(size_t *cnt) {
+	OTarget *rv = list_targets(cnt);
+	size_t i;
+	size_t j = 0;
+	for (i = 0; i < *cnt; i++) {
+		rv[i].fd = open(rv[i].dir, O_PATH|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+		if (rv[i].fd == -1) {
+			fwarning("cannot open %s, the directory is not covered by the overlay\n", rv[i].dir);
+			free(rv[i].dir);
+			continue;
+		}
+		// the overlay keeps the restrictions of the original mount, a nosuid
+		// or nodev filesystem mounted by the user stays nosuid and nodev
+		struct statvfs buf;
+		if (fstatvfs(rv[i].fd, &buf) == 0)
+			rv[i].flags = buf.f_flag & (MS_NOSUID|MS_NODEV|MS_NOEXEC|MS_NOATIME|MS_NODIRATIME|MS_RELATIME);
+		else
+			rv[i].flags = MS_NOSUID|MS_NODEV;
+		rv[j++] = rv[i];
+	}
+	*cnt = j;
+	return rv;
+}
+
+// open a directory inside parent, create it if necessary; the directory is owned by root
+static int open_odir(int parent, const char *name, const char *basedir) {
+	if (mkdirat(parent, name, 0755) == -1 && errno != EEXIST) {
+		perror("mkdir");
+		fprintf(stderr, "Error: cannot create overlay directory %s/%s\n", basedir, name);
+		exit(1);
+	}
+	int fd = openat(parent, name, O_PATH|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+	if (fd == -1) {
+		perror("open");
+		fprintf(stderr, "Error: cannot open overlay directory %s/%s\n", basedir, name);
+		exit(1);
+	}
+	struct stat s;
+	if (fstat(fd, &s) == -1)
+		errExit("fstat");
+	if (s.st_uid != 0) {
+		fprintf(stderr, "Error: overlay directory %s/%s is not owned by the root user\n", basedir, name);
+		exit(1);
+	}
+	return fd;
+}
+
+static void mount_overlay(OTarget *t, int diff_fd, int work_fd, const char *basedir, int volatile_ok) {
+	// upper and work directory name, escaped: /usr/local -> usr%2flocal, /a%b -> a%25b
+	const char *src = t->dir + 1;
+	char *name = malloc(strlen(src) * 3 + 1);
+	if (!name)
+		errExit("malloc");
+	char *ptr = name;
+	for (; *src; src++) {
+		if (*src == '/' || *src == '%')
+			ptr += sprintf(ptr, "%%%02x", (unsigned char) *src);
+		else
+			*ptr++ = *src;
+	}
+	*ptr = '\0';
+
+	int upper = open_odir(diff_fd, name, basedir);
+	int work = open_odir(work_fd, name, basedir);
+
+	int i;
+	for (i = 0; ofeatures[i]; i++) {
+		if (!volatile_ok && strncmp(ofeatures[i], "volatile", 8) == 0)
+			continue;
+
+		char *option;
+		if (asprintf(&option, "lowerdir=/proc/self/fd/%d,upperdir=/proc/self/fd/%d,workdir=/proc/self/fd/%d%s%s",
+		    t->fd, upper, work, (*ofeatures[i])? ",": "", ofeatures[i]) == -1)
+			errExit("asprintf");
+		if (arg_debug)
+			printf("Mounting OverlayFS on %s: %s\n", t->dir, option);
+		int rv = mount("overlay", t->dir, "overlay", t->flags, option);
+		free(option);
+		if (rv == 0)
+			break;
+		// features not supported by the kernel, try again with less
+		if (errno != EINVAL || ofeatures[i + 1] == NULL) {
+			fprintf(stderr, "Error: cannot mount OverlayFS on %s: %s\n", t->dir, strerror(errno));
+			exit(1);
+		}
+	}
+	fs_logger2("overlay", t->dir);
+
+	close(upper);
+	close(work);
+	free(name);
+}
+
+// / is not overlaid: the directories shared with the host are made mount points of their own,
+// and / is remounted read-only, top level entries cannot be created or removed on the host
+// shared directories that are not mount points yet; pass NULL to count them
+static int root_binds(const char **dirs) {
+	size_t mcnt;
+	MountData *mnt = get_mount_table(&mcnt);
+	size_t i;
+	int j;
+	int cnt = 0;
+	for (j = 0; skip_dirs[j]; j++) {
+		struct stat s;
+		if (lstat(skip_dirs[j], &s) == -1 || !S_ISDIR(s.st_mode))
+			continue;
+		for (i = 0; i < mcnt; i++) {
+			if (strcmp(mnt[i].dir, skip_dirs[j]) == 0)
+				break;
+		}
+		if (i < mcnt)
+			continue;
+		if (dirs)
+			dirs[cnt] = skip_dirs[j];
+		cnt++;
+	}
+	for (i = 0; i < mcnt; i++) {
+		free(mnt[i].fsname);
+		free(mnt[i].dir);
+		free(mnt[i].fstype);
+	}
+	free(mnt);
+	return cnt;
+}
+
+static void protect_root(void) {
+	const char *dirs[sizeof(skip_dirs) / sizeof(skip_dirs[0])];
+	int cnt = root_binds(dirs);
+	int i;
+	for (i = 0; i < cnt; i++) {
+		if (arg_debug)
+			printf("Mount-bind %s on top of itself\n", dirs[i]);
+		if (mount(dirs[i], dirs[i], NULL, MS_BIND|MS_REC, NULL) < 0)
+			errExit("mount bind");
+	}
+
+	int fd = open("/", O_PATH|O_DIRECTORY|O_CLOEXEC);
+	if (fd == -1)
+		errExit("open");
+	struct statvfs buf;
+	if (fstatvfs(fd, &buf) == -1)
+		errExit("fstatvfs");
+	if (remount_by_fd(fd, buf.f_flag | MS_RDONLY) == -1) {
+		fprintf(stderr, "Error: cannot remount / read-only\n");
+		exit(1);
+	}
+	close(fd);
+	fs_logger("read-only /");
+}
+
 #include <sys/utsname.h>
+// report the mount operations of fs_overlayfs() without mounting anything; used by --dry-run
+void fs_overlayfs_plan(void (*cb)(const char *op, const char *path)) {
+	assert(cb);
+	size_t cnt;
+	OTarget *targets = list_targets(&cnt);
+	size_t i;
+	for (i = 0; i < cnt; i++) {
+		cb("overlay", targets[i].dir);
+		free(targets[i].dir);
+	}
+	free(targets);
+
+	const char *dirs[sizeof(skip_dirs) / sizeof(skip_dirs[0])];
+	int n = root_binds(dirs);
+	int j;
+	for (j = 0; j < n; j++)
+		cb("mount-bind", dirs[j]);
+	cb("read-only", "/");
+}
+
 void fs_overlayfs(void) {
 	struct stat s;
+	timetrace_start();
 
 	// check kernel version
 	struct utsname u;
@@ -134,23 +434,10 @@ void fs_overlayfs(void) {
 
 	if (arg_debug)
 		printf("Linux kernel version %d.%d\n", major, minor);
-	int oldkernel = 0;
-	if (major < 3) {
-		fprintf(stderr, "Error: minimum kernel version required 3.x\n");
+	if (major < 3 || (major == 3 && minor < 18)) {
+		fprintf(stderr, "Error: minimum kernel version required 3.18\n");
 		exit(1);
 	}
-	if (major == 3 && minor < 18)
-		oldkernel = 1;
-
-	// mounting an overlayfs on top of / seems to be broken for kernels > 4.19
-	// we disable overlayfs for now, pending fixing
-	if (major >= 4 &&minor >= 19) {
-		fprintf(stderr, "Error: OverlayFS disabled for Linux kernels 4.19 and newer, pending fixing.\n");
-		exit(1);
-	}
-
-	char *oroot = RUN_OVERLAY_ROOT;
-	mkdir_attr(oroot, 0755, 0, 0);
 
 	// set base for working and diff directories
 	char *basedir = RUN_MNT_DIR;
@@ -203,165 +490,31 @@ void fs_overlayfs(void) {
 
 	// create diff and work directories inside base
 	// no need to check arg_overlay_reuse
-	char *odiff;
-	if (asprintf(&odiff, "%s/odiff", basedir) == -1)
-		errExit("asprintf");
-	// the new directory will be owned by root
-	if (mkdirat(basefd, "odiff", 0755) == -1 && errno != EEXIST) {
-		perror("mkdir");
-		fprintf(stderr, "Error: cannot create overlay directory %s\n", odiff);
-		exit(1);
-	}
-	ASSERT_PERMS(odiff, 0, 0, 0755);
-
-	char *owork;
-	if (asprintf(&owork, "%s/owork", basedir) == -1)
-		errExit("asprintf");
-	// the new directory will be owned by root
-	if (mkdirat(basefd, "owork", 0755) == -1 && errno != EEXIST) {
-		perror("mkdir");
-		fprintf(stderr, "Error: cannot create overlay directory %s\n", owork);
-		exit(1);
-	}
-	ASSERT_PERMS(owork, 0, 0, 0755);
-
-	// mount overlayfs
-	if (arg_debug)
-		printf("Mounting OverlayFS\n");
-	char *option;
-	if (oldkernel) { // old Ubuntu/OpenSUSE kernels
-		if (arg_overlay_keep) {
-			fprintf(stderr, "Error: option --overlay= not available for kernels older than 3.18\n");
-			exit(1);
-		}
-		if (asprintf(&option, "lowerdir=/,upperdir=%s", odiff) == -1)
-			errExit("asprintf");
-		if (mount("overlayfs", oroot, "overlayfs", MS_MGC_VAL, option) < 0)
-			errExit("mounting overlayfs");
-	}
-	else { // kernel 3.18 or newer
-		if (asprintf(&option, "lowerdir=/,upperdir=%s,workdir=%s", odiff, owork) == -1)
-			errExit("asprintf");
-		if (mount("overlay", oroot, "overlay", MS_MGC_VAL, option) < 0) {
-			fprintf(stderr, "Debug: running on kernel version %d.%d\n", major, minor);
-			errExit("mounting overlayfs");
-		}
-
-		//***************************
-		// issue #263 start code
-		// My setup has a separate mount point for /home. When the overlay is mounted,
-		// the overlay does not contain the original /home contents.
-		// I added code to create a second overlay for /home if the overlay home dir is empty and this seems to work
-		// @dshmgh, Jan 2016
-		{
-			char *overlayhome;
-			struct stat s;
-			char *hroot;
-			char *hdiff;
-			char *hwork;
-
-			// dons add debug
-			if (arg_debug) printf ("DEBUG: chroot dirs are oroot %s  odiff %s  owork %s\n",oroot,odiff,owork);
-
-			// BEFORE NEXT, WE NEED TO TEST IF /home has any contents or do we need to mount it?
-			// must create var for oroot/cfg.homedir
-			if (asprintf(&overlayhome, "%s%s", oroot, cfg.homedir) == -1)
-				errExit("asprintf");
-			if (arg_debug) printf ("DEBUG: overlayhome var holds ##%s##\n", overlayhome);
-
-			// if no homedir in overlay -- create another overlay for /home
-			if (stat(cfg.homedir, &s) == 0 && stat(overlayhome, &s) == -1) {
-
-				// no need to check arg_overlay_reuse
-				if (asprintf(&hdiff, "%s/hdiff", basedir) == -1)
-					errExit("asprintf");
-				// the new directory will be owned by root
-				if (mkdirat(basefd, "hdiff", 0755) == -1 && errno != EEXIST) {
-					perror("mkdir");
-					fprintf(stderr, "Error: cannot create overlay directory %s\n", hdiff);
-					exit(1);
-				}
-				ASSERT_PERMS(hdiff, 0, 0, 0755);
-
-				// no need to check arg_overlay_reuse
-				if (asprintf(&hwork, "%s/hwork", basedir) == -1)
-					errExit("asprintf");
-				// the new directory will be owned by root
-				if (mkdirat(basefd, "hwork", 0755) == -1 && errno != EEXIST) {
-					perror("mkdir");
-					fprintf(stderr, "Error: cannot create overlay directory %s\n", hwork);
-					exit(1);
-				}
-				ASSERT_PERMS(hwork, 0, 0, 0755);
-
-				// no homedir in overlay so now mount another overlay for /home
-				if (asprintf(&hroot, "%s/home", oroot) == -1)
-					errExit("asprintf");
-				if (asprintf(&option, "lowerdir=/home,upperdir=%s,workdir=%s", hdiff, hwork) == -1)
-					errExit("asprintf");
-				if (mount("overlay", hroot, "overlay", MS_MGC_VAL, option) < 0)
-					errExit("mounting overlayfs for mounted home directory");
-
-				printf("OverlayFS for /home configured in %s directory\n", basedir);
-				free(hroot);
-				free(hdiff);
-				free(hwork);
-
-			} // stat(overlayhome)
-			free(overlayhome);
-		}
-		// issue #263 end code
-		//***************************
-	}
-	fmessage("OverlayFS configured in %s directory\n", basedir);
+	int diff_fd = open_odir(basefd, "odiff", basedir);
+	int work_fd = open_odir(basefd, "owork", basedir);
 	close(basefd);
 
-	// /dev, /run and /tmp are not covered by the overlay
-	// mount-bind dev directory
-	if (arg_debug)
-		printf("Mounting /dev\n");
-	char *dev;
-	if (asprintf(&dev, "%s/dev", oroot) == -1)
-		errExit("asprintf");
-	if (mount("/dev", dev, NULL, MS_BIND|MS_REC, NULL) < 0)
-		errExit("mounting /dev");
-	fs_logger("whitelist /dev");
-
-	// mount-bind run directory
-	if (arg_debug)
-		printf("Mounting /run\n");
-	char *run;
-	if (asprintf(&run, "%s/run", oroot) == -1)
-		errExit("asprintf");
-	if (mount("/run", run, NULL, MS_BIND|MS_REC, NULL) < 0)
-		errExit("mounting /run");
-	fs_logger("whitelist /run");
-
-	// mount-bind tmp directory
-	if (arg_debug)
-		printf("Mounting /tmp\n");
-	char *tmp;
-	if (asprintf(&tmp, "%s/tmp", oroot) == -1)
-		errExit("asprintf");
-	if (mount("/tmp", tmp, NULL, MS_BIND|MS_REC, NULL) < 0)
-		errExit("mounting /tmp");
-	fs_logger("whitelist /tmp");
-
-	// chroot in the new filesystem
-	__gcov_flush();
-
-	if (chroot(oroot) == -1)
-		errExit("chroot");
-
 	// mount a new proc filesystem
-	if (arg_debug)
-		printf("Mounting /proc filesystem representing the PID namespace\n");
-	if (mount("proc", "/proc", "proc", MS_NOSUID | MS_NOEXEC | MS_NODEV | MS_REC, NULL) < 0)
-		errExit("mounting /proc");
+	fs_mount_proc();
+
+	// mount overlayfs; nothing is synced to disk for an overlay discarded on exit
+	size_t cnt;
+	OTarget *targets = build_targets(&cnt);
+	size_t i;
+	for (i = 0; i < cnt; i++)
+		mount_overlay(&targets[i], diff_fd, work_fd, basedir, !arg_overlay_keep);
+	for (i = 0; i < cnt; i++) {
+		close(targets[i].fd);
+		free(targets[i].dir);
+	}
+	free(targets);
+	close(diff_fd);
+	close(work_fd);
+	protect_root();
+	fmessage("OverlayFS configured in %s directory, %zu %s in %0.2f ms\n", basedir,
+		cnt, (cnt == 1)? "mount": "mounts", timetrace_end());
 
 	// update /var directory in order to support multiple sandboxes running on the same root directory
-//	if (!arg_private_dev)
-//		fs_dev_shm();
 	fs_var_lock();
 	if (!arg_keep_var_tmp)
 		fs_var_tmp();
@@ -378,37 +531,11 @@ void fs_overlayfs(void) {
 	// when starting as root, firejail config is not disabled;
 	if (getuid() != 0)
 		disable_config();
-
-	// cleanup and exit
-	free(option);
-	free(odiff);
-	free(owork);
-	free(dev);
-	free(run);
-	free(tmp);
 }
 
 
-static int remove_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
-	(void) sb;
-	(void) typeflag;
-	(void) ftwbuf;
-	assert(fpath);
-
-	if (strcmp(fpath, ".") == 0)	// rmdir would fail with EINVAL
-		return 0;
-
-	if (remove(fpath)) {	// removes the link not the actual file
-		fprintf(stderr, "Error: cannot remove file: %s\n", strerror(errno));
-		exit(1);
-	}
-
-	return 0;
-}
-
 int remove_overlay_directory(void) {
 	EUID_ASSERT();
-	sleep(1);
 
 	char *path;
 	if (asprintf(&path, "%s/.firejail", cfg.homedir) == -1)
@@ -420,9 +547,12 @@ int remove_overlay_directory(void) {
 			errExit("fork");
 		if (child == 0) {
 			// open ~/.firejail
-			int fd = safer_openat(-1, path, O_PATH|O_NOFOLLOW|O_CLOEXEC);
+			int fd = safer_openat(-1, path, O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
 			if (fd == -1) {
-				fprintf(stderr, "Error: cannot open %s\n", path);
+				if (errno == ELOOP || errno == ENOTDIR)
+					fprintf(stderr, "Error: %s is not a directory\n", path);
+				else
+					fprintf(stderr, "Error: cannot open %s\n", path);
 				exit(1);
 			}
 			struct stat s;
@@ -439,15 +569,14 @@ int remove_overlay_directory(void) {
 				fprintf(stderr, "Error: %s is not owned by the current user\n", path);
 				exit(1);
 			}
-			// chdir to ~/.firejail
-			if (fchdir(fd) == -1)
-				errExit("fchdir");
-			close(fd);
 
 			EUID_ROOT();
-			// FTW_PHYS - do not follow symbolic links
-			if (nftw(".", remove_callback, 64, FTW_DEPTH | FTW_PHYS) == -1)
-				errExit("nftw");
+			// symbolic links are removed, not followed
+			if (remove_tree_parallel(fd)) {
+				fprintf(stderr, "Error: cannot remove all files in %s\n", path);
+				exit(1);
+			}
+			close(fd);
 
 			EUID_USER();
 			// remove ~/.firejail
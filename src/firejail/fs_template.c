@@ -0,0 +1,706 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Filesystem templates
+//
+// A private directory (private-etc, private-opt, private-srv) is built by running
+// fcopy once for every entry in the keep list. The result is identical from one
+// launch to the next as long as the list and the source files are unchanged.
+// With --fs-template the finished tree is saved in a root-only directory under
+// /run/firejail/template, together with a hash of the source file metadata.
+// The next launch verifies the hash and copies the saved tree in one pass,
+// without starting any helper process. Files generated for the sandbox itself
+// are still copied by fcopy on every launch.
+//
+// Layout: RUN_FIREJAIL_TEMPLATE_DIR/<uid>/<dir>-<list hash>/{state,generated,tree}
+//
+// Every user keeps at most TEMPLATE_MAX_SLOTS templates; the slot mtime is
+// updated on each use, and the least recently used slot is removed first.
+
+#include "firejail.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <glob.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+#define TEMPLATE_MAX_SIZE (16 * 1024 * 1024)	// don't keep large trees such as /opt in memory
+#define TEMPLATE_MAX_DEPTH 64
+#define TEMPLATE_MAX_SLOTS 8
+
+// FNV-1a
+static uint64_t hash_bytes(uint64_t h, const void *buf, size_t len) {
+	const unsigned char *p = buf;
+	size_t i;
+	for (i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static uint64_t hash_str(uint64_t h, const char *str) {
+	return hash_bytes(h, str, strlen(str) + 1);
+}
+
+#define HASH_INIT 14695981039346656037ULL
+
+//***********************************************
+// source state
+//***********************************************
+static uint64_t state_hash;
+static dev_t run_dev;
+
+// paths skipped by the last state_build(), one per line; saved with the template
+static char *generated = NULL;
+static size_t generated_len = 0;
+// --dry-run: the list saved with the template, the files are generated only in the sandbox
+static char *generated_saved = NULL;
+
+// files generated for this sandbox (filtered /etc/passwd and /etc/group,
+// /etc/hostname, /etc/hosts) are mounted from RUN_MNT_DIR; they change
+// from one launch to the next and are never part of the template
+static int is_generated(const char *path) {
+	if (generated_saved) {
+		size_t len = strlen(path);
+		const char *ptr = generated_saved;
+		while ((ptr = strstr(ptr, path)) != NULL) {
+			if ((ptr == generated_saved || ptr[-1] == '\n') && ptr[len] == '\n')
+				return 1;
+			ptr++;
+		}
+		return 0;
+	}
+
+	struct stat s;
+	return stat(path, &s) == 0 && s.st_dev == run_dev;
+}
+
+static void generated_add(const char *path) {
+	size_t len = strlen(path);
+	generated = realloc(generated, generated_len + len + 2);
+	if (!generated)
+		errExit("realloc");
+	memcpy(generated + generated_len, path, len);
+	generated_len += len;
+	generated[generated_len++] = '\n';
+	generated[generated_len] = '\0';
+}
+
+int fs_template_generated(const char *path) {
+	assert(path);
+	return is_generated(path);
+}
+
+static int state_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
+	(void) ftwbuf;
+
+	state_hash = hash_str(state_hash, fpath);
+	if (typeflag == FTW_NS) {
+		state_hash = hash_str(state_hash, "missing");
+		return 0;
+	}
+
+	// inode metadata is enough to detect changes in the host filesystem
+	state_hash = hash_bytes(state_hash, &sb->st_dev, sizeof(sb->st_dev));
+	state_hash = hash_bytes(state_hash, &sb->st_ino, sizeof(sb->st_ino));
+	state_hash = hash_bytes(state_hash, &sb->st_mode, sizeof(sb->st_mode));
+	state_hash = hash_bytes(state_hash, &sb->st_uid, sizeof(sb->st_uid));
+	state_hash = hash_bytes(state_hash, &sb->st_gid, sizeof(sb->st_gid));
+	state_hash = hash_bytes(state_hash, &sb->st_size, sizeof(sb->st_size));
+	state_hash = hash_bytes(state_hash, &sb->st_mtim, sizeof(sb->st_mtim));
+	state_hash = hash_bytes(state_hash, &sb->st_ctim, sizeof(sb->st_ctim));
+
+	if (typeflag == FTW_SL) {
+		char target[PATH_MAX];
+		ssize_t len = readlink(fpath, target, sizeof(target) - 1);
+		if (len != -1) {
+			target[len] = '\0';
+			state_hash = hash_str(state_hash, target);
+		}
+	}
+	return 0;
+}
+
+static void state_add_entry(const char *path) {
+	if (is_generated(path)) {
+		generated_add(path);
+		return;
+	}
+
+	// fcopy follows the top level symbolic link, walk the tree it points to
+	struct stat s;
+	if (lstat(path, &s) == 0 && S_ISLNK(s.st_mode)) {
+		state_callback(path, &s, FTW_SL, NULL);
+		char *rpath = realpath(path, NULL);
+		if (!rpath) {
+			state_hash = hash_str(state_hash, "dangling");
+			return;
+		}
+		nftw(rpath, state_callback, 32, FTW_PHYS);
+		free(rpath);
+		return;
+	}
+
+	if (nftw(path, state_callback, 32, FTW_PHYS) == -1)
+		state_hash = hash_str(state_hash, "missing");
+}
+
+static char *state_build(const char *private_dir, const char *private_list) {
+	if (!generated_saved) {
+		struct stat s;
+		if (stat(RUN_MNT_DIR, &s) == -1)
+			errExit("stat");
+		run_dev = s.st_dev;
+	}
+	state_hash = HASH_INIT;
+	generated_len = 0;
+	free(generated);
+	generated = NULL;
+
+	char *dlist = strdup(private_list);
+	if (!dlist)
+		errExit("strdup");
+
+	char *ptr = strtok(dlist, ",");
+	while (ptr) {
+		fs_private_dir_check_name(ptr);
+
+		char *pattern;
+		if (asprintf(&pattern, "%s/%s", private_dir, ptr) == -1)
+			errExit("asprintf");
+		glob_t globbuf;
+		if (glob(pattern, GLOB_NOCHECK | GLOB_NOSORT | GLOB_PERIOD, NULL, &globbuf)) {
+			fprintf(stderr, "Error: failed to glob pattern %s\n", pattern);
+			exit(1);
+		}
+		size_t i;
+		for (i = 0; i < globbuf.gl_pathc; i++)
+			state_add_entry(globbuf.gl_pathv[i]);
+		globfree(&globbuf);
+		free(pattern);
+
+		ptr = strtok(NULL, ",");
+	}
+	free(dlist);
+
+	char *rv;
+	if (asprintf(&rv, "%016llx", (unsigned long long) state_hash) == -1)
+		errExit("asprintf");
+	return rv;
+}
+
+//***********************************************
+// tree copy
+//***********************************************
+static uint64_t tree_size;
+
+static int size_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
+	(void) fpath;
+	(void) typeflag;
+	(void) ftwbuf;
+	tree_size += sb->st_size;
+	return (tree_size > TEMPLATE_MAX_SIZE) ? 1 : 0;
+}
+
+static int copy_regular(int srcdir, int dstdir, const char *name, const struct stat *s) {
+	int src = openat(srcdir, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (src == -1)
+		return -1;
+	int dst = openat(dstdir, name, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (dst == -1) {
+		close(src);
+		return -1;
+	}
+
+	int rv = 0;
+	off_t left = s->st_size;
+	while (left > 0) {
+		ssize_t len = sendfile(dst, src, NULL, left);
+		if (len <= 0) {
+			rv = -1;
+			break;
+		}
+		left -= len;
+	}
+
+	if (rv == 0 &&
+	    (fchown(dst, s->st_uid, s->st_gid) == -1 ||
+	     fchmod(dst, s->st_mode & 07777) == -1))
+		rv = -1;
+
+	close(src);
+	close(dst);
+	return rv;
+}
+
+// copy the content of directory srcdir into directory dstdir;
+// dstpath and inside are used only for SELinux relabeling; if skip_root is set,
+// top level entries generated for this sandbox under skip_root are not copied
+static int copy_tree(int srcdir, int dstdir, const char *dstpath, const char *inside, const char *skip_root, int depth) {
+	if (depth > TEMPLATE_MAX_DEPTH)
+		return -1;
+
+	int dupfd = dup(srcdir);
+	if (dupfd == -1)
+		return -1;
+	DIR *dir = fdopendir(dupfd);
+	if (!dir) {
+		close(dupfd);
+		return -1;
+	}
+
+	int rv = 0;
+	struct dirent *entry;
+	while (rv == 0 && (entry = readdir(dir)) != NULL) {
+		const char *name = entry->d_name;
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+			continue;
+
+		if (skip_root && depth == 0) {
+			char *src;
+			if (asprintf(&src, "%s/%s", skip_root, name) == -1)
+				errExit("asprintf");
+			int generated = is_generated(src);
+			free(src);
+			if (generated)
+				continue;
+		}
+
+		struct stat s;
+		if (fstatat(srcdir, name, &s, AT_SYMLINK_NOFOLLOW) == -1) {
+			rv = -1;
+			break;
+		}
+
+		char *dname;
+		char *iname = NULL;
+		if (asprintf(&dname, "%s/%s", dstpath, name) == -1)
+			errExit("asprintf");
+		if (inside && asprintf(&iname, "%s/%s", inside, name) == -1)
+			errExit("asprintf");
+
+		if (S_ISREG(s.st_mode))
+			rv = copy_regular(srcdir, dstdir, name, &s);
+		else if (S_ISLNK(s.st_mode)) {
+			char target[PATH_MAX];
+			ssize_t len = readlinkat(srcdir, name, target, sizeof(target) - 1);
+			if (len == -1)
+				rv = -1;
+			else {
+				target[len] = '\0';
+				if (symlinkat(target, dstdir, name) == -1 ||
+				    fchownat(dstdir, name, s.st_uid, s.st_gid, AT_SYMLINK_NOFOLLOW) == -1)
+					rv = -1;
+			}
+		}
+		else if (S_ISDIR(s.st_mode)) {
+			if (mkdirat(dstdir, name, 0700) == -1)
+				rv = -1;
+			else {
+				int sfd = openat(srcdir, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+				int dfd = openat(dstdir, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+				if (sfd == -1 || dfd == -1)
+					rv = -1;
+				else
+					rv = copy_tree(sfd, dfd, dname, iname, NULL, depth + 1);
+				if (rv == 0 &&
+				    (fchown(dfd, s.st_uid, s.st_gid) == -1 ||
+				     fchmod(dfd, s.st_mode & 07777) == -1))
+					rv = -1;
+				if (sfd != -1)
+					close(sfd);
+				if (dfd != -1)
+					close(dfd);
+			}
+		}
+		// fcopy doesn't copy devices, sockets and fifos either
+
+		if (rv == 0 && inside)
+			selinux_relabel_path(dname, iname);
+		free(dname);
+		free(iname);
+	}
+	closedir(dir);
+
+	return rv;
+}
+
+static int remove_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
+	(void) sb;
+	(void) typeflag;
+	(void) ftwbuf;
+	remove(fpath);
+	return 0;
+}
+
+//***********************************************
+// public interface
+//***********************************************
+// RUN_FIREJAIL_TEMPLATE_DIR/<uid>, opened before the directory is blacklisted in disable_config()
+static int template_fd = -1;
+
+static void template_open(int create) {
+	assert(geteuid() == 0);
+
+	char *udir;
+	if (asprintf(&udir, "%s/%u", RUN_FIREJAIL_TEMPLATE_DIR, getuid()) == -1)
+		errExit("asprintf");
+	if (create && mkdir(udir, 0700) == -1 && errno != EEXIST) {
+		free(udir);
+		return;
+	}
+	int fd = open(udir, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	free(udir);
+	if (fd == -1)
+		return;
+
+	// the template directory is root-owned; anything else was not created by us
+	struct stat s;
+	if (fstat(fd, &s) == -1 || s.st_uid != 0 || (s.st_mode & 0077)) {
+		close(fd);
+		return;
+	}
+	template_fd = fd;
+}
+
+void fs_template_init(void) {
+	template_open(1);
+}
+
+static char *slot_name(const char *private_dir, const char *private_run_dir, const char *private_list) {
+	const char *tag = strrchr(private_run_dir, '/');
+	tag = (tag) ? tag + 1 : private_run_dir;
+
+	uint64_t h = hash_str(HASH_INIT, private_dir);
+	h = hash_str(h, private_list);
+
+	char *rv;
+	if (asprintf(&rv, "%s-%016llx", tag, (unsigned long long) h) == -1)
+		errExit("asprintf");
+	return rv;
+}
+
+// full path of a file in the template directory, for nftw
+static char *slot_path(const char *name) {
+	char *rv;
+	if (asprintf(&rv, "/proc/self/fd/%d/%s", template_fd, name) == -1)
+		errExit("asprintf");
+	return rv;
+}
+
+// <dir>-<16 hex digits>; other entries in the user directory belong to restrict-users
+static int is_slot(const char *name) {
+	size_t len = strlen(name);
+	if (len < 18 || name[len - 17] != '-')
+		return 0;
+	const char *ptr = name + len - 16;
+	for (; *ptr; ptr++) {
+		if (!isxdigit((unsigned char) *ptr))
+			return 0;
+	}
+	return 1;
+}
+
+// make room for a new slot; returns -1 if all the slots are in use
+static int slot_evict(void) {
+	while (1) {
+		int dupfd = dup(template_fd);
+		if (dupfd == -1)
+			return -1;
+		DIR *dir = fdopendir(dupfd);
+		if (!dir) {
+			close(dupfd);
+			return -1;
+		}
+		rewinddir(dir);
+
+		int cnt = 0;
+		char *oldest = NULL;
+		struct timespec otime = {0, 0};
+		struct dirent *entry;
+		while ((entry = readdir(dir)) != NULL) {
+			if (!is_slot(entry->d_name))
+				continue;
+			struct stat s;
+			if (fstatat(template_fd, entry->d_name, &s, AT_SYMLINK_NOFOLLOW) == -1 || !S_ISDIR(s.st_mode))
+				continue;
+			cnt++;
+			if (!oldest ||
+			    s.st_mtim.tv_sec < otime.tv_sec ||
+			    (s.st_mtim.tv_sec == otime.tv_sec && s.st_mtim.tv_nsec < otime.tv_nsec)) {
+				free(oldest);
+				oldest = strdup(entry->d_name);
+				if (!oldest)
+					errExit("strdup");
+				otime = s.st_mtim;
+			}
+		}
+		closedir(dir);
+
+		if (cnt < TEMPLATE_MAX_SLOTS) {
+			free(oldest);
+			return 0;
+		}
+
+		// the least recently used slot might be restored by another sandbox right now
+		int rv = -1;
+		int fd = openat(template_fd, oldest, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		if (fd != -1 && flock(fd, LOCK_EX | LOCK_NB) == 0) {
+			char *path = slot_path(oldest);
+			nftw(path, remove_callback, 32, FTW_DEPTH | FTW_PHYS);
+			free(path);
+			if (arg_debug)
+				printf("Template %s removed\n", oldest);
+			rv = 0;
+		}
+		if (fd != -1)
+			close(fd);
+		free(oldest);
+		if (rv == -1)
+			return -1;
+	}
+}
+
+// open the template slot; if create is set, build the slot as needed
+static int slot_open(const char *slot, int create) {
+	if (create) {
+		struct stat s;
+		if (fstatat(template_fd, slot, &s, AT_SYMLINK_NOFOLLOW) == -1 && slot_evict() == -1)
+			return -1;
+		if (mkdirat(template_fd, slot, 0700) == -1 && errno != EEXIST)
+			return -1;
+	}
+
+	int fd = openat(template_fd, slot, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (fd == -1)
+		return -1;
+
+	// the template is root-owned; anything else was not created by us
+	struct stat s;
+	if (fstat(fd, &s) == -1 || s.st_uid != 0 || (s.st_mode & 0077)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// returns 1 if private_run_dir was populated from the template, 0 otherwise;
+// files generated for this sandbox are left for the caller to copy;
+// *state is set to the current source state, to be passed to fs_template_save
+int fs_template_restore(const char *private_dir, const char *private_run_dir, const char *private_list, char **state) {
+	assert(private_dir);
+	assert(private_run_dir);
+	assert(private_list);
+	assert(state);
+	assert(geteuid() == 0);
+
+	*state = state_build(private_dir, private_list);
+	if (template_fd == -1)
+		return 0;
+
+	char *slot = slot_name(private_dir, private_run_dir, private_list);
+	int fd = slot_open(slot, 0);
+	free(slot);
+	if (fd == -1)
+		return 0;
+
+	// another sandbox might be updating the template right now
+	if (flock(fd, LOCK_SH | LOCK_NB) == -1) {
+		close(fd);
+		return 0;
+	}
+
+	int rv = 0;
+	char saved[32];
+	int sfd = openat(fd, "state", O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (sfd != -1) {
+		ssize_t len = read(sfd, saved, sizeof(saved) - 1);
+		close(sfd);
+		if (len > 0) {
+			saved[len] = '\0';
+			if (strcmp(saved, *state) == 0) {
+				int tfd = openat(fd, "tree", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+				int dfd = open(private_run_dir, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+				if (tfd != -1 && dfd != -1 &&
+				    copy_tree(tfd, dfd, private_run_dir, private_dir, NULL, 0) == 0)
+					rv = 1;
+				if (tfd != -1)
+					close(tfd);
+				if (dfd != -1)
+					close(dfd);
+			}
+			else if (arg_debug)
+				printf("Template for %s is out of date\n", private_dir);
+		}
+	}
+	// least recently used slots are removed first
+	if (rv)
+		futimens(fd, NULL);
+	close(fd);
+
+	if (rv) {
+		fs_logger2("template", private_dir);
+		if (arg_debug)
+			printf("Private %s restored from template\n", private_dir);
+	}
+	return rv;
+}
+
+// save private_run_dir as the template for this private directory
+void fs_template_save(const char *private_dir, const char *private_run_dir, const char *private_list, const char *state) {
+	assert(private_dir);
+	assert(private_run_dir);
+	assert(private_list);
+	assert(state);
+	assert(geteuid() == 0);
+	if (template_fd == -1)
+		return;
+
+	tree_size = 0;
+	if (nftw(private_run_dir, size_callback, 32, FTW_PHYS) != 0) {
+		if (arg_debug)
+			printf("Private %s is too large for a template\n", private_dir);
+		return;
+	}
+
+	char *slot = slot_name(private_dir, private_run_dir, private_list);
+	int fd = slot_open(slot, 1);
+	if (fd == -1) {
+		if (arg_debug)
+			printf("Cannot create template %s\n", slot);
+		free(slot);
+		return;
+	}
+	if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+		close(fd);
+		free(slot);
+		return;
+	}
+
+	// replace the old tree, the state file goes in last
+	unlinkat(fd, "state", 0);
+	unlinkat(fd, "generated", 0);
+	char *tree;
+	if (asprintf(&tree, "/proc/self/fd/%d/tree", fd) == -1)
+		errExit("asprintf");
+	nftw(tree, remove_callback, 32, FTW_DEPTH | FTW_PHYS);
+
+	int ok = 0;
+	if (mkdirat(fd, "tree", 0700) == 0) {
+		int tfd = openat(fd, "tree", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		int sfd = open(private_run_dir, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		if (tfd != -1 && sfd != -1 && copy_tree(sfd, tfd, tree, NULL, private_dir, 0) == 0)
+			ok = 1;
+		if (tfd != -1)
+			close(tfd);
+		if (sfd != -1)
+			close(sfd);
+	}
+
+	if (ok) {
+		// the list of generated files lets --dry-run rebuild the state outside the sandbox
+		int gfd = openat(fd, "generated", O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+		if (gfd == -1 || (generated_len && write(gfd, generated, generated_len) != (ssize_t) generated_len))
+			ok = 0;
+		if (gfd != -1)
+			close(gfd);
+	}
+
+	if (ok) {
+		int stfd = openat(fd, "state", O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+		if (stfd == -1 || write(stfd, state, strlen(state)) != (ssize_t) strlen(state))
+			ok = 0;
+		if (stfd != -1)
+			close(stfd);
+	}
+
+	if (!ok) {
+		unlinkat(fd, "state", 0);
+		unlinkat(fd, "generated", 0);
+		nftw(tree, remove_callback, 32, FTW_DEPTH | FTW_PHYS);
+	}
+	else if (arg_debug)
+		printf("Template for private %s saved in %s\n", private_dir, slot);
+
+	free(tree);
+	free(slot);
+	close(fd);
+}
+
+// --dry-run: return 1 if fs_template_restore() would use the template for private_dir;
+// afterwards fs_template_generated() reports the files generated in the sandbox, as
+// recorded when the template was saved
+int fs_template_check(const char *private_dir, const char *private_run_dir, const char *private_list) {
+	assert(private_dir);
+	assert(private_run_dir);
+	assert(private_list);
+	assert(geteuid() == 0);
+
+	if (template_fd == -1)
+		template_open(0);
+	if (template_fd == -1)
+		return 0;
+
+	char *slot = slot_name(private_dir, private_run_dir, private_list);
+	int fd = slot_open(slot, 0);
+	free(slot);
+	if (fd == -1)
+		return 0;
+
+	char saved[32];
+	ssize_t len = -1;
+	int sfd = openat(fd, "state", O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (sfd != -1) {
+		len = read(sfd, saved, sizeof(saved) - 1);
+		close(sfd);
+	}
+
+	// an empty list is a valid list, a missing one is not
+	struct stat s;
+	int gfd = openat(fd, "generated", O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	close(fd);
+	if (gfd == -1 || fstat(gfd, &s) == -1 || len <= 0) {
+		if (gfd != -1)
+			close(gfd);
+		return 0;
+	}
+	saved[len] = '\0';
+
+	free(generated_saved);
+	generated_saved = calloc(1, s.st_size + 1);
+	if (!generated_saved)
+		errExit("calloc");
+	if (read(gfd, generated_saved, s.st_size) != s.st_size) {
+		close(gfd);
+		return 0;
+	}
+	close(gfd);
+
+	char *state = state_build(private_dir, private_list);
+	int rv = strcmp(saved, state) == 0;
+	free(state);
+	return rv;
+}
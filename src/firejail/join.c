@@ -55,6 +55,19 @@ static void install_handler(void) {
 	sigaction(SIGTERM, &sga, NULL);
 }
 
+static void set_x11_display(void) {
+	// check display range
+	if (display < X11_DISPLAY_START || display > X11_DISPLAY_END) {
+		fprintf(stderr, "Error: invalid X11 display range\n");
+		return;
+	}
+
+	// store the display number for join process in /run/firejail/x11
+	EUID_ROOT();
+	set_x11_run_file(getpid(), display);
+	EUID_USER();
+}
+
 static void extract_x11_display(pid_t pid) {
 	char *fname;
 	if (asprintf(&fname, "%s/%d", RUN_FIREJAIL_X11_DIR, pid) == -1)
@@ -72,16 +85,7 @@ static void extract_x11_display(pid_t pid) {
 	}
 	fclose(fp);
 
-	// check display range
-	if (display < X11_DISPLAY_START || display > X11_DISPLAY_END) {
-		fprintf(stderr, "Error: invalid X11 display range\n");
-		return;
-	}
-
-	// store the display number for join process in /run/firejail/x11
-	EUID_ROOT();
-	set_x11_run_file(getpid(), display);
-	EUID_USER();
+	set_x11_display();
 }
 
 static void extract_command(int argc, char **argv, int index) {
@@ -407,9 +411,24 @@ ProcessHandle pin_sandbox_process(pid_t pid) {
 
 void join(pid_t pid, int argc, char **argv, int index) {
 	EUID_ASSERT();
+	// sandboxes started with --join-agent run the command themselves;
+	// agent_join() returns only if the agent is not available
+	if (!arg_join_network && !arg_join_filesystem)
+		agent_join(pid, argc, argv, index);
+
 	ProcessHandle sandbox = pin_sandbox_process(pid);
 
-	extract_x11_display(pid);
+	// sandboxes started by an older version don't have a join state record
+	bool have_state = false;
+	if (getuid() != 0)
+		have_state = join_state_read(sandbox, &caps, &display) == 0;
+	if (have_state) {
+		apply_caps = 1;
+		if (display)
+			set_x11_display();
+	}
+	else
+		extract_x11_display(pid);
 
 	int shfd = -1;
 // Note: this might be used by joining appimages!!!!
@@ -417,14 +436,15 @@ void join(pid_t pid, int argc, char **argv, int index) {
 //		shfd = open_shell();
 
 	// in user mode set caps seccomp, cpu etc.
-	if (getuid() != 0) {
+	if (getuid() != 0 && !have_state) {
 		extract_nonewprivs(sandbox);  // redundant on Linux >= 4.10; duplicated in function extract_caps
 		extract_caps(sandbox);
 		extract_cpu(sandbox);
 		extract_nogroups(sandbox);
-		extract_user_namespace(sandbox);
 		extract_umask(sandbox);
 	}
+	if (getuid() != 0)
+		extract_user_namespace(sandbox);
 
 	// join namespaces
 	EUID_ROOT();
@@ -458,7 +478,9 @@ void join(pid_t pid, int argc, char **argv, int index) {
 			process_rootfs_chroot(sandbox);
 
 			// load seccomp filters
-			if (getuid() != 0)
+			if (have_state)
+				join_state_load_seccomp();
+			else if (getuid() != 0)
 				seccomp_load_file_list();
 		}
 
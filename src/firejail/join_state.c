@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "firejail.h"
+#include "../include/seccomp.h"
+#include <sys/stat.h>
+#include <sys/prctl.h>
+#include <errno.h>
+
+// All the state --join needs from a sandbox, saved in a single root-owned file
+// at setup time. Sandboxes started by an older version don't have it, and join()
+// falls back to the individual configuration files.
+#define JOIN_STATE_MAGIC 0x5453464a	// "JFST"
+#define JOIN_STATE_VERSION 1
+#define JOIN_STATE_MAX (1024 * 1024)
+
+#define JOIN_STATE_NONEWPRIVS	0x01
+#define JOIN_STATE_NOGROUPS	0x02
+#define JOIN_STATE_CAPS		0x04
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;		// record size, header included
+	uint32_t flags;
+	uint64_t caps;		// capability bounding set
+	uint32_t cpus;		// cpu affinity mask, 0 if not configured
+	uint32_t umask;
+	uint32_t display;	// X11 display, 0 if none
+	uint32_t filters;	// number of seccomp programs following the header
+} JoinState;
+// every seccomp program is stored as a uint32_t instruction count followed by the
+// instructions, in the order of RUN_SECCOMP_LIST
+
+static char *state = NULL;	// record read by join_state_read()
+
+static uint64_t read_capbset(void) {
+	uint64_t rv = 0;
+	int i;
+	for (i = 0; i < 64; i++) {
+		int val = prctl(PR_CAPBSET_READ, i, 0, 0, 0);
+		if (val == -1)
+			break;	// EINVAL past the last capability
+		if (val)
+			rv |= 1ULL << i;
+	}
+	return rv;
+}
+
+static void append(char **buf, size_t *len, const void *data, size_t size) {
+	*buf = realloc(*buf, *len + size);
+	if (!*buf)
+		errExit("realloc");
+	memcpy(*buf + *len, data, size);
+	*len += size;
+}
+
+#define MAXBUF 4096
+// seccomp programs, in the order they were loaded
+static unsigned append_filters(char **buf, size_t *len) {
+	FILE *fp = fopen(RUN_SECCOMP_LIST, "re");
+	if (!fp)
+		return 0; // no seccomp configuration whatsoever
+
+	unsigned cnt = 0;
+	char fname[MAXBUF];
+	while (fgets(fname, MAXBUF, fp)) {
+		char *ptr = strchr(fname, '\n');
+		if (ptr)
+			*ptr = '\0';
+
+		int fd = open(fname, O_RDONLY|O_CLOEXEC);
+		struct stat s;
+		if (fd == -1 || fstat(fd, &s) == -1 ||
+		    s.st_size % sizeof(struct sock_filter) || s.st_size > BPF_MAXINSNS * (off_t) sizeof(struct sock_filter)) {
+			fprintf(stderr, "Error: cannot read seccomp filter %s\n", fname);
+			exit(1);
+		}
+		uint32_t entries = s.st_size / sizeof(struct sock_filter);
+		append(buf, len, &entries, sizeof(entries));
+		*buf = realloc(*buf, *len + s.st_size);
+		if (!*buf)
+			errExit("realloc");
+		if (read(fd, *buf + *len, s.st_size) != s.st_size)
+			errExit("read");
+		*len += s.st_size;
+		close(fd);
+		cnt++;
+	}
+	fclose(fp);
+	return cnt;
+}
+
+// called in the sandbox after the security filters were set up
+void join_state_save(void) {
+	JoinState hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = JOIN_STATE_MAGIC;
+	hdr.version = JOIN_STATE_VERSION;
+	if (arg_nonewprivs)
+		hdr.flags |= JOIN_STATE_NONEWPRIVS;
+	if (arg_nogroups)
+		hdr.flags |= JOIN_STATE_NOGROUPS;
+	hdr.flags |= JOIN_STATE_CAPS;
+	hdr.caps = read_capbset();
+	hdr.cpus = cfg.cpus;
+	hdr.umask = orig_umask;
+	int display = x11_display();
+	if (display > 0)
+		hdr.display = display;
+
+	char *buf = NULL;
+	size_t len = sizeof(hdr);
+	buf = malloc(len);
+	if (!buf)
+		errExit("malloc");
+	hdr.filters = append_filters(&buf, &len);
+	if (len > JOIN_STATE_MAX) {
+		fprintf(stderr, "Error: join state too large\n");
+		exit(1);
+	}
+	hdr.size = len;
+	memcpy(buf, &hdr, sizeof(hdr));
+
+	int fd = open(RUN_JOIN_STATE, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0644);
+	if (fd == -1 || write(fd, buf, len) != (ssize_t) len) {
+		fprintf(stderr, "Error: cannot save join state\n");
+		exit(1);
+	}
+	if (fchown(fd, 0, 0) == -1)
+		errExit("fchown");
+	close(fd);
+	free(buf);
+
+	if (arg_debug)
+		printf("Join state saved: %zu bytes, %u seccomp filters\n", len, hdr.filters);
+}
+
+// read and validate the record of a sandbox; returns -1 if it is missing or was
+// written by a different version
+int join_state_read(ProcessHandle sandbox, uint64_t *caps, unsigned *display) {
+	assert(caps);
+	assert(display);
+	int fd = process_rootfs_open(sandbox, RUN_JOIN_STATE);
+	if (fd == -1)
+		return -1;
+
+	struct stat s;
+	if (fstat(fd, &s) == -1)
+		errExit("fstat");
+	if (!S_ISREG(s.st_mode) || s.st_uid != 0 ||
+	    s.st_size < (off_t) sizeof(JoinState) || s.st_size > JOIN_STATE_MAX) {
+		close(fd);
+		return -1;
+	}
+
+	char *buf = malloc(s.st_size);
+	if (!buf)
+		errExit("malloc");
+	ssize_t len = read(fd, buf, s.st_size);
+	close(fd);
+
+	JoinState *hdr = (JoinState *) buf;
+	if (len != s.st_size || hdr->magic != JOIN_STATE_MAGIC ||
+	    hdr->version != JOIN_STATE_VERSION || hdr->size != len) {
+		free(buf);
+		return -1;
+	}
+
+	// check the seccomp programs before using anything
+	size_t offset = sizeof(JoinState);
+	uint32_t i;
+	for (i = 0; i < hdr->filters; i++) {
+		uint32_t entries;
+		if (offset + sizeof(entries) > (size_t) len)
+			goto errexit;
+		memcpy(&entries, buf + offset, sizeof(entries));
+		offset += sizeof(entries);
+		if (entries == 0 || entries > BPF_MAXINSNS ||
+		    offset + entries * sizeof(struct sock_filter) > (size_t) len)
+			goto errexit;
+		offset += entries * sizeof(struct sock_filter);
+	}
+	if (offset != (size_t) len)
+		goto errexit;
+
+	if (hdr->flags & JOIN_STATE_NONEWPRIVS)
+		arg_nonewprivs = 1;
+	if (hdr->flags & JOIN_STATE_NOGROUPS)
+		arg_nogroups = 1;
+	*caps = hdr->caps;
+	cfg.cpus = hdr->cpus;
+	orig_umask = hdr->umask & 0777;
+	*display = hdr->display;
+
+	state = buf;
+	if (arg_debug) {
+		printf("Join state loaded: %zd bytes, %u seccomp filters\n", len, hdr->filters);
+		fflush(0);
+	}
+	return 0;
+
+errexit:
+	fprintf(stderr, "Error: invalid join state file\n");
+	exit(1);
+}
+
+// queue the seccomp programs of the record, in the same order as seccomp_load_file_list()
+void join_state_load_seccomp(void) {
+	assert(state);
+	JoinState *hdr = (JoinState *) state;
+	size_t offset = sizeof(JoinState);
+	uint32_t i;
+	for (i = 0; i < hdr->filters; i++) {
+		uint32_t entries;
+		memcpy(&entries, state + offset, sizeof(entries));
+		offset += sizeof(entries);
+		seccomp_load_prog(RUN_JOIN_STATE, (struct sock_filter *) (state + offset), entries);
+		offset += entries * sizeof(struct sock_filter);
+	}
+}
@@ -69,6 +69,8 @@ int arg_debug = 0;				// print debug messages
 int arg_debug_blacklists = 0;			// print debug messages for blacklists
 int arg_debug_whitelists = 0;			// print debug messages for whitelists
 int arg_debug_private_lib = 0;			// print debug messages for private-lib
+int arg_dry_run = 0;				// print planned operations and exit
+int arg_cost = 0;				// print the startup cost estimate and exit
 int arg_nonetwork = 0;				// --net=none
 int arg_command = 0;				// -c
 int arg_overlay = 0;				// overlay option
@@ -91,6 +93,7 @@ char *arg_caps_list = NULL;			// optional caps list
 
 int arg_trace = 0;				// syscall tracing support
 char *arg_tracefile = NULL;			// syscall tracing file
+int arg_trace_fanotify = 0;			// file access tracing using fanotify
 int arg_tracelog = 0;				// blacklist tracing support
 int arg_rlimit_cpu = 0;				// rlimit max cpu time
 int arg_rlimit_nofile = 0;			// rlimit nofile
@@ -121,6 +124,7 @@ int arg_private_tmp = 0;			// private tmp directory
 int arg_private_lib = 0;			// private lib directory
 int arg_private_cwd = 0;			// private working directory
 int arg_scan = 0;				// arp-scan all interfaces
+unsigned arg_scan_rate = 0;			// arp-scan probes per second, 0 for the default rate
 int arg_whitelist = 0;				// whitelist command
 int arg_nosound = 0;				// disable sound
 int arg_novideo = 0;			//disable video devices in /dev
@@ -129,10 +133,13 @@ int arg_noprinters = 0;				// disable printers
 int arg_quiet = 0;				// no output for scripting
 int arg_join_network = 0;			// join only the network namespace
 int arg_join_filesystem = 0;			// join only the mount namespace
+int arg_join_agent = 0;				// start the --join agent in the sandbox
+int arg_prefetch = 0;				// prefetch the application files during setup
 int arg_nice = 0;				// nice value configured
 int arg_ipc = 0;					// enable ipc namespace
 int arg_writable_etc = 0;			// writable etc
 int arg_keep_config_pulse = 0;			// disable automatic ~/.config/pulse init
+int arg_fs_template = 0;			// reuse private directories built by a previous sandbox
 int arg_keep_shell_rc = 0;			// do not copy shell configuration from /etc/skel
 int arg_writable_var = 0;			// writable var
 int arg_keep_var_tmp = 0;			// don't overwrite /var/tmp
@@ -143,6 +150,7 @@ int arg_apparmor = 0;				// apparmor
 char *apparmor_profile = NULL;	// apparmor profile
 bool apparmor_replace = false;	// apparmor profile
 int arg_allow_debuggers = 0;			// allow debuggers
+int arg_proc_subset = 0;			// /proc with process directories only
 int arg_x11_block = 0;				// block X11
 int arg_x11_xorg = 0;				// use X11 security extension
 int arg_allusers = 0;				// all user home directories visible
@@ -189,10 +197,12 @@ static void myexit(int rv) {
 		fmessage("\nParent is shutting down, bye...\n");
 
 
-	// delete sandbox files in shared memory
+	// the exit status is reported as soon as the sandbox is unregistered;
+	// slow cleanup work is handed over to detached processes
 #ifdef HAVE_DBUSPROXY
 	dbus_proxy_stop();
 #endif
+	// delete sandbox files in shared memory
 	EUID_ROOT();
 	delete_run_files(sandbox_pid);
 	appimage_clear();
@@ -919,6 +929,14 @@ static void run_cmd_and_exit(int i, int argc, char **argv) {
 		else
 			exit_err_feature("join");
 	}
+	else if (strncmp(argv[i], "--launch=", 9) == 0) {
+		if (checkcfg(CFG_POOL)) {
+			logargs(argc, argv);
+			pool_launch(argv[i] + 9, argc, argv, i + 1);
+		}
+		else
+			exit_err_feature("pool");
+	}
 #ifdef HAVE_NETWORK
 	else if (strncmp(argv[i], "--join-network=", 15) == 0) {
 		if (checkcfg(CFG_NETWORK)) {
@@ -1294,15 +1312,6 @@ int main(int argc, char **argv, char **envp) {
 #endif
 	EUID_ASSERT();
 
-	// --ip=dhcp - we need access to /sbin and /usr/sbin directories in order to run ISC DHCP client (dhclient)
-	// these paths are disabled in disable-common.inc
-	if ((i = check_arg(argc, argv, "--ip", 0)) != 0) {
-		if (strncmp(argv[i] + 4, "=dhcp", 5) == 0) {
-			profile_add("noblacklist /sbin");
-			profile_add("noblacklist /usr/sbin");
-		}
-	}
-
 	// process allow-debuggers
 	if (check_arg(argc, argv, "--allow-debuggers", 1)) {
 		// check kernel version
@@ -1360,6 +1369,10 @@ int main(int argc, char **argv, char **envp) {
 		else if (strcmp(argv[i], "--debug-private-lib") == 0)
 			arg_debug_private_lib = 1;
 #endif
+		else if (strcmp(argv[i], "--dry-run") == 0)
+			arg_dry_run = 1;
+		else if (strcmp(argv[i], "--cost") == 0)
+			arg_cost = 1;
 		else if (strcmp(argv[i], "--quiet") == 0) {
 			if (!arg_debug)
 				arg_quiet = 1;
@@ -1586,9 +1599,14 @@ int main(int argc, char **argv, char **envp) {
 		}
 		else if (strcmp(argv[i], "--trace") == 0)
 			arg_trace = 1;
-		else if (strncmp(argv[i], "--trace=", 8) == 0) {
-			arg_trace = 1;
-			arg_tracefile = expand_macros(argv[i] + 8);
+		else if (strcmp(argv[i], "--trace-fanotify") == 0)
+			arg_trace_fanotify = 1;
+		else if (strncmp(argv[i], "--trace=", 8) == 0 || strncmp(argv[i], "--trace-fanotify=", 17) == 0) {
+			if (argv[i][7] == '=')
+				arg_trace = 1;
+			else
+				arg_trace_fanotify = 1;
+			arg_tracefile = expand_macros(strchr(argv[i], '=') + 1);
 			if (*arg_tracefile == '\0') {
 				fprintf(stderr, "Error: invalid trace option\n");
 				exit(1);
@@ -1918,6 +1936,12 @@ int main(int argc, char **argv, char **envp) {
 			}
 			profile_add_ignore(argv[i] + 9);
 		}
+		else if (strcmp(argv[i], "--join-agent") == 0) {
+			if (checkcfg(CFG_JOIN) || getuid() == 0)
+				arg_join_agent = 1;
+			else
+				exit_err_feature("join");
+		}
 		else if (strncmp(argv[i], "--keep-fd=", 10) == 0) {
 			if (strcmp(argv[i] + 10, "all") == 0)
 				arg_keep_fd_all = 1;
@@ -1959,6 +1983,12 @@ int main(int argc, char **argv, char **envp) {
 		else if (strcmp(argv[i], "--keep-config-pulse") == 0) {
 			arg_keep_config_pulse = 1;
 		}
+		else if (strcmp(argv[i], "--fs-template") == 0) {
+			if (checkcfg(CFG_FS_TEMPLATE))
+				arg_fs_template = 1;
+			else
+				exit_err_feature("fs-template");
+		}
 		else if (strcmp(argv[i], "--keep-shell-rc") == 0) {
 			arg_keep_shell_rc = 1;
 		}
@@ -1977,6 +2007,10 @@ int main(int argc, char **argv, char **envp) {
 		else if (strcmp(argv[i], "--machine-id") == 0) {
 			arg_machineid = 1;
 		}
+		else if (strcmp(argv[i], "--prefetch") == 0)
+			arg_prefetch = 1;
+		else if (strcmp(argv[i], "--proc-subset") == 0)
+			arg_proc_subset = 1;
 		else if (strcmp(argv[i], "--private") == 0) {
 			arg_private = 1;
 		}
@@ -2135,6 +2169,8 @@ int main(int argc, char **argv, char **envp) {
 		else if (strcmp(argv[i], "--private-tmp") == 0) {
 			arg_private_tmp = 1;
 		}
+		else if (strncmp(argv[i], "--tmpfs-options=", 16) == 0)
+			tmpfs_options_add(argv[i] + 16);
 #ifdef HAVE_USERTMPFS
 		else if (strcmp(argv[i], "--private-cache") == 0) {
 			if (checkcfg(CFG_PRIVATE_CACHE))
@@ -2171,6 +2207,26 @@ int main(int argc, char **argv, char **envp) {
 				return 1;
 			}
 		}
+		else if (strncmp(argv[i], "--pool=", 7) == 0) {
+			if (checkcfg(CFG_POOL))
+				pool_set(argv[i] + 7);
+			else
+				exit_err_feature("pool");
+		}
+		else if (strncmp(argv[i], "--batch=", 8) == 0) {
+			if (arg_batch) {
+				fprintf(stderr, "Error: only one --batch option is allowed\n");
+				exit(1);
+			}
+			arg_batch = argv[i] + 8;
+		}
+		else if (strncmp(argv[i], "--batch-jobs=", 13) == 0) {
+			arg_batch_jobs = atoi(argv[i] + 13);
+			if (arg_batch_jobs < 1 || arg_batch_jobs > 1024) {
+				fprintf(stderr, "Error: invalid --batch-jobs, use a number between 1 and 1024\n");
+				exit(1);
+			}
+		}
 		else if (strncmp(argv[i], "--hostname=", 11) == 0) {
 			cfg.hostname = argv[i] + 11;
 			if (strlen(cfg.hostname) == 0) {
@@ -2500,6 +2556,25 @@ int main(int argc, char **argv, char **envp) {
 			else
 				exit_err_feature("networking");
 		}
+		else if (strncmp(argv[i], "--veth-queues=", 14) == 0) {
+			if (checkcfg(CFG_NETWORK)) {
+				Bridge *br = last_bridge_configured();
+				if (br == NULL) {
+					fprintf(stderr, "Error: no network device configured\n");
+					exit(1);
+				}
+				if (strcmp(argv[i] + 14, "auto") == 0)
+					br->veth_queues = -1;
+				else if (sscanf(argv[i] + 14, "%d", &br->veth_queues) != 1 ||
+					 br->veth_queues < 1 || br->veth_queues > MAX_VETH_QUEUES) {
+					fprintf(stderr, "Error: invalid --veth-queues value, use a number between 1 and %d, or auto\n",
+						MAX_VETH_QUEUES);
+					exit(1);
+				}
+			}
+			else
+				exit_err_feature("networking");
+		}
 
 		else if (strcmp(argv[i], "--scan") == 0) {
 			if (checkcfg(CFG_NETWORK)) {
@@ -2508,6 +2583,17 @@ int main(int argc, char **argv, char **envp) {
 			else
 				exit_err_feature("networking");
 		}
+		else if (strncmp(argv[i], "--scan=", 7) == 0) {
+			if (checkcfg(CFG_NETWORK)) {
+				if (sscanf(argv[i] + 7, "%u", &arg_scan_rate) != 1 || arg_scan_rate == 0) {
+					fprintf(stderr, "Error: invalid --scan rate %s\n", argv[i] + 7);
+					exit(1);
+				}
+				arg_scan = 1;
+			}
+			else
+				exit_err_feature("networking");
+		}
 		else if (strncmp(argv[i], "--iprange=", 10) == 0) {
 			if (checkcfg(CFG_NETWORK)) {
 				Bridge *br = last_bridge_configured();
@@ -2673,6 +2759,26 @@ int main(int argc, char **argv, char **envp) {
 				exit_err_feature("networking");
 		}
 
+		else if (strncmp(argv[i], "--ip6-dad=", 10) == 0) {
+			if (checkcfg(CFG_NETWORK)) {
+				Bridge *br = last_bridge_configured();
+				if (br == NULL) {
+					fprintf(stderr, "Error: no network device configured\n");
+					exit(1);
+				}
+				const char *mode = argv[i] + 10;
+				if (strcmp(mode, "off") && strcmp(mode, "optimistic")) {
+					fprintf(stderr, "Error: invalid --ip6-dad value, use off or optimistic\n");
+					exit(1);
+				}
+				br->ip6dad = strdup(mode);
+				if (br->ip6dad == NULL)
+					errExit("strdup");
+			}
+			else
+				exit_err_feature("networking");
+		}
+
 
 		else if (strncmp(argv[i], "--defaultgw=", 12) == 0) {
 			if (checkcfg(CFG_NETWORK)) {
@@ -2860,6 +2966,10 @@ int main(int argc, char **argv, char **envp) {
 	if (arg_trace && arg_tracelog) {
 		fwarning("--trace and --tracelog are mutually exclusive; --tracelog disabled\n");
 	}
+	if (arg_trace && arg_trace_fanotify) {
+		fwarning("--trace and --trace-fanotify are mutually exclusive; --trace-fanotify disabled\n");
+		arg_trace_fanotify = 0;
+	}
 
 	// check user namespace (--noroot) options
 	if (arg_noroot) {
@@ -2987,6 +3097,18 @@ int main(int argc, char **argv, char **envp) {
 	if (need_preload && (cfg.seccomp_list32 || cfg.seccomp_list_drop32 || cfg.seccomp_list_keep32))
 		fwarning("preload libraries (trace, tracelog, postexecseccomp due to seccomp.drop=execve etc.) are incompatible with 32 bit filters\n");
 
+	// nothing has been set up yet, report what would be done and exit
+	if (arg_dry_run || arg_cost)
+		dry_run();
+
+	// pool manager; the warm sandboxes continue from here
+	if (arg_pool)
+		pool_main();
+
+	// batch manager; the sandboxes listed in the manifest continue from here
+	if (arg_batch)
+		batch_main();
+
 	// check and assign an IP address - for macvlan it will be done again in the sandbox!
 	if (any_bridge_configured()) {
 		EUID_ROOT();
@@ -3059,6 +3181,10 @@ int main(int argc, char **argv, char **envp) {
 	if (pipe2(child_to_parent_fds, O_CLOEXEC) < 0)
 		errExit("pipe");
 
+	// the join agent listens on a socket created outside the sandbox
+	if (arg_join_agent)
+		agent_create();
+
 	// clone environment
 	int flags = CLONE_NEWNS | CLONE_NEWPID | CLONE_NEWUTS | SIGCHLD;
 
@@ -3093,6 +3219,8 @@ int main(int argc, char **argv, char **envp) {
 	if (child == -1)
 		errExit("clone");
 	EUID_USER();
+	agent_close();
+	pool_close();
 
 	// sandbox pidfile
 	set_sandbox_run_file(getpid(), child);
@@ -278,3 +278,42 @@ char **build_mount_array(const int mountid, const char *path) {
 	rv[cnt] = NULL;
 	return rv;
 }
+
+// Return all the entries in /proc/self/mountinfo, in mount order.
+// The array and the strings are allocated in memory, the number of entries is stored in cnt.
+MountData *get_mount_table(size_t *cnt) {
+	assert(cnt);
+
+	FILE *fp = fopen("/proc/self/mountinfo", "re");
+	if (!fp) {
+		fprintf(stderr, "Error: cannot read /proc/self/mountinfo\n");
+		exit(1);
+	}
+
+	size_t size = 32;
+	MountData *rv = malloc(size * sizeof(*rv));
+	if (!rv)
+		errExit("malloc");
+
+	*cnt = 0;
+	MountData mntp;
+	char line[MAX_BUF];
+	while (fgets(line, MAX_BUF, fp)) {
+		parse_line(line, &mntp);
+		if (*cnt == size) {
+			size *= 2;
+			rv = realloc(rv, size * sizeof(*rv));
+			if (!rv)
+				errExit("realloc");
+		}
+		rv[*cnt].mountid = mntp.mountid;
+		rv[*cnt].fsname = strdup(mntp.fsname);
+		rv[*cnt].dir = strdup(mntp.dir);
+		rv[*cnt].fstype = strdup(mntp.fstype);
+		if (!rv[*cnt].fsname || !rv[*cnt].dir || !rv[*cnt].fstype)
+			errExit("strdup");
+		(*cnt)++;
+	}
+	fclose(fp);
+	return rv;
+}
@@ -141,6 +141,26 @@ void net_if_up(const char *ifname) {
 }
 
 
+// configure IPv6 duplicate address detection, before the interface is up
+void net_if_dad(const char *ifname, const char *mode) {
+	if (strlen(ifname) > IFNAMSIZ) {
+		fprintf(stderr, "Error: invalid network device name %s\n", ifname);
+		exit(1);
+	}
+	sbox_run(SBOX_ROOT | SBOX_CAPS_NETWORK | SBOX_SECCOMP, 5,
+		PATH_FNET, "config", "dad", ifname, mode);
+}
+
+// enable TSO/GSO/GRO on a multi-queue veth device
+void net_if_offload(const char *ifname) {
+	if (strlen(ifname) > IFNAMSIZ) {
+		fprintf(stderr, "Error: invalid network device name %s\n", ifname);
+		exit(1);
+	}
+	sbox_run(SBOX_ROOT | SBOX_CAPS_NETWORK | SBOX_SECCOMP, 4,
+		PATH_FNET, "config", "offload", ifname);
+}
+
 // configure interface ipv6 address
 // ex: firejail --net=eth0 --ip6=2001:0db8:0:f101::1/64
 void net_if_ip6(const char *ifname, const char *addr6) {
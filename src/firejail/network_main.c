@@ -135,6 +135,21 @@ void net_configure_sandbox_ip(Bridge *br) {
 }
 
 
+// number of queues for the veth pair, 0 for a single queue device
+int net_veth_queues(Bridge *br) {
+	assert(br);
+	if (br->veth_queues >= 0)
+		return br->veth_queues;
+
+	// one queue for each CPU the sandbox is allowed to run on
+	int queues = __builtin_popcount(cfg.cpus);
+	if (queues == 0)
+		queues = sysconf(_SC_NPROCESSORS_ONLN);
+	if (queues > MAX_VETH_QUEUES)
+		queues = MAX_VETH_QUEUES;
+	return (queues > 1) ? queues : 0;
+}
+
 // create a veth pair
 // - br - bridge device
 // - ifname - interface name in sandbox namespace
@@ -157,8 +172,17 @@ void net_configure_veth_pair(Bridge *br, const char *ifname, pid_t child) {
 	char *cstr;
 	if (asprintf(&cstr, "%d", child) == -1)
 		errExit("asprintf");
-	sbox_run(SBOX_ROOT | SBOX_CAPS_NETWORK | SBOX_SECCOMP, 7, PATH_FNET_MAIN, "create", "veth", dev, ifname, br->dev, cstr);
+	// both ends get the MTU of the bridge, or the one set with --mtu
+	char *mtustr;
+	if (asprintf(&mtustr, "%d", br->mtu) == -1)
+		errExit("asprintf");
+	char *qstr;
+	if (asprintf(&qstr, "%d", net_veth_queues(br)) == -1)
+		errExit("asprintf");
+	sbox_run(SBOX_ROOT | SBOX_CAPS_NETWORK | SBOX_SECCOMP, 9, PATH_FNET_MAIN, "create", "veth", dev, ifname, br->dev, cstr, mtustr, qstr);
 	free(cstr);
+	free(mtustr);
+	free(qstr);
 
 	char *msg;
 	if (asprintf(&msg, "%d.%d.%d.%d address assigned to sandbox", PRINT_IP(br->ipsandbox)) == -1)
@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "firejail.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/signalfd.h>
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+
+// --pool=name,N keeps N sandboxes configured with the same command line options
+// ready to run a program: namespaces created, filesystem mounted, privileges dropped
+// and seccomp filters built, waiting in sandbox() right before the application is
+// started. "firejail --launch=name program" hands the program to one of them, and
+// the pool starts a new sandbox in the background.
+//
+// Every warm sandbox is connected to the pool manager with a socket pair. The sandbox
+// writes a byte when it is ready; the manager sends it the client connection with
+// SCM_RIGHTS. The client request is the same as for the join agent (agent.c).
+#define POOL_MAX 64		// maximum number of warm sandboxes
+#define POOL_MAX_PENDING 256	// maximum number of clients waiting for a sandbox
+
+char *arg_pool = NULL;		// pool name
+static int pool_size = 0;
+static int pool_ctl = -1;	// warm sandbox: connection to the pool manager
+static int pool_conn = -1;	// warm sandbox: connection to the client
+static struct timespec pool_start;	// warm sandbox: time the request was received
+
+typedef struct {
+	pid_t pid;	// firejail process of the warm sandbox, 0 if the slot is empty
+	int ctl;	// connection to the sandbox
+	int ready;
+} PoolSlot;
+
+static PoolSlot slots[POOL_MAX];
+static volatile sig_atomic_t pool_stop = 0;
+
+// --pool=name,N
+void pool_set(const char *arg) {
+	assert(arg);
+	char *dup = strdup(arg);
+	if (!dup)
+		errExit("strdup");
+	char *size = strchr(dup, ',');
+	if (size)
+		*size++ = '\0';
+	if (*dup == '\0' || invalid_name(dup)) {
+		fprintf(stderr, "Error: invalid pool name\n");
+		exit(1);
+	}
+	pool_size = 1;
+	if (size) {
+		char *end;
+		long n = strtol(size, &end, 10);
+		if (*size == '\0' || *end != '\0' || n < 1 || n > POOL_MAX) {
+			fprintf(stderr, "Error: invalid pool size, use a number between 1 and %d\n", POOL_MAX);
+			exit(1);
+		}
+		pool_size = n;
+	}
+	arg_pool = dup;
+}
+
+// pools are private to the user: RUN_FIREJAIL_POOL_DIR/<uid>/<name>
+static char *pool_socket_name(const char *name) {
+	char *fname;
+	if (asprintf(&fname, "%s/%u/%s", RUN_FIREJAIL_POOL_DIR, getuid(), name) == -1)
+		errExit("asprintf");
+	return fname;
+}
+
+// the directory is owned by root, the user cannot replace the socket of a running pool
+static void pool_dir_create(void) {
+	char *dir;
+	if (asprintf(&dir, "%s/%u", RUN_FIREJAIL_POOL_DIR, getuid()) == -1)
+		errExit("asprintf");
+	EUID_ROOT();
+	if (mkdir(dir, 0755) == -1 && errno != EEXIST)
+		errExit("mkdir");
+	struct stat s;
+	if (lstat(dir, &s) == -1)
+		errExit("lstat");
+	EUID_USER();
+	if (!S_ISDIR(s.st_mode) || s.st_uid != 0 || (s.st_mode & 022)) {
+		fprintf(stderr, "Error: invalid pool directory %s\n", dir);
+		exit(1);
+	}
+	free(dir);
+}
+
+//***********************************************
+// warm sandbox
+//***********************************************
+// the parent doesn't need the connection to the manager after the sandbox was cloned
+void pool_close(void) {
+	if (pool_ctl != -1) {
+		close(pool_ctl);
+		pool_ctl = -1;
+	}
+}
+
+// called by the sandbox right before the application is started: wait for a
+// program from the pool manager and set it up as the application of the sandbox
+void pool_wait(void) {
+	if (pool_ctl == -1)
+		return;
+
+	// ready
+	char c = 0;
+	if (write(pool_ctl, &c, 1) != 1)
+		exit(1);
+
+	// receive the client connection; the pool is shutting down if the connection
+	// to the manager is closed
+	int conn;
+	char cbuf[CMSG_SPACE(sizeof(conn))];
+	struct iovec iov = { .iov_base = &c, .iov_len = 1 };
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+	ssize_t rv;
+	while ((rv = recvmsg(pool_ctl, &msg, MSG_CMSG_CLOEXEC)) == -1 && errno == EINTR)
+		;
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (rv != 1 || !cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(conn)))
+		exit(0);
+	memcpy(&conn, CMSG_DATA(cmsg), sizeof(conn));
+	close(pool_ctl);
+	pool_ctl = -1;
+
+	AgentCommand cmd;
+	if (agent_read_command(conn, &cmd))
+		exit(1);
+	agent_apply_command(&cmd);
+	pool_conn = conn;
+	pool_start = cmd.start;
+	if (arg_debug)
+		printf("Pool %s: starting %s\n", arg_pool, cfg.original_argv[1]);
+}
+
+// the application was forked; the client signals the firejail process of the sandbox
+void pool_started(void) {
+	if (pool_conn == -1)
+		return;
+	if (agent_reply(pool_conn, 0, sandbox_pid, &pool_start))
+		exit(1);
+}
+
+// report the exit status of the application to the client
+void pool_done(int status) {
+	if (pool_conn == -1)
+		return;
+	int rv = agent_reply(pool_conn, 1, status, &pool_start);
+	(void) rv;
+	close(pool_conn);
+	pool_conn = -1;
+}
+
+//***********************************************
+// pool manager
+//***********************************************
+static void pool_signal(int sig) {
+	(void) sig;
+	pool_stop = 1;
+}
+
+// fork a warm sandbox; returns 1 in the child, which continues with the regular
+// sandbox setup in main()
+static int pool_spawn(PoolSlot *slot, int listen_fd, int sfd) {
+	int sv[2];
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) == -1)
+		errExit("socketpair");
+
+	pid_t pid = fork();
+	if (pid == -1)
+		errExit("fork");
+	if (pid == 0) {
+		// the sandbox inherits the connection with clone()
+		close(sv[0]);
+		close(listen_fd);
+		close(sfd);
+		int i;
+		for (i = 0; i < POOL_MAX; i++) {
+			if (slots[i].pid)
+				close(slots[i].ctl);
+		}
+		signal(SIGINT, SIG_DFL);
+		signal(SIGTERM, SIG_DFL);
+		sigset_t mask;
+		sigemptyset(&mask);
+		sigprocmask(SIG_SETMASK, &mask, NULL);
+
+		pool_ctl = sv[1];
+		sandbox_pid = getpid();
+		if (!arg_debug)
+			arg_quiet = 1;
+		return 1;
+	}
+
+	close(sv[1]);
+	slot->pid = pid;
+	slot->ctl = sv[0];
+	slot->ready = 0;
+	if (arg_debug)
+		printf("Pool %s: warm sandbox %d\n", arg_pool, pid);
+	return 0;
+}
+
+static void pool_kill_idle(void) {
+	int i;
+	for (i = 0; i < POOL_MAX; i++) {
+		if (slots[i].pid) {
+			kill(slots[i].pid, SIGTERM);
+			close(slots[i].ctl);
+			slots[i].pid = 0;
+		}
+	}
+}
+
+// hand a client connection to a ready sandbox; return 0 if no sandbox is ready
+static int pool_dispatch(int conn) {
+	int i;
+	for (i = 0; i < pool_size; i++) {
+		if (slots[i].pid && slots[i].ready)
+			break;
+	}
+	if (i == pool_size)
+		return 0;
+
+	char c = 0;
+	char cbuf[CMSG_SPACE(sizeof(conn))];
+	memset(cbuf, 0, sizeof(cbuf));
+	struct iovec iov = { .iov_base = &c, .iov_len = 1 };
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(conn));
+	memcpy(CMSG_DATA(cmsg), &conn, sizeof(conn));
+	if (sendmsg(slots[i].ctl, &msg, MSG_NOSIGNAL) != 1) {
+		// the sandbox is gone, SIGCHLD will take care of the slot
+		slots[i].ready = 0;
+		return 0;
+	}
+
+	// the sandbox belongs to the client from now on
+	close(slots[i].ctl);
+	slots[i].pid = 0;
+	return 1;
+}
+
+// run the pool manager; returns only in a new warm sandbox
+void pool_main(void) {
+	EUID_ASSERT();
+	assert(arg_pool);
+	if (cfg.original_program_index) {
+		fprintf(stderr, "Error: --pool doesn't take a program, use firejail --launch=%s program\n", arg_pool);
+		exit(1);
+	}
+	if (cfg.name) {
+		fprintf(stderr, "Error: --pool and --name are mutually exclusive\n");
+		exit(1);
+	}
+
+	pool_dir_create();
+	char *fname = pool_socket_name(arg_pool);
+	struct stat s;
+	if (stat(fname, &s) == 0) {
+		int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd == -1)
+			errExit("socket");
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, fname, sizeof(addr.sun_path) - 1);
+		if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+			fprintf(stderr, "Error: pool %s is already running\n", arg_pool);
+			exit(1);
+		}
+		close(fd);
+	}
+	int listen_fd = agent_listen(fname);
+
+	// SIGCHLD is read from a signalfd
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+	int sfd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+	if (sfd == -1)
+		errExit("signalfd");
+	struct sigaction sga;
+	memset(&sga, 0, sizeof(sga));
+	sga.sa_handler = pool_signal;
+	sigaction(SIGINT, &sga, NULL);
+	sigaction(SIGTERM, &sga, NULL);
+	sigaction(SIGHUP, &sga, NULL);
+
+	int i;
+	for (i = 0; i < pool_size; i++) {
+		if (pool_spawn(&slots[i], listen_fd, sfd)) {
+			free(fname);
+			return;
+		}
+	}
+	fmessage("Pool %s: %d warm sandboxes, use firejail --launch=%s program\n",
+		arg_pool, pool_size, arg_pool);
+
+	int pending[POOL_MAX_PENDING];
+	int npending = 0;
+	while (!pool_stop) {
+		struct pollfd pfds[2 + POOL_MAX];
+		int nfds = 0;
+		pfds[nfds++] = (struct pollfd) { .fd = listen_fd, .events = POLLIN };
+		pfds[nfds++] = (struct pollfd) { .fd = sfd, .events = POLLIN };
+		int idx[POOL_MAX];
+		for (i = 0; i < pool_size; i++) {
+			if (slots[i].pid) {
+				idx[nfds - 2] = i;
+				pfds[nfds++] = (struct pollfd) { .fd = slots[i].ctl, .events = POLLIN };
+			}
+		}
+		if (poll(pfds, nfds, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			errExit("poll");
+		}
+
+		// reap the sandboxes; a sandbox exiting before it was ready is a setup error
+		if (pfds[1].revents) {
+			struct signalfd_siginfo si;
+			while (read(sfd, &si, sizeof(si)) > 0)
+				;
+			pid_t pid;
+			int status;
+			while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+				for (i = 0; i < pool_size; i++) {
+					if (slots[i].pid == pid) {
+						close(slots[i].ctl);
+						slots[i].pid = 0;
+						if (!slots[i].ready) {
+							fprintf(stderr, "Error: pool %s: cannot start the sandbox, "
+								"run firejail --debug --pool=%s,1 for details\n",
+								arg_pool, arg_pool);
+							pool_stop = 1;
+						}
+					}
+				}
+			}
+		}
+
+		// ready sandboxes
+		int n;
+		for (n = 2; n < nfds; n++) {
+			PoolSlot *slot = &slots[idx[n - 2]];
+			if (!pfds[n].revents || !slot->pid)
+				continue;
+			char c;
+			if (read(slot->ctl, &c, 1) == 1)
+				slot->ready = 1;
+			else {
+				// the sandbox is shutting down, it is reaped on SIGCHLD
+				close(slot->ctl);
+				kill(slot->pid, SIGTERM);
+				slot->pid = 0;
+			}
+		}
+
+		// new clients
+		if (pfds[0].revents) {
+			int conn = agent_accept(listen_fd);
+			if (conn != -1) {
+				if (npending < POOL_MAX_PENDING)
+					pending[npending++] = conn;
+				else
+					close(conn);
+			}
+		}
+
+		// hand the clients to the ready sandboxes in order
+		while (npending && pool_dispatch(pending[0])) {
+			close(pending[0]);
+			memmove(pending, pending + 1, --npending * sizeof(int));
+		}
+
+		// refill
+		if (pool_stop)
+			break;
+		for (i = 0; i < pool_size; i++) {
+			if (!slots[i].pid && pool_spawn(&slots[i], listen_fd, sfd)) {
+				free(fname);
+				return;
+			}
+		}
+	}
+
+	// the sandboxes already running a program are left alone
+	pool_kill_idle();
+	for (i = 0; i < npending; i++)
+		close(pending[i]);
+	EUID_ROOT();
+	int rv = unlink(fname);
+	(void) rv;
+	EUID_USER();
+	free(fname);
+	fmessage("Pool %s: shutting down\n", arg_pool);
+	exit(0);
+}
+
+//***********************************************
+// client
+//***********************************************
+// firejail --launch=name program
+void pool_launch(const char *name, int argc, char **argv, int index) {
+	EUID_ASSERT();
+	assert(name);
+	if (index < argc && strcmp(argv[index], "--") == 0)
+		index++;
+	if (index >= argc) {
+		fprintf(stderr, "Error: --launch requires a program\n");
+		exit(1);
+	}
+	if (invalid_name(name)) {
+		fprintf(stderr, "Error: invalid pool name\n");
+		exit(1);
+	}
+
+	char *fname = pool_socket_name(name);
+	int value;
+	uint64_t nsec;
+	int fd = agent_request(fname, argc, argv, index, &value, &nsec);
+	if (fd == -1) {
+		fprintf(stderr, "Error: cannot launch %s, pool %s is not running\n", argv[index], name);
+		exit(1);
+	}
+	free(fname);
+
+	// value is the firejail process of the sandbox, it shuts down the sandbox on signals
+	fmessage("Launched sandbox %d from pool %s in %.2f ms\n", value, name, (double) nsec / 1000000);
+	agent_wait(fd, value);
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "firejail.h"
+#include "../include/ldd_utils.h"
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <time.h>
+#define MAXBUF 4096
+
+// Start reading the application files into the page cache while the sandbox is being built,
+// so the application does not fault them in from the disk after it is started.
+
+pid_t prefetch_pid = 0;
+
+#define PREFETCH_MAX 512
+static char *prefetch_files[PREFETCH_MAX];
+static int prefetch_cnt = 0;
+static unsigned long long prefetch_size = 0;
+
+static int prefetched(const char *fname) {
+	int i;
+	for (i = 0; i < prefetch_cnt; i++) {
+		if (strcmp(prefetch_files[i], fname) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static void prefetch_file(const char *fname) {
+	assert(fname);
+	if (*fname != '/' || prefetch_cnt >= PREFETCH_MAX)
+		return;
+
+	if (prefetched(fname))
+		return;
+
+	// regular files only, devices and fifos are never opened; if fname is a symbolic link, stat and open follow it
+	struct stat s;
+	if (stat(fname, &s) == -1 || !S_ISREG(s.st_mode))
+		return;
+	int fd = open(fname, O_RDONLY|O_NONBLOCK|O_NOCTTY|O_CLOEXEC);
+	if (fd == -1)
+		return;
+	struct stat s2;
+	if (fstat(fd, &s2) == 0 && S_ISREG(s2.st_mode) && s.st_dev == s2.st_dev && s.st_ino == s2.st_ino) {
+		// asynchronous, the kernel queues the reads and returns
+		if (posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0) {
+			if (arg_debug)
+				printf("Prefetch %s\n", fname);
+			prefetch_size += s.st_size;
+		}
+	}
+	close(fd);
+
+	prefetch_files[prefetch_cnt] = strdup(fname);
+	if (!prefetch_files[prefetch_cnt])
+		errExit("strdup");
+	prefetch_cnt++;
+}
+
+#ifdef HAVE_PRIVATE_LIB
+// prefetch the libraries used by the executable, as reported by fldd
+static void prefetch_libs(const char *fname) {
+	assert(fname);
+	if (!is_lib_64(fname))
+		return;
+
+	// the process runs as the user already, fldd prints the libraries on stdout
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC) == -1)
+		errExit("pipe2");
+	pid_t child = fork();
+	if (child < 0)
+		errExit("fork");
+	if (child == 0) {
+		if (dup2(fds[1], STDOUT_FILENO) == -1)
+			errExit("dup2");
+		int fd = open("/dev/null", O_RDONLY|O_CLOEXEC);
+		if (fd != -1)
+			dup2(fd, STDIN_FILENO);
+		prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
+		execl(PATH_FLDD, PATH_FLDD, fname, NULL);
+		_exit(1);
+	}
+	close(fds[1]);
+
+	FILE *fp = fdopen(fds[0], "r");
+	if (!fp)
+		errExit("fdopen");
+	char buf[MAXBUF];
+	while (fgets(buf, MAXBUF, fp)) {
+		char *ptr = strchr(buf, '\n');
+		if (ptr)
+			*ptr = '\0';
+		prefetch_file(buf);
+	}
+	fclose(fp);
+	waitpid(child, NULL, 0);
+}
+#endif
+
+// return the full path of the program in allocated memory, or NULL
+static char *find_program(const char *name) {
+	assert(name);
+	return (strchr(name, '/'))? realpath(name, NULL): find_in_path(name);
+}
+
+static void prefetch_program(const char *name) {
+	char *fname = find_program(name);
+	if (!fname)
+		return;
+	struct stat s;
+	if (stat(fname, &s) == -1 || !S_ISREG(s.st_mode) || prefetched(fname)) {
+		free(fname);
+		return;
+	}
+#ifdef HAVE_PRIVATE_LIB
+	prefetch_libs(fname);
+#endif
+	// read the executable last, this is the first file needed by the application
+	prefetch_file(fname);
+	free(fname);
+}
+
+// fork a process reading the application files; called as root, after RUN_MNT_DIR was mounted
+void prefetch_start(void) {
+	// nothing is known about the application in a warm sandbox or in a chroot
+	if (arg_pool || cfg.chrootdir || arg_appimage)
+		return;
+	if (cfg.original_program_index <= 0 && !arg_private_bin)
+		return;
+
+	fflush(0);
+	pid_t child = fork();
+	if (child < 0)
+		errExit("fork");
+	if (child == 0) {
+		// the file list is built before the sandbox filesystem is in place
+		// files are opened with the user credentials; changing credentials resets the death signal
+		drop_privs(0);
+		prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+		struct timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		if (cfg.original_program_index > 0)
+			prefetch_program(cfg.original_argv[cfg.original_program_index]);
+
+		// private-bin programs are copied in the sandbox during setup
+		if (arg_private_bin && cfg.bin_private_keep) {
+			char *dlist = strdup(cfg.bin_private_keep);
+			if (!dlist)
+				errExit("strdup");
+			// find_in_path() uses strtok
+			char *ptr = dlist;
+			while (ptr) {
+				char *next = strchr(ptr, ',');
+				if (next)
+					*next++ = '\0';
+				if (*ptr && !strchr(ptr, '*') && !strchr(ptr, '/'))
+					prefetch_program(ptr);
+				ptr = next;
+			}
+			free(dlist);
+		}
+
+		struct timespec end;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		if (arg_debug)
+			printf("Prefetched %d files (%llu KB) in %.02f ms\n", prefetch_cnt, prefetch_size / 1024,
+			       (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0);
+		fflush(0);
+		_exit(0);
+	}
+
+	prefetch_pid = child;
+	if (arg_debug)
+		printf("Prefetch process started as pid %d\n", prefetch_pid);
+}
@@ -42,11 +42,14 @@ void preproc_build_firejail_dir(void) {
 	create_empty_dir_as_root(RUN_FIREJAIL_X11_DIR, 0755);
 	create_empty_dir_as_root(RUN_FIREJAIL_APPIMAGE_DIR, 0755);
 	create_empty_dir_as_root(RUN_FIREJAIL_LIB_DIR, 0755);
+	create_empty_dir_as_root(RUN_FIREJAIL_AGENT_DIR, 0755);
+	create_empty_dir_as_root(RUN_FIREJAIL_POOL_DIR, 0755);
 	create_empty_dir_as_root(RUN_MNT_DIR, 0755);
 
 	// restricted search permission
 	// only root should be able to lock files in this directory
 	create_empty_dir_as_root(RUN_FIREJAIL_SANDBOX_DIR, 0700);
+	create_empty_dir_as_root(RUN_FIREJAIL_TEMPLATE_DIR, 0700);
 
 	create_empty_dir_as_root(RUN_FIREJAIL_DBUS_DIR, 0755);
 	fs_remount(RUN_FIREJAIL_DBUS_DIR, MOUNT_NOEXEC, 0);
@@ -192,6 +195,7 @@ void preproc_clean_run(void) {
 	// clean profile and name directories
 	clean_dir(RUN_FIREJAIL_PROFILE_DIR, pidarr, start_pid, max_pids);
 	clean_dir(RUN_FIREJAIL_NAME_DIR, pidarr, start_pid, max_pids);
+	clean_dir(RUN_FIREJAIL_AGENT_DIR, pidarr, start_pid, max_pids);
 
 	free(pidarr);
 }
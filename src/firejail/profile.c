@@ -356,6 +356,21 @@ int profile_check_line(char *ptr, int lineno, const char *fname) {
 		arg_nonewprivs = 1;
 		return 0;
 	}
+	else if (strcmp(ptr, "join-agent") == 0) {
+		if (checkcfg(CFG_JOIN) || getuid() == 0)
+			arg_join_agent = 1;
+		else
+			warning_feature_disabled("join");
+		return 0;
+	}
+	else if (strcmp(ptr, "prefetch") == 0) {
+		arg_prefetch = 1;
+		return 0;
+	}
+	else if (strcmp(ptr, "proc-subset") == 0) {
+		arg_proc_subset = 1;
+		return 0;
+	}
 	else if (strcmp(ptr, "seccomp") == 0) {
 		if (checkcfg(CFG_SECCOMP))
 			arg_seccomp = 1;
@@ -439,6 +454,10 @@ int profile_check_line(char *ptr, int lineno, const char *fname) {
 		arg_private_tmp = 1;
 		return 0;
 	}
+	else if (strncmp(ptr, "tmpfs-options ", 14) == 0) {
+		tmpfs_options_add(ptr + 14);
+		return 0;
+	}
 	else if (strcmp(ptr, "nogroups") == 0) {
 		arg_nogroups = 1;
 		return 0;
@@ -741,6 +760,30 @@ int profile_check_line(char *ptr, int lineno, const char *fname) {
 		return 0;
 	}
 
+	else if (strncmp(ptr, "veth-queues ", 12) == 0) {
+#ifdef HAVE_NETWORK
+		if (checkcfg(CFG_NETWORK)) {
+			Bridge *br = last_bridge_configured();
+			if (br == NULL) {
+				fprintf(stderr, "Error: no network device configured\n");
+				exit(1);
+			}
+
+			if (strcmp(ptr + 12, "auto") == 0)
+				br->veth_queues = -1;
+			else if (sscanf(ptr + 12, "%d", &br->veth_queues) != 1 ||
+				 br->veth_queues < 1 || br->veth_queues > MAX_VETH_QUEUES) {
+				fprintf(stderr, "Error: invalid veth-queues value, use a number between 1 and %d, or auto\n",
+					MAX_VETH_QUEUES);
+				exit(1);
+			}
+		}
+		else
+			warning_feature_disabled("networking");
+#endif
+		return 0;
+	}
+
 	else if (strncmp(ptr, "iprange ", 8) == 0) {
 #ifdef HAVE_NETWORK
 		if (checkcfg(CFG_NETWORK)) {
@@ -934,6 +977,29 @@ int profile_check_line(char *ptr, int lineno, const char *fname) {
 		return 0;
 	}
 
+	else if (strncmp(ptr, "ip6-dad ", 8) == 0) {
+#ifdef HAVE_NETWORK
+		if (checkcfg(CFG_NETWORK)) {
+			Bridge *br = last_bridge_configured();
+			if (br == NULL) {
+				fprintf(stderr, "Error: no network device configured\n");
+				exit(1);
+			}
+			const char *mode = ptr + 8;
+			if (strcmp(mode, "off") && strcmp(mode, "optimistic")) {
+				fprintf(stderr, "Error: invalid ip6-dad value, use off or optimistic\n");
+				exit(1);
+			}
+			br->ip6dad = strdup(mode);
+			if (br->ip6dad == NULL)
+				errExit("strdup");
+		}
+		else
+			warning_feature_disabled("networking");
+#endif
+		return 0;
+	}
+
 	else if (strncmp(ptr, "defaultgw ", 10) == 0) {
 #ifdef HAVE_NETWORK
 		if (checkcfg(CFG_NETWORK)) {
@@ -1259,6 +1325,14 @@ int profile_check_line(char *ptr, int lineno, const char *fname) {
 		return 0;
 	}
 
+	if (strcmp(ptr, "fs-template") == 0) {
+		if (checkcfg(CFG_FS_TEMPLATE))
+			arg_fs_template = 1;
+		else
+			warning_feature_disabled("fs-template");
+		return 0;
+	}
+
 	if (strcmp(ptr, "keep-shell-rc") == 0) {
 		arg_keep_shell_rc = 1;
 		return 0;
@@ -25,44 +25,71 @@
 #include <glob.h>
 #include <dirent.h>
 #include <errno.h>
+#include <sys/file.h>
+#include <sys/sendfile.h>
 
 #include <fcntl.h>
 #ifndef O_PATH
 #define O_PATH 010000000
 #endif
 
-#define MAXBUF 1024
+// set of skipped user names, open addressing with linear probing;
+// /etc/passwd can have a very large number of users on LDAP-synced hosts
+typedef struct {
+	char **slot;
+	size_t size;	// power of 2
+	size_t cnt;
+} USER_SET;
+static USER_SET uset = { NULL, 0, 0 };
+
+static size_t uset_hash(const char *user) {
+	size_t h = 5381;
+	while (*user)
+		h = h * 33 + (unsigned char) *user++;
+	return h;
+}
 
-// linked list of users
-typedef struct user_list {
-	struct user_list *next;
-	const char *user;
-} USER_LIST;
-USER_LIST *ulist = NULL;
+static void uset_insert(char **slot, size_t size, char *user) {
+	size_t i = uset_hash(user) & (size - 1);
+	while (slot[i])
+		i = (i + 1) & (size - 1);
+	slot[i] = user;
+}
 
-static void ulist_add(const char *user) {
+static void uset_add(char *user) {
 	assert(user);
 
-	USER_LIST *nlist = malloc(sizeof(USER_LIST));
-	if (!nlist)
-		errExit("malloc");
-	memset(nlist, 0, sizeof(USER_LIST));
-	nlist->user = user;
-	nlist->next = ulist;
-	ulist = nlist;
+	// keep the table at most half full
+	if (2 * (uset.cnt + 1) > uset.size) {
+		size_t size = (uset.size) ? 2 * uset.size : 256;
+		char **slot = calloc(size, sizeof(char *));
+		if (!slot)
+			errExit("calloc");
+		size_t i;
+		for (i = 0; i < uset.size; i++) {
+			if (uset.slot[i])
+				uset_insert(slot, size, uset.slot[i]);
+		}
+		free(uset.slot);
+		uset.slot = slot;
+		uset.size = size;
+	}
+	uset_insert(uset.slot, uset.size, user);
+	uset.cnt++;
 }
 
-static USER_LIST *ulist_find(const char *user) {
+static int uset_find(const char *user) {
 	assert(user);
+	if (uset.cnt == 0)
+		return 0;
 
-	USER_LIST *ptr = ulist;
-	while (ptr) {
-		if (strcmp(ptr->user, user) == 0)
-			return ptr;
-		ptr = ptr->next;
+	size_t i = uset_hash(user) & (uset.size - 1);
+	while (uset.slot[i]) {
+		if (strcmp(uset.slot[i], user) == 0)
+			return 1;
+		i = (i + 1) & (uset.size - 1);
 	}
-
-	return NULL;
+	return 0;
 }
 
 static void sanitize_home(void) {
@@ -157,10 +184,11 @@ static void sanitize_run(void) {
 	free(runuser);
 }
 
-static void sanitize_passwd(void) {
+// build RUN_PASSWD_FILE; returns 1 if OK, 0 if failed
+static int sanitize_passwd(void) {
 	struct stat s;
 	if (stat("/etc/passwd", &s) == -1)
-		return;
+		return 0;
 	assert(uid_min);
 	if (arg_debug)
 		printf("Sanitizing /etc/passwd, UID_MIN %d\n", uid_min);
@@ -171,6 +199,8 @@ static void sanitize_passwd(void) {
 
 	FILE *fpin = NULL;
 	FILE *fpout = NULL;
+	char *buf = NULL;
+	size_t bufsize = 0;
 
 	// open files
 	/* coverity[toctou] */
@@ -182,9 +212,8 @@ static void sanitize_passwd(void) {
 		goto errout;
 
 	// read the file line by line
-	char buf[MAXBUF];
 	uid_t myuid = getuid();
-	while (fgets(buf, MAXBUF, fpin)) {
+	while (getline(&buf, &bufsize, fpin) != -1) {
 		// comments and empty lines
 		if (*buf == '\0' || *buf == '#')
 			continue;
@@ -225,33 +254,25 @@ static void sanitize_passwd(void) {
 			char *user = strdup(buf);
 			if (!user)
 				errExit("malloc");
-			ulist_add(user);
+			uset_add(user);
 			continue; // skip line
 		}
 		fprintf(fpout, "%s", buf);
 	}
+	free(buf);
 	fclose(fpin);
 	SET_PERMS_STREAM(fpout, 0, 0, 0644);
 	fclose(fpout);
-
-	// mount-bind the new password file
-	if (mount(RUN_PASSWD_FILE, "/etc/passwd", "none", MS_BIND, "mode=400,gid=0") < 0)
-		errExit("mount");
-
-	// blacklist RUN_PASSWD_FILE
-	if (mount(RUN_RO_FILE, RUN_PASSWD_FILE, "none", MS_BIND, "mode=400,gid=0") < 0)
-		errExit("mount");
-
-	fs_logger("create /etc/passwd");
-
-	return;
+	return 1;
 
 errout:
 	fwarning("failed to clean up /etc/passwd\n");
+	free(buf);
 	if (fpin)
 		fclose(fpin);
 	if (fpout)
 		fclose(fpout);
+	return 0;
 }
 
 // returns 1 if fails, 0 if OK
@@ -282,7 +303,7 @@ static int copy_line(FILE *fpout, char *buf, char *ptr) {
 	int first = 1;
 	while (token) {
 		char *newtoken = strtok(NULL, ",\n");
-		if (ulist_find(token)) {
+		if (uset_find(token)) {
 			//skip
 			token = newtoken;
 			continue;
@@ -297,10 +318,11 @@ static int copy_line(FILE *fpout, char *buf, char *ptr) {
 	return 0;
 }
 
-static void sanitize_group(void) {
+// build RUN_GROUP_FILE; returns 1 if OK, 0 if failed
+static int sanitize_group(void) {
 	struct stat s;
 	if (stat("/etc/group", &s) == -1)
-		return;
+		return 0;
 	assert(gid_min);
 	if (arg_debug)
 		printf("Sanitizing /etc/group, GID_MIN %d\n", gid_min);
@@ -311,6 +333,8 @@ static void sanitize_group(void) {
 
 	FILE *fpin = NULL;
 	FILE *fpout = NULL;
+	char *buf = NULL;	// group lines can be very long
+	size_t bufsize = 0;
 
 	// open files
 	/* coverity[toctou] */
@@ -322,9 +346,8 @@ static void sanitize_group(void) {
 		goto errout;
 
 	// read the file line by line
-	char buf[MAXBUF];
 	gid_t mygid = getgid();
-	while (fgets(buf, MAXBUF, fpin)) {
+	while (getline(&buf, &bufsize, fpin) != -1) {
 		// comments and empty lines
 		if (*buf == '\0' || *buf == '#')
 			continue;
@@ -365,28 +388,208 @@ static void sanitize_group(void) {
 		if (copy_line(fpout, buf, ptr))
 			goto errout;
 	}
+	free(buf);
 	fclose(fpin);
 	SET_PERMS_STREAM(fpout, 0, 0, 0644);
 	fclose(fpout);
-
-	// mount-bind the new group file
-	if (mount(RUN_GROUP_FILE, "/etc/group", "none", MS_BIND, "mode=400,gid=0") < 0)
-		errExit("mount");
-
-	// blacklist RUN_GROUP_FILE
-	if (mount(RUN_RO_FILE, RUN_GROUP_FILE, "none", MS_BIND, "mode=400,gid=0") < 0)
-		errExit("mount");
-
-	fs_logger("create /etc/group");
-
-	return;
+	return 1;
 
 errout:
 	fwarning("failed to clean up /etc/group\n");
+	free(buf);
 	if (fpin)
 		fclose(fpin);
 	if (fpout)
 		fclose(fpout);
+	return 0;
+}
+
+// mount-bind the sanitized file and blacklist the original in RUN_MNT_DIR
+static void install_file(const char *runfile, const char *fname) {
+	if (mount(runfile, fname, "none", MS_BIND, "mode=400,gid=0") < 0)
+		errExit("mount");
+	if (mount(RUN_RO_FILE, runfile, "none", MS_BIND, "mode=400,gid=0") < 0)
+		errExit("mount");
+	fs_logger2("create", fname);
+}
+
+//***********************************************
+// sanitized files cache
+//***********************************************
+// The sanitized /etc/passwd and /etc/group depend only on the source files, the user
+// and UID_MIN/GID_MIN. They are saved in a root-only directory and reused as long as
+// the source inodes are unchanged, so a large passwd database is not parsed on every launch.
+// Layout: RUN_FIREJAIL_TEMPLATE_DIR/<uid>/users/{state,passwd,group}
+typedef struct {
+	dev_t dev[2];
+	ino_t ino[2];
+	off_t size[2];
+	struct timespec mtim[2];
+	struct timespec ctim[2];
+	uid_t uid;
+	gid_t gid;
+	int uid_min;
+	int gid_min;
+} USERS_STATE;
+
+// returns 1 if OK, 0 if one of the files is missing
+static int users_state(USERS_STATE *state) {
+	const char *files[2] = { "/etc/passwd", "/etc/group" };
+
+	memset(state, 0, sizeof(USERS_STATE));	// the padding is compared too
+	int i;
+	for (i = 0; i < 2; i++) {
+		// symbolic links are rejected by sanitize_passwd() and sanitize_group()
+		struct stat s;
+		if (lstat(files[i], &s) == -1 || !S_ISREG(s.st_mode))
+			return 0;
+		state->dev[i] = s.st_dev;
+		state->ino[i] = s.st_ino;
+		state->size[i] = s.st_size;
+		state->mtim[i] = s.st_mtim;
+		state->ctim[i] = s.st_ctim;
+	}
+	state->uid = getuid();
+	state->gid = getgid();
+	state->uid_min = uid_min;
+	state->gid_min = gid_min;
+	return 1;
+}
+
+// copy a regular file; returns 0 if OK, -1 if failed
+static int copy_at(int srcdir, const char *src, int dstdir, const char *dst) {
+	int sfd = openat(srcdir, src, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (sfd == -1)
+		return -1;
+	int dfd = openat(dstdir, dst, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (dfd == -1) {
+		close(sfd);
+		return -1;
+	}
+
+	int rv = 0;
+	struct stat s;
+	if (fstat(sfd, &s) == -1 || !S_ISREG(s.st_mode))
+		rv = -1;
+	off_t left = (rv == 0) ? s.st_size : 0;
+	while (left > 0) {
+		ssize_t len = sendfile(dfd, sfd, NULL, left);
+		if (len <= 0) {
+			rv = -1;
+			break;
+		}
+		left -= len;
+	}
+	if (rv == 0 && (fchown(dfd, 0, 0) == -1 || fchmod(dfd, 0644) == -1))
+		rv = -1;
+
+	close(sfd);
+	close(dfd);
+	return rv;
+}
+
+static int cache_open(int create) {
+	char *udir;
+	char *dir;
+	if (asprintf(&udir, "%s/%u", RUN_FIREJAIL_TEMPLATE_DIR, getuid()) == -1 ||
+	    asprintf(&dir, "%s/users", udir) == -1)
+		errExit("asprintf");
+	if (create) {
+		mkdir(udir, 0700);
+		mkdir(dir, 0700);
+	}
+
+	int fd = open(dir, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	free(udir);
+	free(dir);
+	if (fd == -1)
+		return -1;
+
+	// root-owned; anything else was not created by us
+	struct stat s;
+	if (fstat(fd, &s) == -1 || s.st_uid != 0 || (s.st_mode & 0077)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// returns 1 if RUN_PASSWD_FILE and RUN_GROUP_FILE were restored from the cache
+static int cache_restore(const USERS_STATE *state) {
+	int fd = cache_open(0);
+	if (fd == -1)
+		return 0;
+	// another sandbox might be updating the cache right now
+	if (flock(fd, LOCK_SH | LOCK_NB) == -1) {
+		close(fd);
+		return 0;
+	}
+
+	int rv = 0;
+	USERS_STATE saved;
+	int sfd = openat(fd, "state", O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (sfd != -1) {
+		if (read(sfd, &saved, sizeof(saved)) == sizeof(saved) &&
+		    memcmp(&saved, state, sizeof(saved)) == 0 &&
+		    copy_at(fd, "passwd", AT_FDCWD, RUN_PASSWD_FILE) == 0 &&
+		    copy_at(fd, "group", AT_FDCWD, RUN_GROUP_FILE) == 0)
+			rv = 1;
+		close(sfd);
+	}
+	close(fd);
+
+	if (rv && arg_debug)
+		printf("Sanitized /etc/passwd and /etc/group restored from cache\n");
+	return rv;
+}
+
+static void cache_save(const USERS_STATE *state) {
+	int fd = cache_open(1);
+	if (fd == -1)
+		return;
+	if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+		close(fd);
+		return;
+	}
+
+	// the state file goes in last
+	unlinkat(fd, "state", 0);
+	int ok = 0;
+	if (copy_at(AT_FDCWD, RUN_PASSWD_FILE, fd, "passwd") == 0 &&
+	    copy_at(AT_FDCWD, RUN_GROUP_FILE, fd, "group") == 0) {
+		int sfd = openat(fd, "state", O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+		if (sfd != -1) {
+			if (write(sfd, state, sizeof(USERS_STATE)) == sizeof(USERS_STATE))
+				ok = 1;
+			close(sfd);
+		}
+	}
+	if (!ok)
+		unlinkat(fd, "state", 0);
+	else if (arg_debug)
+		printf("Sanitized /etc/passwd and /etc/group saved in cache\n");
+	close(fd);
+}
+
+static void sanitize_users(void) {
+	USERS_STATE state;
+	int have_state = users_state(&state);
+
+	int passwd_ok = 0;
+	int group_ok = 0;
+	if (have_state && cache_restore(&state))
+		passwd_ok = group_ok = 1;
+	else {
+		passwd_ok = sanitize_passwd();
+		group_ok = sanitize_group();
+		if (have_state && passwd_ok && group_ok)
+			cache_save(&state);
+	}
+
+	if (passwd_ok)
+		install_file(RUN_PASSWD_FILE, "/etc/passwd");
+	if (group_ok)
+		install_file(RUN_GROUP_FILE, "/etc/group");
 }
 
 void restrict_users(void) {
@@ -407,7 +610,6 @@ void restrict_users(void) {
 			fs_logger("tmpfs /home");
 		}
 		sanitize_run();
-		sanitize_passwd();
-		sanitize_group();
+		sanitize_users();
 	}
 }
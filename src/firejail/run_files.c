@@ -84,6 +84,7 @@ void delete_run_files(pid_t pid) {
 	delete_name_run_file(pid);
 	delete_x11_run_file(pid);
 	delete_profile_run_file(pid);
+	agent_delete(pid);
 }
 
 static char *newname(char *name) {
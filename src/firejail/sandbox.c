@@ -229,6 +229,11 @@ static void sandbox_if_up(Bridge *br) {
 		return;
 
 	char *dev = br->devsandbox;
+	// the link-local address is generated when the interface goes up
+	if (br->ip6dad)
+		net_if_dad(dev, br->ip6dad);
+	if (br->macvlan == 0 && net_veth_queues(br) > 1)
+		net_if_offload(dev);
 	net_if_up(dev);
 
 	if (br->arg_ip_none == 1);	// do nothing
@@ -390,7 +395,13 @@ static int monitor_application(pid_t app_pid) {
 				continue;
 			if (pid == 1)
 				continue;
-			if ((pid_t) pid == dhclient4_pid || (pid_t) pid == dhclient6_pid)
+			if ((pid_t) pid == dhcp_pid)
+				continue;
+			if ((pid_t) pid == agent_pid)
+				continue;
+			if ((pid_t) pid == prefetch_pid)
+				continue;
+			if ((pid_t) pid == trace_fanotify_pid)
 				continue;
 
 			monitored_pid = pid;
@@ -697,8 +708,9 @@ int sandbox(void* sandbox_arg) {
 	if (mount(LIBDIR "/firejail", RUN_FIREJAIL_LIB_DIR, NULL, MS_BIND, NULL) < 0 ||
 	    mount(NULL, RUN_FIREJAIL_LIB_DIR, NULL, MS_RDONLY|MS_NOSUID|MS_NODEV|MS_BIND|MS_REMOUNT, NULL) < 0)
 		errExit("mounting " RUN_FIREJAIL_LIB_DIR);
-	// keep a copy of dhclient executable before the filesystem is modified
-	dhcp_store_exec();
+	// start reading the application files while the filesystem is being built
+	if (arg_prefetch)
+		prefetch_start();
 
 	//****************************
 	// log sandbox data
@@ -800,7 +812,14 @@ int sandbox(void* sandbox_arg) {
 		if (any_bridge_configured() || any_interface_configured() || cfg.defaultgw || cfg.dns1) {
 			fmessage("\n");
 			if (any_bridge_configured() || any_interface_configured()) {
-				if (arg_scan)
+				if (arg_scan && arg_scan_rate) {
+					char *rate;
+					if (asprintf(&rate, "%u", arg_scan_rate) == -1)
+						errExit("asprintf");
+					sbox_run(SBOX_ROOT | SBOX_CAPS_NETWORK | SBOX_SECCOMP, 4, PATH_FNET, "printif", "scan", rate);
+					free(rate);
+				}
+				else if (arg_scan)
 					sbox_run(SBOX_ROOT | SBOX_CAPS_NETWORK | SBOX_SECCOMP, 3, PATH_FNET, "printif", "scan");
 				else
 					sbox_run(SBOX_ROOT | SBOX_CAPS_NETWORK | SBOX_SECCOMP, 2, PATH_FNET, "printif");
@@ -865,6 +884,10 @@ int sandbox(void* sandbox_arg) {
 	// store hosts file
 	fs_store_hosts_file();
 
+	// the template directory is not visible in the sandbox
+	if (arg_fs_template)
+		fs_template_init();
+
 	//****************************
 	// configure filesystem
 	//****************************
@@ -1076,6 +1099,9 @@ int sandbox(void* sandbox_arg) {
 	fs_blacklist(); // mkdir and mkfile are processed all over again
 	EUID_ROOT();
 
+	// all the tmpfs filesystems are mounted by now
+	tmpfs_options_check();
+
 	//****************************
 	// nosound/no3d/notv/novideo and fix for pulseaudio 7.0
 	//****************************
@@ -1258,6 +1284,8 @@ int sandbox(void* sandbox_arg) {
 	//****************************
 	if (need_preload)
 		fs_trace();
+	if (arg_trace_fanotify)
+		trace_fanotify_start();
 
 	//****************************
 	// continue security filters
@@ -1269,6 +1297,7 @@ int sandbox(void* sandbox_arg) {
 	// relay status information to join option
 	//****************************************
 	char *set_sandbox_status = create_join_file();
+	join_state_save();
 
 	//****************************************
 	// create a new user namespace
@@ -1326,6 +1355,19 @@ int sandbox(void* sandbox_arg) {
 	if (cfg.cpus)
 		set_cpu_affinity();
 
+	//****************************************
+	// warm sandbox: wait for the application
+	//****************************************
+	if (arg_pool)
+		pool_wait();
+
+	//****************************************
+	// start the join agent
+	//****************************************
+	if (arg_join_agent)
+		agent_start();
+	batch_started();
+
 	//****************************************
 	// fork the application and monitor it
 	//****************************************
@@ -1337,9 +1379,13 @@ int sandbox(void* sandbox_arg) {
 		start_application(0, -1, set_sandbox_status);	// this function does not return
 	}
 
+	trace_fanotify_app(app_pid);
 	munmap(set_sandbox_status, 1);
+	pool_started();
 
 	int status = monitor_application(app_pid);	// monitor application
+	trace_fanotify_stop();
+	pool_done(status);
 
 	if (WIFEXITED(status)) {
 		// if we had a proper exit, return that exit status
@@ -293,6 +293,10 @@ int sbox_run(unsigned filtermask, int num, ...) {
 int sbox_run_v(unsigned filtermask, char * const arg[]) {
 	assert(arg);
 
+	// --batch: seccomp filters already built by the first sandbox
+	if (batch_helper_cached(arg))
+		return 0;
+
 	if (arg_debug) {
 		printf("sbox run: ");
 		int i = 0;
@@ -323,6 +327,7 @@ int sbox_run_v(unsigned filtermask, char * const arg[]) {
 		fprintf(stderr, "Error: failed to run %s, exiting...\n", arg[0]);
 		exit(1);
 	}
+	batch_helper_store(arg);
 
 	return status;
 }
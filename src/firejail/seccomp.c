@@ -127,6 +127,24 @@ void seccomp_load_file_list(void) {
 }
 
 
+// queue a filter for seccomp_install_filters(); name is only used for debug messages
+void seccomp_load_prog(const char *name, struct sock_filter *filter, unsigned short entries) {
+	assert(name);
+	assert(filter);
+	FilterList *fl = malloc(sizeof(FilterList));
+	if (!fl) {
+		fprintf(stderr, "Error: cannot allocate memory\n");
+		exit(1);
+	}
+	fl->next = filter_list_head;
+	fl->prog.len = entries;
+	fl->prog.filter = filter;
+	fl->fname = strdup(name);
+	if (fl->fname == NULL)
+		errExit("strdup");
+	filter_list_head = fl;
+}
+
 int seccomp_load(const char *fname) {
 	assert(fname);
 
@@ -151,18 +169,7 @@ int seccomp_load(const char *fname) {
 	// close file
 	close(fd);
 
-	FilterList *fl = malloc(sizeof(FilterList));
-	if (!fl) {
-		fprintf(stderr, "Error: cannot allocate memory\n");
-		exit(1);
-	}
-	fl->next = filter_list_head;
-	fl->prog.len = entries;
-	fl->prog.filter = filter;
-	fl->fname = strdup(fname);
-	if (fl->fname == NULL)
-		errExit("strdup");
-	filter_list_head = fl;
+	seccomp_load_prog(fname, filter, entries);
 
 	if (arg_debug && access(PATH_FSEC_PRINT, X_OK) == 0) {
 		sbox_run(SBOX_USER | SBOX_CAPS_NONE | SBOX_SECCOMP, 2,
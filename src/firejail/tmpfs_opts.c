@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include "firejail.h"
+#include <sys/mount.h>
+#include <sys/sysinfo.h>
+#include <limits.h>
+#include <errno.h>
+
+// tmpfs-options dir,option,option...
+typedef struct tmpfs_opts_t {
+	struct tmpfs_opts_t *next;
+	char *dir;
+	char *options;	// comma separated list, ready to be passed to mount(2)
+	int used;	// a tmpfs was mounted with these options
+} TmpfsOpts;
+
+static TmpfsOpts *tmpfs_opts = NULL;
+
+static void opt_err(const char *opt, const char *msg) {
+	fprintf(stderr, "Error: invalid tmpfs option \"%s\": %s\n", opt, msg);
+	exit(1);
+}
+
+// parse a number with an optional k/m/g suffix; return 0 if invalid
+static unsigned long long parse_size(const char *str, int *percent) {
+	char *end;
+	errno = 0;
+	unsigned long long val = strtoull(str, &end, 10);
+	if (errno || end == str || *str == '-')
+		return 0;
+
+	*percent = 0;
+	unsigned long long mult = 1;
+	switch (*end) {
+	case '\0':
+		break;
+	case 'k':
+	case 'K':
+		mult = 1024ULL;
+		end++;
+		break;
+	case 'm':
+	case 'M':
+		mult = 1024ULL * 1024;
+		end++;
+		break;
+	case 'g':
+	case 'G':
+		mult = 1024ULL * 1024 * 1024;
+		end++;
+		break;
+	case '%':
+		*percent = 1;
+		end++;
+		break;
+	default:
+		return 0;
+	}
+	if (*end != '\0' || val > ULLONG_MAX / mult)
+		return 0;
+	return val * mult;
+}
+
+static void check_option(const char *opt) {
+	int percent;
+
+	if (strncmp(opt, "size=", 5) == 0) {
+		unsigned long long size = parse_size(opt + 5, &percent);
+		if (size == 0)
+			opt_err(opt, "use a positive number with an optional k, m, g or % suffix");
+		if (percent) {
+			if (size > 100)
+				opt_err(opt, "the size cannot exceed 100% of RAM");
+			return;
+		}
+		// a tmpfs larger than the physical memory is only good for filling up the swap
+		struct sysinfo si;
+		if (sysinfo(&si) == 0 && size > (unsigned long long) si.totalram * si.mem_unit)
+			opt_err(opt, "the size cannot exceed the physical memory");
+	}
+	else if (strncmp(opt, "nr_inodes=", 10) == 0) {
+		if (parse_size(opt + 10, &percent) == 0 || percent)
+			opt_err(opt, "use a positive number with an optional k, m or g suffix");
+	}
+	else if (strncmp(opt, "huge=", 5) == 0) {
+		const char *val = opt + 5;
+		if (strcmp(val, "never") != 0 && strcmp(val, "always") != 0 &&
+		    strcmp(val, "within_size") != 0 && strcmp(val, "advise") != 0)
+			opt_err(opt, "use never, always, within_size or advise");
+		// tmpfs huge pages require CONFIG_TRANSPARENT_HUGEPAGE
+		if (strcmp(val, "never") != 0 &&
+		    access("/sys/kernel/mm/transparent_hugepage/shmem_enabled", F_OK) != 0)
+			opt_err(opt, "huge pages on tmpfs are not supported by the kernel");
+	}
+	else if (strcmp(opt, "noswap") == 0) {
+		// Linux 6.4 or newer, checked when the filesystem is mounted; the kernel
+		// allows it to any mount in the init user namespace, firejail mounts as root
+		if (getuid() != 0 && !checkcfg(CFG_TMPFS_NOSWAP))
+			opt_err(opt, "memory that cannot be swapped out is restricted to root, see tmpfs-noswap in firejail.config");
+	}
+	else
+		opt_err(opt, "use size=, nr_inodes=, huge= or noswap");
+}
+
+// memory pinned by a noswap tmpfs with these options, 0 if the filesystem can be swapped out
+static unsigned long long noswap_size(const char *options, unsigned long long ram) {
+	char *dup = strdup(options);
+	if (!dup)
+		errExit("strdup");
+	int noswap = 0;
+	unsigned long long size = ram / 2;	// tmpfs default
+	char *ptr = strtok(dup, ",");
+	while (ptr) {
+		int percent;
+		if (strcmp(ptr, "noswap") == 0)
+			noswap = 1;
+		else if (strncmp(ptr, "size=", 5) == 0) {
+			size = parse_size(ptr + 5, &percent);
+			if (percent)
+				size = ram / 100 * size;
+		}
+		ptr = strtok(NULL, ",");
+	}
+	free(dup);
+	return (noswap)? size: 0;
+}
+
+// all the noswap filesystems together cannot lock more than half of the physical memory
+static void check_noswap_total(void) {
+	struct sysinfo si;
+	if (sysinfo(&si) != 0)
+		return;
+	unsigned long long ram = (unsigned long long) si.totalram * si.mem_unit;
+
+	unsigned long long total = 0;
+	TmpfsOpts *t = tmpfs_opts;
+	while (t) {
+		total += noswap_size(t->options, ram);
+		t = t->next;
+	}
+	if (total > ram / 2) {
+		fprintf(stderr, "Error: tmpfs filesystems mounted with noswap cannot exceed half of the physical memory, "
+			"set a smaller size\n");
+		exit(1);
+	}
+}
+
+// store the options for a directory; arg is "dir,option,option..."
+void tmpfs_options_add(const char *arg) {
+	assert(arg);
+
+	char *dup = strdup(arg);
+	if (!dup)
+		errExit("strdup");
+	char *options = strchr(dup, ',');
+	if (!options || options[1] == '\0') {
+		fprintf(stderr, "Error: invalid tmpfs-options command, use tmpfs-options directory,option[,option]\n");
+		exit(1);
+	}
+	*options++ = '\0';
+
+	char *dir = expand_macros(dup);
+	trim_trailing_slash_or_dot(dir);
+	if (*dir != '/' || strstr(dir, "..")) {
+		fprintf(stderr, "Error: invalid directory %s in tmpfs-options command\n", dup);
+		exit(1);
+	}
+
+	char *opts = strdup(options);
+	if (!opts)
+		errExit("strdup");
+	char *ptr = strtok(options, ",");
+	while (ptr) {
+		check_option(ptr);
+		ptr = strtok(NULL, ",");
+	}
+
+	// the last command wins
+	TmpfsOpts *t = tmpfs_opts;
+	while (t) {
+		if (strcmp(t->dir, dir) == 0)
+			break;
+		t = t->next;
+	}
+	if (t) {
+		free(t->options);
+		free(dir);
+	}
+	else {
+		t = malloc(sizeof(TmpfsOpts));
+		if (!t)
+			errExit("malloc");
+		t->dir = dir;
+		t->used = 0;
+		t->next = tmpfs_opts;
+		tmpfs_opts = t;
+	}
+	t->options = opts;
+	check_noswap_total();
+	if (arg_debug)
+		printf("tmpfs options for %s: %s\n", t->dir, t->options);
+	free(dup);
+}
+
+static TmpfsOpts *find_options(const char *dir) {
+	TmpfsOpts *t = tmpfs_opts;
+	while (t) {
+		if (strcmp(t->dir, dir) == 0)
+			return t;
+		t = t->next;
+	}
+	return NULL;
+}
+
+// return the options configured for a directory, or NULL
+const char *tmpfs_options(const char *dir) {
+	assert(dir);
+	TmpfsOpts *t = find_options(dir);
+	return (t)? t->options: NULL;
+}
+
+// append the options configured for dir to the default options;
+// return the new string in allocated memory
+char *tmpfs_options_build(const char *dir, const char *defaults) {
+	assert(dir);
+	assert(defaults);
+	TmpfsOpts *t = find_options(dir);
+	char *rv;
+	if (t) {
+		t->used = 1;
+		if (asprintf(&rv, "%s,%s", defaults, t->options) == -1)
+			errExit("asprintf");
+	}
+	else if (!(rv = strdup(defaults)))
+		errExit("strdup");
+	return rv;
+}
+
+// called after the filesystem was configured: options for a directory
+// that never received a tmpfs, such as /dev/shm without private-dev, have no effect
+void tmpfs_options_check(void) {
+	TmpfsOpts *t = tmpfs_opts;
+	while (t) {
+		if (!t->used)
+			fwarning("tmpfs-options %s not used, no tmpfs was mounted on this directory\n", t->dir);
+		t = t->next;
+	}
+}
+
+// report the error for a failed tmpfs mount and exit
+void tmpfs_options_err(const char *dir) {
+	assert(dir);
+	const char *opts = tmpfs_options(dir);
+	if (opts && errno == EINVAL) {
+		fprintf(stderr, "Error: cannot mount tmpfs on %s with %s, check kernel support for these options\n",
+			dir, opts);
+		exit(1);
+	}
+	errExit("mounting tmpfs");
+}
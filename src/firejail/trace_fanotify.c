@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "firejail.h"
+#include <sys/fanotify.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <signal.h>
+#include <poll.h>
+#include <errno.h>
+#include <fcntl.h>
+
+// File access tracing without LD_PRELOAD: every mount in the sandbox mount namespace
+// is marked with fanotify, and a separate process prints the open events in the same
+// format as libtrace. Statically linked programs are traced as well, and the traced
+// processes only pay for queueing the event in the kernel.
+
+pid_t trace_fanotify_pid = 0;
+static int trace_ctl[2] = {-1, -1};	// the sandbox sends the process ids, and stops the tracer
+static pid_t trace_agent = 0;
+static pid_t trace_app = 0;
+static int trace_app_exec = 0;	// the application is running firejail code until its first execve
+
+#define TRACE_BUF (64 * 1024)
+#define TRACE_MASK (FAN_OPEN | FAN_ONDIR)
+
+static FILE *trace_out = NULL;
+
+// process names, indexed by pid; fanotify events carry only the pid, and by the time the event
+// is read the process might have exited or executed another program
+#define COMM_MAX 1024
+typedef struct {
+	pid_t pid;
+	int exec;	// the last event was an exec
+	char comm[16];	// TASK_COMM_LEN
+} CommEntry;
+static CommEntry comm_table[COMM_MAX];
+
+// the trace is parsed line by line in fbuilder
+static void sanitize(char *str) {
+	for (; *str; str++) {
+		if ((unsigned char) *str < 0x20 || *str == 0x7f)
+			*str = '?';
+	}
+}
+
+static CommEntry *trace_comm(pid_t pid) {
+	CommEntry *entry = &comm_table[pid % COMM_MAX];
+	if (entry->pid == pid)
+		return entry;
+
+	// a new process: the name is inherited from the parent, or the process has already executed a new program
+	memset(entry, 0, sizeof(CommEntry));
+	entry->pid = pid;
+	strcpy(entry->comm, "unknown");
+	char *fname;
+	if (asprintf(&fname, "/proc/%d/comm", pid) == -1)
+		errExit("asprintf");
+	FILE *fp = fopen(fname, "re");
+	free(fname);
+	if (fp) {
+		if (fgets(entry->comm, sizeof(entry->comm), fp)) {
+			char *ptr = strchr(entry->comm, '\n');
+			if (ptr)
+				*ptr = '\0';
+			sanitize(entry->comm);
+		}
+		fclose(fp);
+	}
+	return entry;
+}
+
+static void trace_event(const struct fanotify_event_metadata *ev) {
+	// skip firejail processes
+	pid_t pid = ev->pid;
+	if (pid == 1 || pid == getpid() || pid == prefetch_pid || pid == dhcp_pid || pid == trace_agent)
+		return;
+
+	char fdname[64];
+	snprintf(fdname, sizeof(fdname), "/proc/self/fd/%d", ev->fd);
+	char path[PATH_MAX + 1];
+	ssize_t len = readlink(fdname, path, PATH_MAX);
+	if (len <= 0)
+		return;
+	path[len] = '\0';
+	sanitize(path);
+
+	CommEntry *entry = trace_comm(pid);
+	const char *call = "open";
+	if (ev->mask & FAN_OPEN_EXEC) {
+		call = "exec";
+		// the kernel names the process after the program; the ELF interpreter,
+		// or the interpreter of a script, is opened for exec right after it
+		if (!entry->exec) {
+			const char *ptr = strrchr(path, '/');
+			ptr = (ptr)? ptr + 1: path;
+			size_t n = strlen(ptr);
+			if (n >= sizeof(entry->comm))
+				n = sizeof(entry->comm) - 1;
+			memcpy(entry->comm, ptr, n);
+			entry->comm[n] = '\0';
+		}
+		entry->exec = 1;
+		if (pid == trace_app)
+			trace_app_exec = 1;
+	}
+	else {
+		// FAN_ONDIR is not reported in the event mask when the group receives file descriptors
+		struct stat st;
+		if (fstat(ev->fd, &st) == 0 && S_ISDIR(st.st_mode))
+			call = "opendir";
+		entry->exec = 0;
+	}
+	// the application is forked from the sandbox and runs firejail code until execve
+	if (pid == trace_app && !trace_app_exec)
+		return;
+
+	// only successful calls are reported by the kernel
+	fprintf(trace_out, "%u:%s:%s %s:0\n", (unsigned) pid, entry->comm, call, path);
+}
+
+// read all the events in the queue
+static void trace_read(int fd) {
+	char buf[TRACE_BUF] __attribute__((aligned(__alignof__(struct fanotify_event_metadata))));
+
+	while (1) {
+		ssize_t len = read(fd, buf, sizeof(buf));
+		if (len == -1 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			return;
+
+		struct fanotify_event_metadata *ev = (struct fanotify_event_metadata *) buf;
+		while (FAN_EVENT_OK(ev, len)) {
+			if (ev->vers != FANOTIFY_METADATA_VERSION) {
+				fprintf(stderr, "Error: fanotify metadata version mismatch\n");
+				_exit(1);
+			}
+			if (ev->fd >= 0) {
+				trace_event(ev);
+				close(ev->fd);
+			}
+			ev = FAN_EVENT_NEXT(ev, len);
+		}
+	}
+}
+
+static void trace_loop(int fd) {
+	prctl(PR_SET_NAME, "firejail-trace", 0, 0, 0);
+	prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+
+	if (arg_tracefile) {
+		// RUN_TRACE_FILE is the user file mounted in preproc_mount_mnt_dir()
+		trace_out = fopen(RUN_TRACE_FILE, "ae");
+		if (!trace_out)
+			errExit("fopen " RUN_TRACE_FILE);
+	}
+	else
+		trace_out = stdout;
+
+	// wait for the application to be started, the events are kept in the queue
+	pid_t pids[2];
+	if (read(trace_ctl[0], pids, sizeof(pids)) != sizeof(pids))
+		_exit(0);
+	trace_agent = pids[0];
+	trace_app = pids[1];
+
+	struct pollfd fds[2];
+	fds[0].fd = fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = trace_ctl[0];
+	fds[1].events = POLLIN;
+	while (1) {
+		if (poll(fds, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			errExit("poll");
+		}
+		// the events queued before the application exited are still read
+		trace_read(fd);
+		if (fds[1].revents)
+			break;
+	}
+
+	fflush(trace_out);
+	_exit(0);
+}
+
+// mark all the mounts in the sandbox and fork the tracer process;
+// called as root, after the sandbox filesystem was built
+void trace_fanotify_start(void) {
+	// the queue holds all the events until the tracer reads them
+	int fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_UNLIMITED_QUEUE,
+			       O_RDONLY | O_LARGEFILE | O_CLOEXEC);
+	if (fd == -1) {
+		fwarning("cannot initialize fanotify, file access tracing disabled\n");
+		return;
+	}
+
+	// FAN_OPEN_EXEC is available starting with Linux 5.0
+	uint64_t mask = TRACE_MASK | FAN_OPEN_EXEC;
+	size_t cnt;
+	MountData *mnt = get_mount_table(&cnt);
+	size_t i;
+	int marked = 0;
+	for (i = 0; i < cnt; i++) {
+		int rv = fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_MOUNT, mask, AT_FDCWD, mnt[i].dir);
+		if (rv == -1 && errno == EINVAL && mask != TRACE_MASK) {
+			mask = TRACE_MASK;
+			rv = fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_MOUNT, mask, AT_FDCWD, mnt[i].dir);
+		}
+		if (rv == 0)
+			marked++;
+		else if (arg_debug)
+			printf("Cannot trace file access on %s: %s\n", mnt[i].dir, strerror(errno));
+		free(mnt[i].fsname);
+		free(mnt[i].dir);
+		free(mnt[i].fstype);
+	}
+	free(mnt);
+
+	if (marked == 0) {
+		fwarning("cannot mark the sandbox mounts with fanotify, file access tracing disabled\n");
+		close(fd);
+		return;
+	}
+
+	if (pipe2(trace_ctl, O_CLOEXEC) == -1)
+		errExit("pipe2");
+
+	fflush(0);
+	pid_t child = fork();
+	if (child < 0)
+		errExit("fork");
+	if (child == 0) {
+		close(trace_ctl[1]);
+		trace_loop(fd);	// this function does not return
+	}
+
+	close(fd);
+	close(trace_ctl[0]);
+	trace_fanotify_pid = child;
+	if (arg_debug)
+		printf("Tracing file access on %d mounts, tracer pid %d\n", marked, trace_fanotify_pid);
+}
+
+// send the process ids to the tracer; called as regular user, after the application was forked
+void trace_fanotify_app(pid_t app_pid) {
+	if (!trace_fanotify_pid)
+		return;
+
+	pid_t pids[2] = {agent_pid, app_pid};
+	if (write(trace_ctl[1], pids, sizeof(pids)) != sizeof(pids))
+		errExit("write");
+}
+
+// let the tracer print the remaining events and wait for it; called as regular user
+void trace_fanotify_stop(void) {
+	if (!trace_fanotify_pid)
+		return;
+
+	char c = 0;
+	int rv = write(trace_ctl[1], &c, 1);
+	(void) rv;
+	close(trace_ctl[1]);
+	waitpid(trace_fanotify_pid, NULL, 0);
+	trace_fanotify_pid = 0;
+}
@@ -40,6 +40,8 @@ static const char *const usage_str =
 #ifdef HAVE_NETWORK
 	"    --bandwidth=name|pid - set bandwidth limits.\n"
 #endif
+	"    --batch=manifest - start the sandboxes listed in the manifest file.\n"
+	"    --batch-jobs=number - number of sandboxes started in parallel by --batch.\n"
 	"    --bind=dirname1,dirname2 - mount-bind dirname1 on top of dirname2.\n"
 	"    --bind=filename1,filename2 - mount-bind filename1 on top of filename2.\n"
 	"    --blacklist=filename - blacklist directory or file.\n"
@@ -56,6 +58,7 @@ static const char *const usage_str =
 #ifdef HAVE_CHROOT
 	"    --chroot=dirname - chroot into directory.\n"
 #endif
+	"    --cost - print the estimated startup cost of the sandbox and exit.\n"
 	"    --cpu=cpu-number,cpu-number - set cpu affinity.\n"
 	"    --cpu.print=name|pid - print the cpus in use.\n"
 #ifdef HAVE_DBUSPROXY
@@ -98,7 +101,10 @@ static const char *const usage_str =
 #ifdef HAVE_NETWORK
 	"    --dnstrace - monitor DNS queries.\n"
 #endif
+	"    --dry-run - print the planned filesystem, seccomp and network\n"
+	"\toperations and exit.\n"
 	"    --env=name=value - set environment variable.\n"
+	"    --fs-template - reuse private directories built by a previous sandbox.\n"
 	"    --fs.print=name|pid - print the filesystem log.\n"
 #ifdef HAVE_FILE_TRANSFER
 	"    --get=name|pid filename - get a file from sandbox container.\n"
@@ -116,13 +122,15 @@ static const char *const usage_str =
 	"    --interface=name - move interface in sandbox.\n"
 	"    --ip=address - set interface IP address.\n"
 	"    --ip=none - no IP address and no default gateway are configured.\n"
-	"    --ip=dhcp - acquire IP address by running dhclient.\n"
+	"    --ip=dhcp - acquire IP address using DHCP.\n"
 	"    --ip6=address - set interface IPv6 address.\n"
-	"    --ip6=dhcp - acquire IPv6 address by running dhclient.\n"
+	"    --ip6=dhcp - acquire IPv6 address using DHCPv6.\n"
+	"    --ip6-dad=off|optimistic - configure IPv6 duplicate address detection.\n"
 	"    --iprange=address,address - configure an IP address in this range.\n"
 #endif
 	"    --ipc-namespace - enable a new IPC namespace.\n"
 	"    --join=name|pid - join the sandbox.\n"
+	"    --join-agent - run --join commands through an agent in the sandbox.\n"
 	"    --join-filesystem=name|pid - join the mount namespace.\n"
 #ifdef HAVE_NETWORK
 	"    --join-network=name|pid - join the network namespace.\n"
@@ -133,6 +141,7 @@ static const char *const usage_str =
 	"    --keep-fd - inherit open file descriptors to sandbox.\n"
 	"    --keep-shell-rc - do not copy shell rc files from /etc/skel\n"
 	"    --keep-var-tmp - /var/tmp directory is untouched.\n"
+	"    --launch=name - start the program in a sandbox from the pool.\n"
 #ifdef HAVE_LANDLOCK
 	"    --landlock.enforce - enforce the Landlock ruleset.\n"
 	"    --landlock.fs.read=path - add a read access rule for the path to the Landlock ruleset.\n"
@@ -206,6 +215,9 @@ static const char *const usage_str =
 	"\tcurrent filesystem.\n"
 	"    --overlay-clean - clean all overlays stored in $HOME/.firejail directory.\n"
 #endif
+	"    --pool=name,N - keep N sandboxes ready for --launch=name.\n"
+	"    --prefetch - read the program and its libraries in the page cache\n"
+	"\twhile the sandbox is built.\n"
 	"    --private - temporary home directory.\n"
 	"    --private=directory - use directory as user home.\n"
 	"    --private-cache - temporary ~/.cache directory.\n"
@@ -226,6 +238,7 @@ static const char *const usage_str =
 	"    --private-cwd=directory - set working directory inside jail.\n"
 	"    --private-opt=file,directory - build a new /opt in a temporary filesystem.\n"
 	"    --private-srv=file,directory - build a new /srv in a temporary filesystem.\n"
+	"    --proc-subset - mount a /proc filesystem with process directories only.\n"
 	"    --profile=filename|profile_name - use a custom profile.\n"
 	"    --profile.print=name|pid - print the name of profile file.\n"
 	"    --protocol=protocol,protocol,protocol - enable protocol filter.\n"
@@ -254,6 +267,7 @@ static const char *const usage_str =
 	"    --rmenv=name - remove environment variable in the new sandbox.\n"
 #ifdef HAVE_NETWORK
 	"    --scan - ARP-scan all the networks from inside a network namespace.\n"
+	"    --scan=packets-per-second - ARP-scan at the specified probe rate.\n"
 #endif
 	"    --seccomp - enable seccomp filter and apply the default blacklist.\n"
 	"    --seccomp=syscall,syscall,syscall - enable seccomp filter, blacklist the\n"
@@ -274,8 +288,12 @@ static const char *const usage_str =
 	"    --timeout=hh:mm:ss - kill the sandbox automatically after the time\n"
 	"\thas elapsed.\n"
 	"    --tmpfs=dirname - mount a tmpfs filesystem on directory dirname.\n"
+	"    --tmpfs-options=dirname,option[,option] - size=, nr_inodes=, huge= and\n"
+	"\tnoswap options for the tmpfs mounted on directory dirname.\n"
 	"    --top - monitor the most CPU-intensive sandboxes.\n"
 	"    --trace - trace open, access and connect system calls.\n"
+	"    --trace-fanotify - trace file access using fanotify instead of a\n"
+	"\tpreloaded library.\n"
 	"    --tracelog - add a syslog message for every access to files or\n"
 	"\tdirectories blacklisted by the security profile.\n"
 	"    --tree - print a tree of all sandboxed processes.\n"
@@ -284,6 +302,7 @@ static const char *const usage_str =
 	"    --version - print program version and exit.\n"
 #ifdef HAVE_NETWORK
 	"    --veth-name=name - use this name for the interface connected to the bridge.\n"
+	"    --veth-queues=number|auto - create a multi-queue veth pair with offloads enabled.\n"
 #endif
 	"    --whitelist=filename - whitelist directory or file.\n"
 	"    --writable-etc - /etc directory is mounted read-write.\n"
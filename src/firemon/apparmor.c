@@ -22,7 +22,7 @@
 #ifdef HAVE_APPARMOR
 #include <sys/apparmor.h>
 
-static void print_apparmor(int pid) {
+void print_apparmor(int pid) {
 	char *label = NULL;
 	char *mode = NULL;
 	int rv = aa_gettaskcon(pid, &label, &mode);
@@ -55,6 +55,11 @@ void apparmor(pid_t pid, int print_procs) {
 
 #else
 
+void print_apparmor(int pid) {
+	(void) pid;
+	printf("  AppArmor support not available\n");
+}
+
 void apparmor(pid_t pid, int print_procs) {
 	(void) pid;
 	(void) print_procs;
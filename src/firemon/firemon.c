@@ -38,6 +38,7 @@ static int arg_top = 0;
 static int arg_list = 0;
 static int arg_netstats = 0;
 static int arg_apparmor = 0;
+static char *arg_report = NULL;
 int arg_wrap = 0;
 
 static struct termios tlocal;	// startup terminal setting
@@ -185,6 +186,8 @@ int main(int argc, char **argv) {
 #endif
 		else if (strcmp(argv[i], "--apparmor") == 0)
 			arg_apparmor = 1;
+		else if (strncmp(argv[i], "--report=", 9) == 0)
+			arg_report = argv[i] + 9;
 
 		else if (strncmp(argv[i], "--name=", 7) == 0) {
 			char *name = argv[i] + 7;
@@ -250,6 +253,10 @@ int main(int argc, char **argv) {
 		tree(pid);
 		return 0;
 	}
+	if (arg_report) {
+		report((pid_t) pid, arg_report);
+		return 0;
+	}
 
 	// if --name requested without other options, print all data
 	if (pid && !arg_cpu && !arg_seccomp && !arg_caps && !arg_apparmor &&
@@ -83,6 +83,10 @@ void netstats(void) __attribute__((noreturn));
 void x11(pid_t pid, int print_procs);
 
 //apparmor.c
+void print_apparmor(int pid);
 void apparmor(pid_t pid, int print_procs);
 
+// report.c
+void report(pid_t pid, const char *list);
+
 #endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "firemon.h"
+#define MAXBUF 4098
+
+// attributes read from /proc/PID/status, in the order they are printed
+static const struct {
+	const char *name;	// name used in --report= list
+	const char *field;	// status file field
+} status_attr[] = {
+	{ "cpu", "Cpus_allowed_list:" },
+	{ "seccomp", "Seccomp:" },
+	{ "caps", "CapBnd:" },
+};
+#define STATUS_ATTR_MAX ((int) (sizeof(status_attr) / sizeof(status_attr[0])))
+
+static int report_status[STATUS_ATTR_MAX] = {0};
+static int report_apparmor = 0;
+
+// parse the attribute list; exit if an attribute is not recognized
+static void parse_report_list(const char *list) {
+	char *dup = strdup(list);
+	if (!dup)
+		errExit("strdup");
+
+	char *ptr = strtok(dup, ",");
+	if (!ptr) {
+		fprintf(stderr, "Error: empty --report list\n");
+		exit(1);
+	}
+	while (ptr) {
+		int found = 0;
+		int i;
+		for (i = 0; i < STATUS_ATTR_MAX; i++) {
+			if (strcmp(ptr, "all") == 0 || strcmp(ptr, status_attr[i].name) == 0) {
+				report_status[i] = 1;
+				found = 1;
+			}
+		}
+		if (strcmp(ptr, "all") == 0 || strcmp(ptr, "apparmor") == 0) {
+			report_apparmor = 1;
+			found = 1;
+		}
+		if (!found) {
+			fprintf(stderr, "Error: invalid --report attribute %s\n", ptr);
+			exit(1);
+		}
+		ptr = strtok(NULL, ",");
+	}
+	free(dup);
+}
+
+// read the status file once and print all the requested fields
+static void print_status(int pid) {
+	char *file;
+	if (asprintf(&file, "/proc/%d/status", pid) == -1)
+		errExit("asprintf");
+
+	FILE *fp = fopen(file, "r");
+	if (!fp) {
+		printf("  Error: cannot open %s\n", file);
+		free(file);
+		return;
+	}
+
+	int wanted = 0;
+	int i;
+	for (i = 0; i < STATUS_ATTR_MAX; i++)
+		wanted += report_status[i];
+
+	char *value[STATUS_ATTR_MAX] = {NULL};
+	char buf[MAXBUF];
+	while (wanted && fgets(buf, MAXBUF, fp)) {
+		for (i = 0; i < STATUS_ATTR_MAX; i++) {
+			if (report_status[i] && !value[i] &&
+			    strncmp(buf, status_attr[i].field, strlen(status_attr[i].field)) == 0) {
+				value[i] = strdup(buf);
+				if (!value[i])
+					errExit("strdup");
+				wanted--;
+				break;
+			}
+		}
+	}
+	fclose(fp);
+	free(file);
+
+	for (i = 0; i < STATUS_ATTR_MAX; i++) {
+		if (value[i]) {
+			printf("  %s", value[i]);
+			free(value[i]);
+		}
+	}
+	fflush(0);
+}
+
+void report(pid_t pid, const char *list) {
+	assert(list);
+	parse_report_list(list);
+
+	pid_read(pid);	// include all processes
+
+	// print processes
+	int i;
+	for (i = 0; i < max_pids; i++) {
+		if (pids[i].level == 1) {
+			pid_print_list(i, arg_wrap);
+			int child = find_child(i);
+			if (child != -1) {
+				print_status(child);
+				if (report_apparmor)
+					print_apparmor(child);
+			}
+		}
+	}
+	printf("\n");
+}
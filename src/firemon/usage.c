@@ -37,6 +37,9 @@ static const char *const usage_str =
 	"\t--name=name - print information only about named sandbox.\n\n"
 	"\t--netstats - monitor network statistics for sandboxes creating a new\n"
 	"\t\tnetwork namespace.\n\n"
+	"\t--report=attribute,attribute - print the requested attributes for each\n"
+	"\t\tsandbox, reading /proc only once; attributes: apparmor, caps, cpu,\n"
+	"\t\tseccomp, all.\n\n"
 	"\t--route - print route table for each sandbox.\n\n"
 	"\t--seccomp - print seccomp configuration for each sandbox.\n\n"
 	"\t--tree - print a tree of all sandboxed processes.\n\n"
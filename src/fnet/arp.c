@@ -27,6 +27,9 @@
 #include <linux/udp.h>
 #include <linux/tcp.h>
 #include <linux/if_packet.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
 
 typedef struct arp_hdr_t {
 	uint16_t htype;
@@ -41,19 +44,35 @@ typedef struct arp_hdr_t {
 } ArpHdr;
 
 
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 // scan interface (--scan option)
-void arp_scan(const char *dev, uint32_t ifip, uint32_t ifmask) {
+//
+// All the probes go out from one packet socket, paced at rate packets per second;
+// the replies are collected in the same loop while the probes are still going out.
+// The scan ends ARP_SCAN_TIMEOUT after the last probe.
+void arp_scan(const char *dev, uint32_t ifip, uint32_t ifmask, unsigned rate) {
 	assert(dev);
 	assert(ifip);
-
-//	printf("Scanning interface %s (%d.%d.%d.%d/%d)\n",
-//		dev, PRINT_IP(ifip & ifmask), mask2bits(ifmask));
+	assert(rate);
 
 	if (strlen(dev) > IFNAMSIZ) {
 		fprintf(stderr, "Error: invalid network device name %s\n", dev);
 		exit(1);
 	}
 
+	// try all possible ip addresses in ascending order
+	uint32_t range = ~ifmask + 1; // the number of potential addresses
+	// this software is not supported for /31 networks
+	if (range < 4) {
+		fprintf(stderr, "Warning: this option is not supported for /31 networks\n");
+		return;
+	}
+
 	// find interface mac address
 	int sock;
 	if ((sock = socket(AF_INET, SOCK_RAW, IPPROTO_RAW)) < 0)
@@ -67,137 +86,135 @@ void arp_scan(const char *dev, uint32_t ifip, uint32_t ifmask) {
 	uint8_t mac[6];
 	memcpy (mac, ifr.ifr_hwaddr.sa_data, 6);
 
-	// open layer2 socket
-	if ((sock = socket(PF_PACKET, SOCK_RAW, htons (ETH_P_ALL))) < 0)
+	// open layer2 socket, ARP packets on this interface only
+	if ((sock = socket(PF_PACKET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, htons(ETH_P_ARP))) < 0)
 		errExit("socket");
-
-	// try all possible ip addresses in ascending order
-	uint32_t range = ~ifmask + 1; // the number of potential addresses
-	// this software is not supported for /31 networks
-	if (range < 4) {
-		fprintf(stderr, "Warning: this option is not supported for /31 networks\n");
-		close(sock);
-		return;
-	}
-
-	uint32_t dest = (ifip & ifmask) + 1;
-	uint32_t last = dest + range - 1;
+	struct sockaddr_ll addr;
+	memset(&addr, 0, sizeof(addr));
+	if ((addr.sll_ifindex = if_nametoindex(dev)) == 0)
+		errExit("if_nametoindex");
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(ETH_P_ARP);
+	if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+		errExit("bind");
+	memcpy (addr.sll_addr, mac, 6);
+	addr.sll_halen = ETH_ALEN;
+
+	uint32_t first = (ifip & ifmask) + 1;
+	uint32_t dest = first;
+	uint32_t last = first + range - 2; // the broadcast address is not probed
 	uint32_t src = htonl(ifip);
 
-	// wait not more than one second for an answer
+	// one bit for each address, in order to filter duplicate replies
+	uint8_t *seen = calloc(range / 8 + 1, 1);
+	if (!seen)
+		errExit("calloc");
+
+	// the request is the same for all the probes, except for the target address
+	uint8_t frame[ETH_FRAME_LEN]; // includes eht header, vlan, and crc
+	memset(frame, 0, sizeof(frame));
+	memset(frame, 0xff, 6);
+	memcpy(frame + 6, mac, 6);
+	frame[12] = ETH_P_ARP / 256;
+	frame[13] = ETH_P_ARP % 256;
+	ArpHdr *req = (ArpHdr *) (frame + 14);
+	req->htype = htons(1);
+	req->ptype = htons(ETH_P_IP);
+	req->hlen = 6;
+	req->plen = 4;
+	req->opcode = htons(1); //ARPOP_REQUEST
+	memcpy(req->sender_mac, mac, 6);
+	memcpy(req->sender_ip, (uint8_t *)&src, 4);
+
 	int header_printed = 0;
-	uint32_t last_ip = 0;
-	struct timeval ts;
-	ts.tv_sec = 2; // 2 seconds receive timeout
-	ts.tv_usec = 0;
+	uint64_t start = now_us();
+	uint64_t end = 0;	// set after the last probe
+	unsigned sent = 0;
 
 	while (1) {
-		fd_set rfds;
-		FD_ZERO(&rfds);
-		FD_SET(sock, &rfds);
-		fd_set wfds;
-		FD_ZERO(&wfds);
-		FD_SET(sock, &wfds);
-		int maxfd = sock;
-
-		uint8_t frame[ETH_FRAME_LEN]; // includes eht header, vlan, and crc
-		memset(frame, 0, ETH_FRAME_LEN);
-
-		int nready;
-		if (dest < last)
-			nready = select(maxfd + 1,  &rfds, &wfds, (fd_set *) 0, NULL);
-		else
-			nready = select(maxfd + 1,  &rfds,  (fd_set *) 0, (fd_set *) 0, &ts);
-
-		if (nready < 0)
-			errExit("select");
-
-		if (nready == 0) { // timeout
-			break;
-		}
+		uint64_t now = now_us();
 
-		if (FD_ISSET(sock, &wfds) && dest < last) {
-			// configure layer2 socket address information
-			struct sockaddr_ll addr;
-			memset(&addr, 0, sizeof(addr));
-			if ((addr.sll_ifindex = if_nametoindex(dev)) == 0)
-				errExit("if_nametoindex");
-			addr.sll_family = AF_PACKET;
-			memcpy (addr.sll_addr, mac, 6);
-			addr.sll_halen = ETH_ALEN;
-
-			// build the arp packet header
-			ArpHdr hdr;
-			memset(&hdr, 0, sizeof(hdr));
-			hdr.htype = htons(1);
-			hdr.ptype = htons(ETH_P_IP);
-			hdr.hlen = 6;
-			hdr.plen = 4;
-			hdr.opcode = htons(1); //ARPOP_REQUEST
-			memcpy(hdr.sender_mac, mac, 6);
-			memcpy(hdr.sender_ip, (uint8_t *)&src, 4);
+		// send all the probes due by now
+		while (dest < last) {
+			uint64_t due = start + (uint64_t) sent * 1000000 / rate;
+			if (due > now)
+				break;
 			uint32_t dst = htonl(dest);
-			memcpy(hdr.target_ip, (uint8_t *)&dst, 4);
-
-			// build ethernet frame
-			uint8_t frame[ETH_FRAME_LEN]; // includes eht header, vlan, and crc
-			memset(frame, 0, sizeof(frame));
-			frame[0] = frame[1] = frame[2] = frame[3] = frame[4] = frame[5] = 0xff;
-			memcpy(frame + 6, mac, 6);
-			frame[12] = ETH_P_ARP / 256;
-			frame[13] = ETH_P_ARP % 256;
-			memcpy (frame + 14, &hdr, sizeof(hdr));
-
-			// send packet
-			if (sendto (sock, frame, 14 + sizeof(ArpHdr), 0, (struct sockaddr *) &addr, sizeof (addr)) <= 0)
+			memcpy(req->target_ip, (uint8_t *)&dst, 4);
+			if (sendto(sock, frame, 14 + sizeof(ArpHdr), 0, (struct sockaddr *) &addr, sizeof (addr)) <= 0) {
+				if (errno == EAGAIN || errno == ENOBUFS)
+					break; // transmit queue full, try again later
 				errExit("send");
-			fflush(0);
+			}
+			sent++;
 			dest++;
 		}
+		if (dest == last && end == 0)
+			end = now_us() + ARP_SCAN_TIMEOUT * 1000;
 
-		if (FD_ISSET(sock, &rfds)) {
-			// read the incoming packet
-			int len = recvfrom(sock, frame, ETH_FRAME_LEN, 0, NULL, NULL);
-			if (len < 0) {
-				perror("recvfrom");
-			}
+		// sleep until the next probe is due, or until the scan ends
+		uint64_t wake = (end) ? end : start + (uint64_t) sent * 1000000 / rate;
+		now = now_us();
+		if (end && now >= end)
+			break;
+		int timeout = (wake > now) ? (int) ((wake - now + 999) / 1000) : 0;
+		struct pollfd pfd = { .fd = sock, .events = POLLIN };
+		int nready = poll(&pfd, 1, timeout);
+		if (nready < 0) {
+			if (errno == EINTR)
+				continue;
+			errExit("poll");
+		}
+		if (nready == 0)
+			continue;
 
+		// read all the incoming packets
+		uint8_t packet[ETH_FRAME_LEN];
+		int len;
+		while ((len = recv(sock, packet, sizeof(packet), 0)) >= 0) {
 			// parse the incoming packet
 			if ((unsigned int) len < 14 + sizeof(ArpHdr))
 				continue;
 
 			// look only at ARP packets
-			if (frame[12] != (ETH_P_ARP / 256) || frame[13] != (ETH_P_ARP % 256))
+			if (packet[12] != (ETH_P_ARP / 256) || packet[13] != (ETH_P_ARP % 256))
 				continue;
 
 			ArpHdr hdr;
-			memcpy(&hdr, frame + 14, sizeof(ArpHdr));
-
-			if (hdr.opcode == htons(2)) {
-				// check my mac and my address
-				if (memcmp(mac, hdr.target_mac, 6) != 0)
-					continue;
-				uint32_t ip;
-				memcpy(&ip, hdr.target_ip, 4);
-				if (ip != src)
-					continue;
-				memcpy(&ip, hdr.sender_ip, 4);
-				ip = ntohl(ip);
-
-				if (ip == last_ip) // filter duplicates
-					continue;
-				last_ip = ip;
-
-				// printing
-				if (header_printed == 0) {
-					fmessage("   Network scan:\n");
-					header_printed = 1;
-				}
-				fmessage("   %02x:%02x:%02x:%02x:%02x:%02x\t%d.%d.%d.%d\n",
-					PRINT_MAC(hdr.sender_mac), PRINT_IP(ip));
+			memcpy(&hdr, packet + 14, sizeof(ArpHdr));
+			if (hdr.opcode != htons(2))
+				continue;
+
+			// check my mac and my address
+			if (memcmp(mac, hdr.target_mac, 6) != 0)
+				continue;
+			uint32_t ip;
+			memcpy(&ip, hdr.target_ip, 4);
+			if (ip != src)
+				continue;
+			memcpy(&ip, hdr.sender_ip, 4);
+			ip = ntohl(ip);
+			if (ip < first || ip >= last)
+				continue;
+
+			// filter duplicates
+			uint32_t index = ip - first;
+			if (seen[index / 8] & (1 << (index % 8)))
+				continue;
+			seen[index / 8] |= 1 << (index % 8);
+
+			// printing
+			if (header_printed == 0) {
+				fmessage("   Network scan:\n");
+				header_printed = 1;
 			}
+			fmessage("   %02x:%02x:%02x:%02x:%02x:%02x\t%d.%d.%d.%d\n",
+				PRINT_MAC(hdr.sender_mac), PRINT_IP(ip));
 		}
+		if (errno != EAGAIN && errno != EINTR)
+			perror("recv");
 	}
 
+	free(seen);
 	close(sock);
 }
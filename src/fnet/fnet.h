@@ -21,6 +21,7 @@
 #define FNET_H
 
 #include "../include/common.h"
+#include "../include/message.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,10 +30,9 @@
 
 // main.c
 extern int arg_quiet;
-extern void fmessage(char* fmt, ...); // TODO: this function is duplicated in src/firejail/util.c
 
 // veth.c
-int net_create_veth(const char *dev, const char *nsdev, unsigned pid);
+int net_create_veth(const char *dev, const char *nsdev, unsigned pid, int mtu, int queues);
 int net_create_macvlan(const char *dev, const char *parent, unsigned pid);
 int net_create_ipvlan(const char *dev, const char *parent, unsigned pid);
 int net_move_interface(const char *dev, unsigned pid);
@@ -42,15 +42,19 @@ void net_bridge_add_interface(const char *bridge, const char *dev);
 void net_if_up(const char *ifname);
 int net_get_mtu(const char *ifname);
 void net_set_mtu(const char *ifname, int mtu);
-void net_ifprint(int scan);
+void net_ifprint(unsigned scan_rate);
 int net_get_mac(const char *ifname, unsigned char mac[6]);
 void net_if_ip(const char *ifname, uint32_t ip, uint32_t mask, int mtu);
 int net_if_mac(const char *ifname, const unsigned char mac[6]);
 void net_if_ip6(const char *ifname, const char *addr6);
 void net_if_waitll(const char *ifname);
+void net_if_dad(const char *ifname, const char *mode);
+void net_if_offload(const char *ifname);
 
 
 // arp.c
-void arp_scan(const char *dev, uint32_t ifip, uint32_t ifmask);
+#define ARP_SCAN_RATE 1000	// default probe rate, packets per second
+#define ARP_SCAN_TIMEOUT 1000	// wait for replies after the last probe, ms
+void arp_scan(const char *dev, uint32_t ifip, uint32_t ifmask, unsigned rate);
 
 #endif
@@ -27,9 +27,14 @@
 #include <net/if.h>
 #include <net/if_arp.h>
 #include <net/route.h>
+#include <linux/ethtool.h>
 #include <linux/if_bridge.h>
+#include <linux/sockios.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
 
 static void check_if_name(const char *ifname) {
 	if (strlen(ifname) > IFNAMSIZ) {
@@ -165,8 +170,9 @@ void net_set_mtu(const char *ifname, int mtu) {
 	close(s);
 }
 
-// scan interfaces in current namespace and print IP address/mask for each interface
-void net_ifprint(int scan) {
+// scan interfaces in current namespace and print IP address/mask for each interface;
+// with scan_rate set, ARP-scan the networks at scan_rate packets per second
+void net_ifprint(unsigned scan_rate) {
 	uint32_t ip;
 	uint32_t mask;
 	struct ifaddrs *ifaddr, *ifa;
@@ -214,7 +220,7 @@ void net_ifprint(int scan) {
 				ifa->ifa_name, macstr, ipstr, maskstr, status);
 
 			// print ipv6 address
-			if (!scan) {
+			if (!scan_rate) {
 				struct ifaddrs *ptr = ifa->ifa_next;
 				while (ptr) {
 					if (ptr->ifa_addr->sa_family == AF_INET6 && strcmp(ifa->ifa_name, ptr->ifa_name) == 0) {
@@ -231,7 +237,7 @@ void net_ifprint(int scan) {
 			}
 
 			// network scanning
-			if (!scan)				// scanning disabled
+			if (!scan_rate)				// scanning disabled
 				continue;
 			if (strcmp(ifa->ifa_name, "lo") == 0)	// no loopbabck scanning
 				continue;
@@ -241,7 +247,7 @@ void net_ifprint(int scan) {
 				continue;
 			// only if the interface is up and running
 			if (ifa->ifa_flags & IFF_RUNNING && ifa->ifa_flags & IFF_UP)
-				arp_scan(ifa->ifa_name, ip, mask);
+				arp_scan(ifa->ifa_name, ip, mask, scan_rate);
 		}
 	}
 	freeifaddrs(ifaddr);
@@ -390,25 +396,37 @@ void net_if_ip6(const char *ifname, const char *addr6) {
 	close(sock);
 }
 
-static int net_netlink_address_tentative(struct nlmsghdr *current_header) {
+// returns the address flags of a RTM_NEWADDR message
+static uint32_t net_netlink_address_flags(struct nlmsghdr *current_header) {
 	struct ifaddrmsg *msg = NLMSG_DATA(current_header);
-	int has_flags = 0;
 #ifdef IFA_FLAGS
 	struct rtattr *rta = IFA_RTA(msg);
 	size_t msg_len = IFA_PAYLOAD(current_header);
 	while (RTA_OK(rta, msg_len)) {
-		if (rta->rta_type == IFA_FLAGS) {
-			has_flags = 1;
-			uint32_t *flags = RTA_DATA(rta);
-			if (*flags & IFA_F_TENTATIVE)
-				return 1;
-		}
+		// According to <linux/if_addr.h>, if an IFA_FLAGS attribute is present,
+		// the field ifa_flags should be ignored.
+		if (rta->rta_type == IFA_FLAGS)
+			return *(uint32_t *) RTA_DATA(rta);
 		rta = RTA_NEXT(rta, msg_len);
 	}
 #endif
-	// According to <linux/if_addr.h>, if an IFA_FLAGS attribute is present,
-	// the field ifa_flags should be ignored.
-	return !has_flags && (msg->ifa_flags & IFA_F_TENTATIVE);
+	return msg->ifa_flags;
+}
+
+// check a RTM_NEWADDR message for a usable link-local address on interface index;
+// optimistic addresses can be used while DAD is still running
+// returns 1 if found, 0 if not, -1 if DAD failed
+static int net_netlink_check_ll(struct nlmsghdr *current_header, uint32_t index) {
+	struct ifaddrmsg *msg = NLMSG_DATA(current_header);
+	if (msg->ifa_family != AF_INET6 || msg->ifa_index != index || msg->ifa_scope != RT_SCOPE_LINK)
+		return 0;
+
+	uint32_t flags = net_netlink_address_flags(current_header);
+	if (flags & IFA_F_DADFAILED)
+		return -1;
+	if ((flags & IFA_F_TENTATIVE) && !(flags & IFA_F_OPTIMISTIC))
+		return 0;
+	return 1;
 }
 
 static int net_netlink_if_has_ll(int sock, uint32_t index) {
@@ -439,12 +457,9 @@ static int net_netlink_if_has_ll(int sock, uint32_t index) {
 		struct nlmsghdr *current_header = (struct nlmsghdr *) buf;
 		while (NLMSG_OK(current_header, len)) {
 			switch (current_header->nlmsg_type) {
-			case RTM_NEWADDR: {
-				struct ifaddrmsg *msg = NLMSG_DATA(current_header);
-				if (!found && msg->ifa_index == index && msg->ifa_scope == RT_SCOPE_LINK &&
-						!net_netlink_address_tentative(current_header))
-					found = 1;
-			}
+			case RTM_NEWADDR:
+				if (!found)
+					found = net_netlink_check_ll(current_header, index);
 				break;
 			case NLMSG_NOOP:
 				break;
@@ -470,6 +485,50 @@ static int net_netlink_if_has_ll(int sock, uint32_t index) {
 	return found;
 }
 
+// wait for an address event on a socket subscribed to RTNLGRP_IPV6_IFADDR
+// returns 1 if found, 0 on timeout, -1 if DAD failed
+static int net_netlink_wait_ll(int sock, uint32_t index, int timeout_ms) {
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (1) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		int elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+		if (elapsed >= timeout_ms)
+			return 0;
+
+		struct pollfd pfd = { .fd = sock, .events = POLLIN };
+		int rv = poll(&pfd, 1, timeout_ms - elapsed);
+		if (rv == -1) {
+			if (errno == EINTR)
+				continue;
+			errExit("poll");
+		}
+		if (rv == 0)
+			return 0;
+
+		char buf[16384];
+		ssize_t len = recv(sock, buf, sizeof(buf), 0);
+		if (len < 0) {
+			// the kernel dropped some events, the caller falls back to a dump
+			if (errno == ENOBUFS)
+				return 0;
+			errExit("recv");
+		}
+
+		struct nlmsghdr *current_header = (struct nlmsghdr *) buf;
+		while (NLMSG_OK(current_header, len)) {
+			if (current_header->nlmsg_type == RTM_NEWADDR) {
+				int found = net_netlink_check_ll(current_header, index);
+				if (found)
+					return found;
+			}
+			current_header = NLMSG_NEXT(current_header, len);
+		}
+	}
+}
+
 // wait for a link-local IPv6 address for DHCPv6
 // ex: firejail --net=br0 --ip6=dhcp
 void net_if_waitll(const char *ifname) {
@@ -494,24 +553,113 @@ void net_if_waitll(const char *ifname) {
 	}
 	uint32_t index = (uint32_t) ifr.ifr_ifindex;
 
-	// poll for link-local address
-	int netlink_sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+	// subscribe to IPv6 address events before checking the current state,
+	// so the event clearing the tentative flag cannot be missed
+	int event_sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (event_sock < 0)
+		errExit("socket");
+	struct sockaddr_nl addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = RTMGRP_IPV6_IFADDR;
+	if (bind(event_sock, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+		errExit("bind");
+
+	int netlink_sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
 	if (netlink_sock < 0)
 		errExit("socket");
+
+	// 30 seconds in total, the dump is repeated only if events were lost
 	int tries = 0;
 	int found = 0;
 	while (tries < 60 && !found) {
-		if (tries >= 1)
-			usleep(500000);
-
 		found = net_netlink_if_has_ll(netlink_sock, index);
-
+		if (!found)
+			found = net_netlink_wait_ll(event_sock, index, 500);
 		tries++;
 	}
 	close(netlink_sock);
+	close(event_sock);
 
+	if (found == -1) {
+		fprintf(stderr, "Duplicate address detection failed for the link-local IPv6 address of %s\n", ifname);
+		exit(1);
+	}
 	if (!found) {
 		fprintf(stderr, "Waiting for link-local IPv6 address of %s timed out\n", ifname);
 		exit(1);
 	}
 }
+
+static void net_if_sysctl6(const char *ifname, const char *name, const char *value) {
+	char *fname;
+	if (asprintf(&fname, "/proc/sys/net/ipv6/conf/%s/%s", ifname, name) == -1)
+		errExit("asprintf");
+	FILE *fp = fopen(fname, "w");
+	if (!fp) {
+		fprintf(stderr, "Warning fnet: cannot configure %s\n", fname);
+		free(fname);
+		return;
+	}
+	fprintf(fp, "%s\n", value);
+	if (fclose(fp))
+		fprintf(stderr, "Warning fnet: cannot configure %s\n", fname);
+	free(fname);
+}
+
+// configure duplicate address detection on an interface, before the interface is up
+// mode: "off" - no DAD, "optimistic" - addresses are usable while DAD is running
+void net_if_dad(const char *ifname, const char *mode) {
+	check_if_name(ifname);
+
+	if (strcmp(mode, "off") == 0)
+		net_if_sysctl6(ifname, "accept_dad", "0");
+	else if (strcmp(mode, "optimistic") == 0) {
+		// optimistic DAD depends on CONFIG_IPV6_OPTIMISTIC_DAD
+		net_if_sysctl6(ifname, "optimistic_dad", "1");
+		net_if_sysctl6(ifname, "use_optimistic", "1");
+	}
+	else {
+		fprintf(stderr, "Error fnet: invalid DAD mode %s\n", mode);
+		exit(1);
+	}
+}
+
+static int ethtool_set(int sock, const char *ifname, uint32_t cmd, uint32_t value) {
+	struct ethtool_value ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.cmd = cmd;
+	ev.data = value;
+
+	struct ifreq ifr;
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+	ifr.ifr_data = (void *) &ev;
+	return ioctl(sock, SIOCETHTOOL, &ifr);
+}
+
+// enable segmentation and receive offloads; on veth devices GRO also switches the
+// receive path to NAPI, so traffic is spread over all the queues of the device
+void net_if_offload(const char *ifname) {
+	check_if_name(ifname);
+
+	int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		errExit("socket");
+
+	static const struct {
+		uint32_t cmd;
+		const char *name;
+	} offload[] = {
+		{ ETHTOOL_STSO, "TSO" },
+		{ ETHTOOL_SGSO, "GSO" },
+		{ ETHTOOL_SGRO, "GRO" }
+	};
+	unsigned i;
+	for (i = 0; i < sizeof(offload) / sizeof(offload[0]); i++) {
+		// not all the drivers support all the offloads
+		if (ethtool_set(sock, ifname, offload[i].cmd, 1) < 0 && errno != EOPNOTSUPP && !arg_quiet)
+			fprintf(stderr, "Warning fnet: cannot enable %s on %s\n", offload[i].name, ifname);
+	}
+	close(sock);
+}
@@ -24,27 +24,18 @@
 
 int arg_quiet = 0;
 
-void fmessage(char* fmt, ...) { // TODO: this function is duplicated in src/firejail/util.c
-	if (arg_quiet)
-		return;
-
-	va_list args;
-	va_start(args,fmt);
-	vfprintf(stderr, fmt, args);
-	va_end(args);
-	fflush(0);
-}
-
 static const char *const usage_str =
 	"Usage:\n"
-	"\tfnet create veth dev1 dev2 bridge child\n"
+	"\tfnet create veth dev1 dev2 bridge child [mtu queues]\n"
 	"\tfnet create macvlan dev parent child\n"
 	"\tfnet moveif dev proc\n"
 	"\tfnet printif\n"
-	"\tfnet printif scan\n"
+	"\tfnet printif scan [packets-per-second]\n"
 	"\tfnet config interface dev ip mask mtu\n"
 	"\tfnet config mac addr\n"
 	"\tfnet config ipv6 dev ip\n"
+	"\tfnet config dad dev off|optimistic\n"
+	"\tfnet config offload dev\n"
 	"\tfnet ifup dev\n"
 	"\tfnet waitll dev\n";
 
@@ -84,16 +75,33 @@ printf("\n");
 		net_ifprint(0);
 	}
 	else if (argc == 3 && strcmp(argv[1], "printif") == 0 && strcmp(argv[2], "scan") == 0) {
-		net_ifprint(1);
+		net_ifprint(ARP_SCAN_RATE);
+	}
+	else if (argc == 4 && strcmp(argv[1], "printif") == 0 && strcmp(argv[2], "scan") == 0) {
+		unsigned rate;
+		if (sscanf(argv[3], "%u", &rate) != 1 || rate == 0) {
+			fprintf(stderr, "Error fnet: invalid scan rate %s\n", argv[3]);
+			return 1;
+		}
+		net_ifprint(rate);
 	}
 	else if (argc == 7 && strcmp(argv[1], "create") == 0 && strcmp(argv[2], "veth") == 0) {
 		// create veth pair and move one end in the the namespace
-		net_create_veth(argv[3], argv[4], atoi(argv[6]));
+		net_create_veth(argv[3], argv[4], atoi(argv[6]), 0, 0);
 		// connect the other veth end to the bridge ...
 		net_bridge_add_interface(argv[5], argv[3]);
 		// ... and bring it  up
 		net_if_up(argv[3]);
 	}
+	else if (argc == 9 && strcmp(argv[1], "create") == 0 && strcmp(argv[2], "veth") == 0) {
+		// same as above, with the MTU and the number of queues set on both ends
+		int queues = atoi(argv[8]);
+		net_create_veth(argv[3], argv[4], atoi(argv[6]), atoi(argv[7]), queues);
+		if (queues > 1)
+			net_if_offload(argv[3]);
+		net_bridge_add_interface(argv[5], argv[3]);
+		net_if_up(argv[3]);
+	}
 	else if (argc == 6 && strcmp(argv[1], "create") == 0 && strcmp(argv[2], "macvlan") == 0) {
 		// use ipvlan for wireless devices
 		// ipvlan driver was introduced in Linux kernel 3.19
@@ -146,6 +154,12 @@ printf("\n");
 	else if (argc == 5 && strcmp(argv[1], "config") == 0 && strcmp(argv[2], "ipv6") == 0) {
 		net_if_ip6(argv[3], argv[4]);
 	}
+	else if (argc == 5 && strcmp(argv[1], "config") == 0 && strcmp(argv[2], "dad") == 0) {
+		net_if_dad(argv[3], argv[4]);
+	}
+	else if (argc == 4 && strcmp(argv[1], "config") == 0 && strcmp(argv[2], "offload") == 0) {
+		net_if_offload(argv[3]);
+	}
 	else if (argc == 3 && strcmp(argv[1], "waitll") == 0) {
 		net_if_waitll(argv[2]);
 	}
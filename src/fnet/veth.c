@@ -66,7 +66,17 @@ struct iplink_req
 
 static struct rtnl_handle rth = { .fd = -1 };
 
-int net_create_veth(const char *dev, const char *nsdev, unsigned pid) {
+// mtu and queues are applied to both ends of the pair, 0 keeps the kernel default
+static void veth_link_attrs(struct nlmsghdr *n, int maxlen, int mtu, int queues) {
+	if (mtu > 0)
+		addattr_l(n, maxlen, IFLA_MTU, &mtu, 4);
+	if (queues > 0) {
+		addattr_l(n, maxlen, IFLA_NUM_TX_QUEUES, &queues, 4);
+		addattr_l(n, maxlen, IFLA_NUM_RX_QUEUES, &queues, 4);
+	}
+}
+
+int net_create_veth(const char *dev, const char *nsdev, unsigned pid, int mtu, int queues) {
 	int len;
 	struct iplink_req req;
 
@@ -90,6 +100,7 @@ int net_create_veth(const char *dev, const char *nsdev, unsigned pid) {
 		len = strlen(dev) + 1;
 		addattr_l(&req.n, sizeof(req), IFLA_IFNAME, dev, len);
 	}
+	veth_link_attrs(&req.n, sizeof(req), mtu, queues);
 
 	struct rtattr *linkinfo = NLMSG_TAIL(&req.n);
 	addattr_l(&req.n, sizeof(req), IFLA_LINKINFO, NULL, 0);
@@ -109,6 +120,7 @@ int net_create_veth(const char *dev, const char *nsdev, unsigned pid) {
 		int len = strlen(nsdev) + 1;
 		addattr_l(&req.n, sizeof(req), IFLA_IFNAME, nsdev, len);
 	}
+	veth_link_attrs(&req.n, sizeof(req), mtu, queues);
 	peerdata->rta_len = (void *)NLMSG_TAIL(&req.n) - (void *)peerdata;
 
 	data->rta_len = (void *)NLMSG_TAIL(&req.n) - (void *)data;
@@ -18,6 +18,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 #include "fnetlock.h"
+#include "../include/pcapfile.h"
 #include <limits.h>
 #include <sys/ioctl.h>
 #include <sys/prctl.h>
@@ -26,6 +27,7 @@
 
 static int arg_tail = 0;
 static char *arg_log = NULL;
+static char *arg_pcap = NULL;
 
 //*****************************************************************
 // traffic trace storage - hash table for fast access + linked list for display purposes
@@ -46,6 +48,7 @@ typedef struct hnode_t {
 #define HMAX 256
 HNode *htable[HMAX] = {NULL};
 static int have_traffic = 0;
+static unsigned hnode_allocs = 0;
 
 // using protocol 0 and port 0 for ICMP
 static void hnode_add(uint32_t ip_src, uint8_t protocol, uint16_t port_src) {
@@ -65,6 +68,7 @@ static void hnode_add(uint32_t ip_src, uint8_t protocol, uint16_t port_src) {
 	have_traffic = 1;
 	HNode *hnew = malloc(sizeof(HNode));
 	assert(hnew);
+	hnode_allocs++;
 	hnew->ip_src = ip_src;
 	hnew->port_src = port_src;
 	hnew->protocol = protocol;
@@ -81,6 +85,40 @@ static void hnode_add(uint32_t ip_src, uint8_t protocol, uint16_t port_src) {
 
 
 
+static void process_packet(unsigned char *buf, unsigned bytes) {
+	if (bytes >= 20) { // size of IP header
+#ifdef DEBUG
+		{
+			uint32_t ip_src;
+			memcpy(&ip_src, buf + 12, 4);
+			ip_src = ntohl(ip_src);
+
+			uint32_t ip_dst;
+			memcpy(&ip_dst, buf + 16, 4);
+			ip_dst = ntohl(ip_dst);
+			printf("%d.%d.%d.%d -> %d.%d.%d.%d, %u bytes\n", PRINT_IP(ip_src), PRINT_IP(ip_dst), bytes);
+		}
+#endif
+		// filter out loopback traffic
+		if (buf[12] != 127 && buf[16] != 127) {
+			// FIXME: error: variable 'bw' set but not used [-Werror,-Wunused-but-set-variable]
+			//bw += bytes + 14; // assume a 14 byte Ethernet layer
+
+			uint32_t ip_src;
+			memcpy(&ip_src, buf + 12, 4);
+			ip_src = ntohl(ip_src);
+
+			uint8_t hlen = (buf[0] & 0x0f) * 4;
+			uint16_t port_src = 0;
+			memcpy(&port_src, buf + hlen, 2);
+			port_src = ntohs(port_src);
+
+			uint8_t protocol = buf[9];
+			hnode_add(ip_src, protocol, port_src);
+		}
+	}
+}
+
 // trace rx traffic coming in
 static void run_trace(void) {
 	logprintf("netlock: accumulating traffic for %d seconds\n", NETLOCK_INTERVAL);
@@ -135,37 +173,7 @@ static void run_trace(void) {
 			sock = s2;
 
 		unsigned bytes = recvfrom(sock, buf, MAX_BUF_SIZE, 0, NULL, NULL);
-		if (bytes >= 20) { // size of IP header
-#ifdef DEBUG
-			{
-				uint32_t ip_src;
-				memcpy(&ip_src, buf + 12, 4);
-				ip_src = ntohl(ip_src);
-
-				uint32_t ip_dst;
-				memcpy(&ip_dst, buf + 16, 4);
-				ip_dst = ntohl(ip_dst);
-				printf("%d.%d.%d.%d -> %d.%d.%d.%d, %u bytes\n", PRINT_IP(ip_src), PRINT_IP(ip_dst), bytes);
-			}
-#endif
-			// filter out loopback traffic
-			if (buf[12] != 127 && buf[16] != 127) {
-				// FIXME: error: variable 'bw' set but not used [-Werror,-Wunused-but-set-variable]
-				//bw += bytes + 14; // assume a 14 byte Ethernet layer
-
-				uint32_t ip_src;
-				memcpy(&ip_src, buf + 12, 4);
-				ip_src = ntohl(ip_src);
-
-				uint8_t hlen = (buf[0] & 0x0f) * 4;
-				uint16_t port_src = 0;
-				memcpy(&port_src, buf + hlen, 2);
-				port_src = ntohs(port_src);
-
-				uint8_t protocol = buf[9];
-				hnode_add(ip_src, protocol, port_src);
-			}
-		}
+		process_packet(buf, bytes);
 	}
 
 	close(s1);
@@ -209,6 +217,38 @@ static int print_filter(FILE *fp) {
 	return 0;
 }
 
+// build the filter from a pcap capture file, without deploying it
+static void run_pcap(void) {
+	PcapFile *p = pcap_file_open(arg_pcap);
+	unsigned char buf[MAX_BUF_SIZE];
+	const unsigned char *pkt;
+	unsigned len;
+	unsigned long packets = 0;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (pcap_file_next_ip(p, &pkt, &len, NULL)) {
+		// the packet parser expects a receive buffer
+		if (len > MAX_BUF_SIZE)
+			len = MAX_BUF_SIZE;
+		memcpy(buf, pkt, len);
+		if (buf[9] != IPPROTO_TCP && buf[9] != IPPROTO_UDP)
+			continue;
+		process_packet(buf, len);
+		packets++;
+	}
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	print_filter(stdout);
+	fprintf(stderr, "pcap: %lu records, %lu packets in %.3f s, %.0f packets/s\n",
+		p->records, packets, sec, (sec > 0) ? packets / sec : 0);
+	fprintf(stderr, "pcap: %u hnode allocations\n", hnode_allocs);
+	pcap_file_close(p);
+}
+
 static char *flush_rules[] = {
 	"-P INPUT ACCEPT",
 //	"-P FORWARD DENY",
@@ -328,10 +368,11 @@ void logprintf(char *fmt, ...) {
 }
 
 static const char *const usage_str =
-	"Usage: fnettrace [OPTIONS]\n"
+	"Usage: fnetlock [OPTIONS]\n"
 	"Options:\n"
 	"   --help, -? - this help screen\n"
 	"   --log=filename - netlocker logfile\n"
+	"   --pcap=filename - print the firewall built from a pcap capture file\n"
 	"   --tail - \"tail -f\" functionality\n";
 
 static void usage(void) {
@@ -350,6 +391,8 @@ int main(int argc, char **argv) {
 			arg_tail = 1;
 		else if (strncmp(argv[i], "--log=", 6) == 0)
 			arg_log = argv[i] + 6;
+		else if (strncmp(argv[i], "--pcap=", 7) == 0)
+			arg_pcap = argv[i] + 7;
 		else {
 			fprintf(stderr, "Error: invalid argument\n");
 			return 1;
@@ -369,6 +412,12 @@ int main(int argc, char **argv) {
 		exit(0);
 	}
 
+	// offline mode, no root privileges required
+	if (arg_pcap) {
+		run_pcap();
+		return 0;
+	}
+
 	if (getuid() != 0) {
 		fprintf(stderr, "Error: you need to be root to run this program\n");
 		return 1;
@@ -18,6 +18,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 #include "fnettrace_dns.h"
+#include "../include/dnsparse.h"
 #include <sys/ioctl.h>
 #include <time.h>
 #include <linux/filter.h>
@@ -27,6 +28,7 @@
 #define MAX_BUF_SIZE (64 * 1024)
 
 static int arg_nolocal = 0;
+static int arg_answers = 0;
 static char last[512] = {'\0'};
 
 // pkt - start of DNS layer
@@ -82,6 +84,13 @@ errout:
 	fflush(0);
 }
 
+// machine readable, consumed by fnettrace
+static void print_answer(const char *name, uint32_t ip, uint32_t ttl, void *arg) {
+	(void) ttl;
+	(void) arg;
+	printf("%s%d.%d.%d.%d %s\n", DNS_ANSWER_TAG, PRINT_IP(ip), name);
+}
+
 // https://www.kernel.org/doc/html/latest/networking/filter.html
 static void custom_bpf(int sock) {
 	struct sock_filter code[] = {
@@ -169,8 +178,14 @@ static void run_trace(void) {
 			}
 
 			// if DNS packet, extract the query
-			if (port_src == 53 && protocol == 0x11) // UDP protocol
-				print_dns(ip_src, buf + 14 + ip_hlen + 8); // IP and UDP header len
+			if (port_src == 53 && protocol == 0x11 && // UDP protocol
+			    bytes >= 14u + ip_hlen + 8) {
+				unsigned char *dns = buf + 14 + ip_hlen + 8; // IP and UDP header len
+				// print_dns() rewrites the question name in place
+				if (arg_answers)
+					dns_parse_answers(dns, bytes - (14 + ip_hlen + 8), print_answer, NULL);
+				print_dns(ip_src, dns);
+			}
 		}
 	}
 
@@ -179,6 +194,7 @@ static void run_trace(void) {
 static const char *const usage_str =
 	"Usage: fnettrace-dns [OPTIONS]\n"
 	"Options:\n"
+	"   --answers - print the addresses found in DNS responses\n"
 	"   --help, -? - this help screen\n"
 	"   --nolocal\n";
 
@@ -196,6 +212,8 @@ int main(int argc, char **argv) {
 		}
 		else if (strcmp(argv[i], "--nolocal") == 0)
 			arg_nolocal = 1;
+		else if (strcmp(argv[i], "--answers") == 0)
+			arg_answers = 1;
 		else {
 			fprintf(stderr, "Error: invalid argument\n");
 			return 1;
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "fnettrace.h"
+
+// IP address to host name map built from the DNS responses seen on the wire;
+// the least recently used entry is dropped when the cache is full
+#define DNSCACHE_MAX 1024
+
+typedef struct dnode_t {
+	struct dnode_t *hnext;	// hash table
+	struct dnode_t *prev;	// LRU list, most recently used first
+	struct dnode_t *next;
+	uint32_t ip;
+	char *name;
+} DNode;
+
+#define DHMAX 256
+static DNode *dtable[DHMAX] = {NULL};
+static DNode *lru_first = NULL;
+static DNode *lru_last = NULL;
+DnsCacheStats dnscache_stats = {0};
+
+static void lru_unlink(DNode *d) {
+	if (d->prev)
+		d->prev->next = d->next;
+	else
+		lru_first = d->next;
+	if (d->next)
+		d->next->prev = d->prev;
+	else
+		lru_last = d->prev;
+	d->prev = d->next = NULL;
+}
+
+static void lru_push(DNode *d) {
+	d->prev = NULL;
+	d->next = lru_first;
+	if (lru_first)
+		lru_first->prev = d;
+	lru_first = d;
+	if (!lru_last)
+		lru_last = d;
+}
+
+static DNode *find(uint32_t ip) {
+	DNode *d = dtable[hash(ip)];
+	while (d) {
+		if (d->ip == ip)
+			return d;
+		d = d->hnext;
+	}
+	return NULL;
+}
+
+static void evict(void) {
+	DNode *d = lru_last;
+	assert(d);
+	lru_unlink(d);
+
+	DNode **pp = &dtable[hash(d->ip)];
+	while (*pp != d)
+		pp = &(*pp)->hnext;
+	*pp = d->hnext;
+
+	dnscache_stats.entries--;
+	dnscache_stats.bytes -= sizeof(DNode) + strlen(d->name) + 1;
+	dnscache_stats.evictions++;
+	free(d->name);
+	free(d);
+}
+
+void dnscache_add(uint32_t ip, const char *name) {
+	assert(name);
+	DNode *d = find(ip);
+	if (d) {
+		if (strcmp(d->name, name)) {
+			dnscache_stats.bytes += strlen(name);
+			dnscache_stats.bytes -= strlen(d->name);
+			free(d->name);
+			d->name = strdup(name);
+			if (!d->name)
+				errExit("strdup");
+		}
+		lru_unlink(d);
+		lru_push(d);
+		return;
+	}
+
+	if (dnscache_stats.entries >= DNSCACHE_MAX)
+		evict();
+
+	d = malloc(sizeof(DNode));
+	if (!d)
+		errExit("malloc");
+	d->ip = ip;
+	d->name = strdup(name);
+	if (!d->name)
+		errExit("strdup");
+	uint8_t h = hash(ip);
+	d->hnext = dtable[h];
+	dtable[h] = d;
+	lru_push(d);
+
+	dnscache_stats.entries++;
+	dnscache_stats.bytes += sizeof(DNode) + strlen(name) + 1;
+	dnscache_stats.inserts++;
+}
+
+// callback for dns_parse_answers()
+void dnscache_answer(const char *name, uint32_t ip, uint32_t ttl, void *arg) {
+	(void) ttl;
+	(void) arg;
+	dnscache_add(ip, name);
+}
+
+// a line printed by fnettrace-dns --answers: "1.2.3.4 name"
+void dnscache_add_line(const char *line) {
+	assert(line);
+	unsigned a, b, c, d;
+	char name[256];
+	if (sscanf(line, "%u.%u.%u.%u %255s", &a, &b, &c, &d, name) != 5 ||
+	    a > 255 || b > 255 || c > 255 || d > 255)
+		return;
+	dnscache_add(a << 24 | b << 16 | c << 8 | d, name);
+}
+
+// never blocks; returns NULL if the address was not seen in a DNS response
+const char *dnscache_get(uint32_t ip) {
+	DNode *d = find(ip);
+	if (!d)
+		return NULL;
+	lru_unlink(d);
+	lru_push(d);
+	return d->name;
+}
+
+// same as dnscache_get(), the result is counted in the statistics
+const char *dnscache_lookup(uint32_t ip) {
+	const char *rv = dnscache_get(ip);
+	if (rv)
+		dnscache_stats.hits++;
+	else
+		dnscache_stats.misses++;
+	return rv;
+}
+
+void dnscache_clear_stats(void) {
+	dnscache_stats.hits = 0;
+	dnscache_stats.misses = 0;
+	dnscache_stats.evictions = 0;
+	dnscache_stats.inserts = 0;
+}
+
+void dnscache_print_stats(FILE *fp) {
+	assert(fp);
+	unsigned lookups = dnscache_stats.hits + dnscache_stats.misses;
+	fprintf(fp, "   DNS cache: %u names, %zu bytes, %u hits, %u misses (%u%% hit rate), %u evictions\n",
+		dnscache_stats.entries, dnscache_stats.bytes, dnscache_stats.hits, dnscache_stats.misses,
+		(lookups) ? (unsigned) (100ULL * dnscache_stats.hits / lookups) : 0,
+		dnscache_stats.evictions);
+}
@@ -88,6 +88,24 @@ extern int geoip_calls;
 void load_hostnames(const char *fname);
 char* retrieve_hostname(uint32_t ip);
 
+// dnscache.c
+typedef struct {
+	unsigned entries;
+	size_t bytes;		// nodes and names
+	unsigned inserts;
+	unsigned evictions;
+	unsigned hits;
+	unsigned misses;
+} DnsCacheStats;
+extern DnsCacheStats dnscache_stats;
+void dnscache_add(uint32_t ip, const char *name);
+void dnscache_answer(const char *name, uint32_t ip, uint32_t ttl, void *arg);
+void dnscache_add_line(const char *line);
+const char *dnscache_get(uint32_t ip);
+const char *dnscache_lookup(uint32_t ip);
+void dnscache_clear_stats(void);
+void dnscache_print_stats(FILE *fp);
+
 // tail.c
 void tail(const char *logfile);
 
@@ -19,6 +19,8 @@
 */
 #include "fnettrace.h"
 #include "radix.h"
+#include "../include/pcapfile.h"
+#include "../include/dnsparse.h"
 #include <limits.h>
 #include <sys/ioctl.h>
 #include <sys/prctl.h>
@@ -26,6 +28,7 @@
 #define MAX_BUF_SIZE (64 * 1024)
 
 static char *arg_log = NULL;
+static char *arg_pcap = NULL;
 
 // only 0 or negative values; positive values as defined in RFC
 #define PROTOCOL_ICMP 0
@@ -80,6 +83,7 @@ typedef struct hnode_t {
 	// the firewall is build based on source address, and in the linked list
 	// we could have elements with the same address but different ports
 	uint8_t ip_instance;
+	uint8_t dns_counted;	// the host name lookup was counted in the DNS cache statistics
 	int ttl;
 } HNode;
 
@@ -93,11 +97,14 @@ HNode *dlist = NULL;
 // speed up malloc/free
 #define HNODE_MAX_MALLOC 16
 static HNode *hnode_unused = NULL;
+static unsigned hnode_mallocs = 0;	// malloc calls
+static unsigned hnode_allocs = 0;	// hnode_add allocations
 HNode *hmalloc(void) {
 	if (hnode_unused == NULL) {
 		hnode_unused = malloc(sizeof(HNode) * HNODE_MAX_MALLOC);
 		if (!hnode_unused)
 			errExit("malloc");
+		hnode_mallocs++;
 		memset(hnode_unused, 0, sizeof(HNode) * HNODE_MAX_MALLOC);
 		HNode *ptr = hnode_unused;
 		int i;
@@ -107,6 +114,7 @@ HNode *hmalloc(void) {
 
 	HNode *rv = hnode_unused;
 	hnode_unused = hnode_unused->hnext;
+	hnode_allocs++;
 	return rv;
 }
 
@@ -346,7 +354,8 @@ static void hnode_print(unsigned bw) {
 	debug_hnode();
 	printf("*********************\n");
 #else
-	ansi_clrscr();
+	if (!arg_pcap)
+		ansi_clrscr();
 #endif
 
 	// get terminal size
@@ -372,7 +381,8 @@ static void hnode_print(unsigned bw) {
 	char faint2[] = {0x1b, '[', '0', 'm', '\0'};
 	int len = snprintf(line, LINE_MAX, "%32s %saddress:port (protocol) network%s\n", stats, faint1, faint2);
 	adjust_line(line, len, cols);
-	printf("%s", line);
+	if (!arg_pcap)
+		printf("%s", line);
 
 	HNode *ptr = dlist;
 	HNode *prev = NULL;
@@ -455,14 +465,31 @@ static void hnode_print(unsigned bw) {
 
 			if (protocol == NULL)
 				protocol = "";
+
+			// host name from the DNS responses, network name from the IP map;
+			// the screen is refreshed every display interval, a stream counts as one lookup
+			const char *host;
+			if (ptr->dns_counted)
+				host = dnscache_get(ptr->ip_src);
+			else {
+				host = dnscache_lookup(ptr->ip_src);
+				ptr->dns_counted = 1;
+			}
+			const char *sep = " ";
+			const char *network = ptr->rnode->name;
+			if (!host)
+				host = sep = "";
+			else if (strcmp(network, " ") == 0)
+				network = "";
 			if (ptr->port_src == PROTOCOL_ICMP)
-				len = snprintf(line, LINE_MAX, "%10s %s %d.%d.%d.%d (ICMP) %s\n",
-					       bytes, bwline, PRINT_IP(ptr->ip_src), ptr->rnode->name);
+				len = snprintf(line, LINE_MAX, "%10s %s %d.%d.%d.%d (ICMP) %s%s%s\n",
+					       bytes, bwline, PRINT_IP(ptr->ip_src), host, sep, network);
 			else
-				len = snprintf(line, LINE_MAX, "%10s %s %d.%d.%d.%d:%u (%s) %s\n",
-					       bytes, bwline, PRINT_IP(ptr->ip_src), ptr->port_src, protocol, ptr->rnode->name);
+				len = snprintf(line, LINE_MAX, "%10s %s %d.%d.%d.%d:%u (%s) %s%s%s\n",
+					       bytes, bwline, PRINT_IP(ptr->ip_src), ptr->port_src, protocol, host, sep, network);
 			adjust_line(line, len, cols);
-			printf("%s", line);
+			if (!arg_pcap)
+				printf("%s", line);
 
 			if (ptr->bytes)
 				ptr->ttl = DISPLAY_TTL;
@@ -481,7 +508,8 @@ static void hnode_print(unsigned bw) {
 
 		ptr = next;
 	}
-	ansi_faint("(D)isplay, (S)ave, (C)lear, e(X)it\n");
+	if (!arg_pcap)
+		ansi_faint("(D)isplay, (S)ave, (C)lear, e(X)it\n");
 
 #ifdef DEBUG
 	{
@@ -505,6 +533,7 @@ static void print_stats(FILE *fp) {
 	fprintf(fp, "   unencrypted: HTTP %u\n", stats_http);
 	fprintf(fp, "   C&C backchannel: SSH %u, PING %u, DNS %u, DoH %u, DoT %u, DoQ %u\n",
 		stats_ssh, stats_icmp_echo, stats_dns, stats_dns_doh, stats_dns_dot, stats_dns_doq);
+	dnscache_print_stats(fp);
 
 	fprintf(fp, "\n\nIP map");
 	if (fp == stdout)
@@ -524,6 +553,89 @@ static void print_stats(FILE *fp) {
 
 
 
+// account for an incoming IPv4 packet; returns the number of bytes added to the bandwidth
+static unsigned process_packet(unsigned char *buf, unsigned bytes, int icmp) {
+	unsigned bw = 0;
+	if (bytes >= 20) { // minimum size of IP packet
+#ifdef DEBUG
+		{
+			uint32_t ip_src;
+			memcpy(&ip_src, buf + 12, 4);
+			ip_src = ntohl(ip_src);
+
+			uint32_t ip_dst;
+			memcpy(&ip_dst, buf + 16, 4);
+			ip_dst = ntohl(ip_dst);
+			printf("%d.%d.%d.%d -> %d.%d.%d.%d, %u bytes\n", PRINT_IP(ip_src), PRINT_IP(ip_dst), bytes);
+		}
+#endif
+		// filter out loopback traffic
+		if (buf[12] != 127 && buf[16] != 127) {
+			bw += bytes + 14; // assume a 14 byte Ethernet layer
+
+			uint32_t ip_src;
+			memcpy(&ip_src, buf + 12, 4);
+			ip_src = ntohl(ip_src);
+
+			uint8_t hlen = (buf[0] & 0x0f) * 4;
+			uint16_t port_src = 0;
+			if (icmp)
+				hnode_add(ip_src, PROTOCOL_ICMP, 0, bytes + 14);
+			else { // itcp or udp
+				memcpy(&port_src, buf + hlen, 2);
+				port_src = ntohs(port_src);
+				int protocol = (int) buf[9];
+
+				// detect ssh on a standard or not so standard port (22)
+				if (protocol == 6) { // tcp
+					uint8_t dataoffset = *(buf + hlen + 12);
+					uint8_t tcphlen = (dataoffset >> 2);
+					if (memcmp(buf + hlen + tcphlen, "SSH-", 4) == 0) {
+						time_t seconds = time(NULL);
+						struct tm *t = localtime(&seconds);
+						char ip[30];
+						sprintf(ip, "%d.%d.%d.%d", PRINT_IP(ip_src));
+						char *msg;
+						if (asprintf(&msg, "%02d:%02d:%02d  %-15s  SSH connection",
+							t->tm_hour, t->tm_min, t->tm_sec, ip) == -1)
+							errExit("asprintf");
+						ev_add(msg);
+						free(msg);
+						protocol = PROTOCOL_SSH;
+					}
+				}
+				hnode_add(ip_src, protocol, port_src, bytes + 14);
+			}
+
+			// stats
+			stats_pkts++;
+			if (icmp)  {
+				if (*(buf + hlen) == 0 || *(buf + hlen) == 8)
+					stats_icmp_echo++;
+			}
+
+		}
+	}
+
+	return bw;
+}
+
+// fnettrace-dns output: the answers go in the DNS cache, the queries in the event list
+static void dns_lines(char *buf) {
+	size_t taglen = strlen(DNS_ANSWER_TAG);
+	char *line = buf;
+	while (line && *line) {
+		char *next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		if (strncmp(line, DNS_ANSWER_TAG, taglen) == 0)
+			dnscache_add_line(line + taglen);
+		else if (strncmp(line, "DNS trace", 9))
+			ev_add(line);
+		line = next;
+	}
+}
+
 // trace rx traffic coming in
 static void run_trace(void) {
 	// trace only rx ipv4 tcp and upd
@@ -538,7 +650,7 @@ static void run_trace(void) {
 	if (p1 != -1)
 		printf("loading snitrace...");
 
-	int p2 = runprog(LIBDIR "/firejail/fnettrace-dns");
+	int p2 = runprog(LIBDIR "/firejail/fnettrace-dns --answers");
 	if (p2 != -1)
 		printf("loading dnstrace...");
 	unsigned last_print_traces = 0;
@@ -593,6 +705,7 @@ static void run_trace(void) {
 			int c = getchar();
 			if (c == 'c' || c == 'C') {
 				clear_stats();
+				dnscache_clear_stats();
 				ev_clear();
 				radix_clear_data();
 				continue;
@@ -677,7 +790,7 @@ static void run_trace(void) {
 				continue;
 
 			buf[sz] = '\0';
-			ev_add(buf);
+			dns_lines(buf);
 			continue;
 		}
 		// by default we assume TCP
@@ -689,66 +802,7 @@ static void run_trace(void) {
 		}
 
 		unsigned bytes = recvfrom(sock, buf, MAX_BUF_SIZE, 0, NULL, NULL);
-		if (bytes >= 20) { // minimum size of IP packet
-#ifdef DEBUG
-			{
-				uint32_t ip_src;
-				memcpy(&ip_src, buf + 12, 4);
-				ip_src = ntohl(ip_src);
-
-				uint32_t ip_dst;
-				memcpy(&ip_dst, buf + 16, 4);
-				ip_dst = ntohl(ip_dst);
-				printf("%d.%d.%d.%d -> %d.%d.%d.%d, %u bytes\n", PRINT_IP(ip_src), PRINT_IP(ip_dst), bytes);
-			}
-#endif
-			// filter out loopback traffic
-			if (buf[12] != 127 && buf[16] != 127) {
-				bw += bytes + 14; // assume a 14 byte Ethernet layer
-
-				uint32_t ip_src;
-				memcpy(&ip_src, buf + 12, 4);
-				ip_src = ntohl(ip_src);
-
-				uint8_t hlen = (buf[0] & 0x0f) * 4;
-				uint16_t port_src = 0;
-				if (icmp)
-					hnode_add(ip_src, PROTOCOL_ICMP, 0, bytes + 14);
-				else { // itcp or udp
-					memcpy(&port_src, buf + hlen, 2);
-					port_src = ntohs(port_src);
-					int protocol = (int) buf[9];
-
-					// detect ssh on a standard or not so standard port (22)
-					if (protocol == 6) { // tcp
-						uint8_t dataoffset = *(buf + hlen + 12);
-						uint8_t tcphlen = (dataoffset >> 2);
-						if (memcmp(buf + hlen + tcphlen, "SSH-", 4) == 0) {
-							time_t seconds = time(NULL);
-							struct tm *t = localtime(&seconds);
-							char ip[30];
-							sprintf(ip, "%d.%d.%d.%d", PRINT_IP(ip_src));
-							char *msg;
-							if (asprintf(&msg, "%02d:%02d:%02d  %-15s  SSH connection",
-								t->tm_hour, t->tm_min, t->tm_sec, ip) == -1)
-								errExit("asprintf");
-							ev_add(msg);
-							free(msg);
-							protocol = PROTOCOL_SSH;
-						}
-					}
-					hnode_add(ip_src, protocol, port_src, bytes + 14);
-				}
-
-				// stats
-				stats_pkts++;
-				if (icmp)  {
-					if (*(buf + hlen) == 0 || *(buf + hlen) == 8)
-						stats_icmp_echo++;
-				}
-
-			}
-		}
+		bw += process_packet(buf, bytes, icmp);
 	}
 
 	close(s1);
@@ -761,6 +815,58 @@ static void run_trace(void) {
 }
 
 
+// run a capture file through the same pipeline as fast as possible; the display
+// intervals follow the timestamps in the file
+static void run_pcap(void) {
+	PcapFile *p = pcap_file_open(arg_pcap);
+	unsigned char buf[MAX_BUF_SIZE];
+	const unsigned char *pkt;
+	unsigned len;
+	uint64_t ts;
+	uint64_t last_print = 0;
+	unsigned bw = 0;
+	unsigned long packets = 0;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (pcap_file_next_ip(p, &pkt, &len, &ts)) {
+		if (last_print == 0)
+			last_print = ts;
+		else if (ts - last_print >= DISPLAY_INTERVAL * 1000) {
+			hnode_print(bw);
+			last_print = ts;
+			bw = 0;
+		}
+
+		// the packet parser expects a receive buffer
+		if (len > MAX_BUF_SIZE)
+			len = MAX_BUF_SIZE;
+		memcpy(buf, pkt, len);
+		unsigned char protocol = buf[9];
+		if (protocol != IPPROTO_TCP && protocol != IPPROTO_UDP && protocol != IPPROTO_ICMP)
+			continue;
+
+		// DNS responses feed the host name cache, the same as fnettrace-dns --answers in live mode
+		unsigned hlen = (buf[0] & 0x0f) * 4;
+		if (protocol == IPPROTO_UDP && len >= hlen + 8 && buf[hlen] == 0 && buf[hlen + 1] == 53)
+			dns_parse_answers(buf + hlen + 8, len - hlen - 8, dnscache_answer, NULL);
+		bw += process_packet(buf, len, protocol == IPPROTO_ICMP);
+		packets++;
+	}
+	hnode_print(bw);
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	print_stats(stdout);
+	printf("\n\npcap: %lu records, %lu packets in %.3f s, %.0f packets/s\n",
+		p->records, packets, sec, (sec > 0) ? packets / sec : 0);
+	printf("pcap: %u hnode allocations, %u malloc calls, %d radix nodes, %d events\n",
+		hnode_allocs, hnode_mallocs, radix_nodes, ev_cnt);
+	pcap_file_close(p);
+}
+
 void logprintf(char *fmt, ...) {
 	if (!arg_log)
 		return;
@@ -785,6 +891,7 @@ static const char *const usage_str =
 	"Options:\n"
 	"   --help, -? - this help screen\n"
 	"   --log=filename - netlocker logfile\n"
+	"   --pcap=filename - read the traffic from a pcap capture file\n"
 	"   --print-map - print IP map\n"
 	"   --squash-map - compress IP map\n";
 
@@ -846,12 +953,21 @@ int main(int argc, char **argv) {
 		}
 		else if (strncmp(argv[i], "--log=", 6) == 0)
 			arg_log = argv[i] + 6;
+		else if (strncmp(argv[i], "--pcap=", 7) == 0)
+			arg_pcap = argv[i] + 7;
 		else {
 			fprintf(stderr, "Error: invalid argument\n");
 			return 1;
 		}
 	}
 
+	// offline mode, no root privileges required
+	if (arg_pcap) {
+		load_hostnames(LIBDIR "/firejail/static-ip-map");
+		run_pcap();
+		return 0;
+	}
+
 	if (getuid() != 0) {
 		fprintf(stderr, "Error: you need to be root to run this program\n");
 		return 1;
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef DNSPARSE_H
+#define DNSPARSE_H
+#include <stdint.h>
+
+// fnettrace-dns --answers prints one line for every A record: "answer 1.2.3.4 name"
+#define DNS_ANSWER_TAG "answer "
+
+// called for every A record in a DNS response; name is the name in the question section
+typedef void (dns_answer_fn)(const char *name, uint32_t ip, uint32_t ttl, void *arg);
+
+// pkt - start of the DNS layer, len - length of the DNS layer;
+// returns the number of A records found, or -1 if the packet is malformed
+int dns_parse_answers(const unsigned char *pkt, unsigned len, dns_answer_fn *cb, void *arg);
+
+#endif
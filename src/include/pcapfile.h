@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef PCAPFILE_H
+#define PCAPFILE_H
+#include <stdint.h>
+#include <stddef.h>
+
+// classic pcap capture file, mapped in memory; no dependency on libpcap
+typedef struct {
+	const unsigned char *data;
+	size_t size;
+	size_t offset;		// next record
+	int swap;		// file written on a host with a different byte order
+	int nsec;		// nanosecond timestamps
+	uint32_t linktype;
+	unsigned long records;	// records read so far, including the skipped ones
+} PcapFile;
+
+// open the file, exit on error
+PcapFile *pcap_file_open(const char *fname);
+void pcap_file_close(PcapFile *p);
+// next incoming IPv4 packet; returns 0 at the end of the file, 1 otherwise;
+// the timestamp is in milliseconds
+int pcap_file_next_ip(PcapFile *p, const unsigned char **pkt, unsigned *len, uint64_t *ts);
+
+#endif
@@ -32,6 +32,9 @@
 #define RUN_FIREJAIL_BANDWIDTH_DIR	RUN_FIREJAIL_DIR "/bandwidth"
 #define RUN_FIREJAIL_PROFILE_DIR	RUN_FIREJAIL_DIR "/profile"
 #define RUN_FIREJAIL_DBUS_DIR RUN_FIREJAIL_DIR "/dbus"
+#define RUN_FIREJAIL_TEMPLATE_DIR	RUN_FIREJAIL_DIR "/template"
+#define RUN_FIREJAIL_AGENT_DIR		RUN_FIREJAIL_DIR "/agent"
+#define RUN_FIREJAIL_POOL_DIR		RUN_FIREJAIL_DIR "/pool"
 #define RUN_NETWORK_LOCK_FILE		RUN_FIREJAIL_DIR "/firejail-network.lock"
 #define RUN_DIRECTORY_LOCK_FILE		RUN_FIREJAIL_DIR "/firejail-run.lock"
 #define RUN_RO_DIR			RUN_FIREJAIL_DIR "/firejail.ro.dir"
@@ -50,13 +53,9 @@
 #define RUN_PULSE_DIR			RUN_MNT_DIR "/pulse"
 #define RUN_LIB_DIR			RUN_MNT_DIR "/lib"
 #define RUN_LIB_FILE			RUN_MNT_DIR "/libfiles"
+#define RUN_LDSO_CACHE			RUN_MNT_DIR "/ld.so.cache"
 #define RUN_DNS_ETC			RUN_MNT_DIR "/dns-etc"
-#define RUN_DHCLIENT_DIR			RUN_MNT_DIR "/dhclient-dir"
-#define RUN_DHCLIENT_4_LEASES_FILE		RUN_DHCLIENT_DIR "/dhclient.leases"
-#define RUN_DHCLIENT_6_LEASES_FILE		RUN_DHCLIENT_DIR "/dhclient6.leases"
-#define RUN_DHCLIENT_4_LEASES_FILE		RUN_DHCLIENT_DIR "/dhclient.leases"
-#define RUN_DHCLIENT_4_PID_FILE			RUN_DHCLIENT_DIR "/dhclient.pid"
-#define RUN_DHCLIENT_6_PID_FILE			RUN_DHCLIENT_DIR "/dhclient6.pid"
+#define RUN_DHCP_PID_FILE		RUN_MNT_DIR "/dhcp.pid"
 #define RUN_DBUS_DIR        RUN_MNT_DIR "/dbus"
 #define RUN_DBUS_USER_SOCKET        RUN_DBUS_DIR "/user"
 #define RUN_DBUS_SYSTEM_SOCKET      RUN_DBUS_DIR "/system"
@@ -101,6 +100,7 @@
 #define RUN_TRACE_FILE			RUN_MNT_DIR "/trace"
 #define RUN_UMASK_FILE			RUN_MNT_DIR "/umask"
 #define RUN_JOIN_FILE	 		RUN_MNT_DIR "/join"
+#define RUN_JOIN_STATE			RUN_MNT_DIR "/join.state"
 #define RUN_OVERLAY_ROOT		RUN_MNT_DIR "/oroot"
 #define RUN_RESOLVCONF_FILE		RUN_MNT_DIR "/resolv.conf"
 
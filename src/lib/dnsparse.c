@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "../include/common.h"
+#include "../include/dnsparse.h"
+
+#define DNS_HDR_LEN 12
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+
+static inline uint16_t get16(const unsigned char *ptr) {
+	return (uint16_t) ((ptr[0] << 8) | ptr[1]);
+}
+
+// labels can hold any byte; the name ends up on a terminal and in "ip name" lines,
+// control characters, spaces and non-ASCII bytes are replaced
+static void sanitize(char *str, unsigned len) {
+	unsigned i;
+	for (i = 0; i < len; i++) {
+		unsigned char c = (unsigned char) str[i];
+		if (c <= 0x20 || c >= 0x7f)
+			str[i] = '?';
+	}
+}
+
+// skip a possibly compressed name; returns the offset after the name, or 0 on error
+static unsigned skip_name(const unsigned char *pkt, unsigned len, unsigned offset) {
+	while (offset < len) {
+		unsigned char c = pkt[offset];
+		if (c == 0)
+			return offset + 1;
+		if ((c & 0xc0) == 0xc0)	// compression pointer, always the last element
+			return (offset + 2 <= len) ? offset + 2 : 0;
+		if (c > 63)
+			return 0;
+		offset += c + 1;
+	}
+	return 0;
+}
+
+int dns_parse_answers(const unsigned char *pkt, unsigned len, dns_answer_fn *cb, void *arg) {
+	assert(pkt);
+	assert(cb);
+	if (len < DNS_HDR_LEN)
+		return -1;
+
+	// responses only, no errors, a single question
+	if ((pkt[2] & 0x80) == 0 || (pkt[3] & 0x0f) != 0)
+		return 0;
+	if (get16(pkt + 4) != 1)
+		return -1;
+	unsigned ancount = get16(pkt + 6);
+
+	// question name, never compressed
+	char name[256];
+	unsigned nlen = 0;
+	unsigned offset = DNS_HDR_LEN;
+	while (offset < len && pkt[offset] != 0) {
+		unsigned label = pkt[offset];
+		if (label > 63 || offset + 1 + label > len || nlen + label + 1 >= sizeof(name))
+			return -1;
+		if (nlen)
+			name[nlen++] = '.';
+		memcpy(name + nlen, pkt + offset + 1, label);
+		sanitize(name + nlen, label);
+		nlen += label;
+		offset += label + 1;
+	}
+	if (offset >= len || nlen == 0)
+		return -1;
+	name[nlen] = '\0';
+	offset += 1 + 4;	// end of name, type and class
+
+	// answer section; the A records at the end of a CNAME chain are reported with the question name
+	int cnt = 0;
+	unsigned i;
+	for (i = 0; i < ancount; i++) {
+		offset = skip_name(pkt, len, offset);
+		if (offset == 0 || offset + 10 > len)
+			return -1;
+		uint16_t type = get16(pkt + offset);
+		uint16_t class = get16(pkt + offset + 2);
+		uint32_t ttl = ((uint32_t) get16(pkt + offset + 4) << 16) | get16(pkt + offset + 6);
+		uint16_t rdlen = get16(pkt + offset + 8);
+		offset += 10;
+		if (offset + rdlen > len)
+			return -1;
+
+		if (type == DNS_TYPE_A && class == DNS_CLASS_IN && rdlen == 4) {
+			uint32_t ip = ((uint32_t) get16(pkt + offset) << 16) | get16(pkt + offset + 2);
+			cb(name, ip, ttl, arg);
+			cnt++;
+		}
+		offset += rdlen;
+	}
+
+	return cnt;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2014-2024 Firejail Authors
+ *
+ * This file is part of firejail project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "../include/common.h"
+#include "../include/pcapfile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define PCAP_HDR_LEN 24
+#define PCAP_REC_LEN 16
+
+// link types
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW 101
+#define LINKTYPE_LINUX_SLL 113
+#define LINKTYPE_IPV4 228
+#define LINKTYPE_LINUX_SLL2 276
+
+static uint32_t get32(const PcapFile *p, const unsigned char *ptr) {
+	uint32_t v;
+	memcpy(&v, ptr, 4);
+	return (p->swap) ? __builtin_bswap32(v) : v;
+}
+
+PcapFile *pcap_file_open(const char *fname) {
+	int fd = open(fname, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		fprintf(stderr, "Error: cannot open %s\n", fname);
+		exit(1);
+	}
+	struct stat s;
+	if (fstat(fd, &s) == -1)
+		errExit("fstat");
+	if (s.st_size < PCAP_HDR_LEN) {
+		fprintf(stderr, "Error: %s is not a pcap file\n", fname);
+		exit(1);
+	}
+
+	PcapFile *p = malloc(sizeof(PcapFile));
+	if (!p)
+		errExit("malloc");
+	memset(p, 0, sizeof(PcapFile));
+	p->size = s.st_size;
+	p->data = mmap(NULL, p->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p->data == MAP_FAILED)
+		errExit("mmap");
+	close(fd);
+	madvise((void *) p->data, p->size, MADV_SEQUENTIAL);
+
+	uint32_t magic;
+	memcpy(&magic, p->data, 4);
+	if (magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC)
+		p->swap = 0;
+	else if (__builtin_bswap32(magic) == PCAP_MAGIC || __builtin_bswap32(magic) == PCAP_MAGIC_NSEC) {
+		p->swap = 1;
+		magic = __builtin_bswap32(magic);
+	}
+	else {
+		fprintf(stderr, "Error: %s is not a pcap file (pcapng files are not supported)\n", fname);
+		exit(1);
+	}
+	p->nsec = (magic == PCAP_MAGIC_NSEC);
+	p->linktype = get32(p, p->data + 20) & 0x0fffffff;
+
+	switch (p->linktype) {
+	case LINKTYPE_ETHERNET:
+	case LINKTYPE_RAW:
+	case LINKTYPE_LINUX_SLL:
+	case LINKTYPE_IPV4:
+	case LINKTYPE_LINUX_SLL2:
+		break;
+	default:
+		fprintf(stderr, "Error: unsupported link type %u in %s\n", p->linktype, fname);
+		exit(1);
+	}
+
+	p->offset = PCAP_HDR_LEN;
+	return p;
+}
+
+void pcap_file_close(PcapFile *p) {
+	assert(p);
+	munmap((void *) p->data, p->size);
+	free(p);
+}
+
+// return the offset of the IPv4 header, or -1 if the packet is not an incoming IPv4 packet
+static int link_header(const PcapFile *p, const unsigned char *pkt, unsigned len) {
+	uint16_t proto;
+	switch (p->linktype) {
+	case LINKTYPE_ETHERNET: {
+		unsigned off = 12;
+		if (len < 14)
+			return -1;
+		proto = pkt[off] << 8 | pkt[off + 1];
+		// VLAN tags
+		while ((proto == 0x8100 || proto == 0x88a8) && off + 6 <= len) {
+			off += 4;
+			proto = pkt[off] << 8 | pkt[off + 1];
+		}
+		return (proto == 0x0800) ? (int) off + 2 : -1;
+	}
+	case LINKTYPE_LINUX_SLL:
+		// packet type 4 is outgoing traffic
+		if (len < 16 || (pkt[0] << 8 | pkt[1]) == 4)
+			return -1;
+		proto = pkt[14] << 8 | pkt[15];
+		return (proto == 0x0800) ? 16 : -1;
+	case LINKTYPE_LINUX_SLL2:
+		if (len < 20 || pkt[10] == 4)
+			return -1;
+		proto = pkt[0] << 8 | pkt[1];
+		return (proto == 0x0800) ? 20 : -1;
+	default: // raw IP
+		return (len && (pkt[0] >> 4) == 4) ? 0 : -1;
+	}
+}
+
+int pcap_file_next_ip(PcapFile *p, const unsigned char **pkt, unsigned *len, uint64_t *ts) {
+	assert(p);
+	assert(pkt);
+	assert(len);
+
+	while (p->offset + PCAP_REC_LEN <= p->size) {
+		const unsigned char *rec = p->data + p->offset;
+		uint32_t sec = get32(p, rec);
+		uint32_t frac = get32(p, rec + 4);
+		uint32_t caplen = get32(p, rec + 8);
+		if (caplen > p->size - p->offset - PCAP_REC_LEN) // truncated file
+			return 0;
+		const unsigned char *data = rec + PCAP_REC_LEN;
+		p->offset += PCAP_REC_LEN + caplen;
+		p->records++;
+
+		int off = link_header(p, data, caplen);
+		if (off < 0 || caplen - off < 20)
+			continue;
+
+		*pkt = data + off;
+		*len = caplen - off;
+		if (ts)
+			*ts = (uint64_t) sec * 1000 + ((p->nsec) ? frac / 1000000 : frac / 1000);
+		return 1;
+	}
+
+	return 0;
+}
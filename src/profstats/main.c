@@ -21,56 +21,100 @@
 #include "../include/common.h"
 
 #define MAXBUF 2048
+#define MAX_LEVEL 32
+#define HASH_SIZE 1024
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+// counters
+typedef enum {
+	CNT_DOTLOCAL = 0,
+	CNT_GLOBALSDOTLOCAL,
+	CNT_SSH,		// include disable-common.inc
+	CNT_SECCOMP,
+	CNT_CAPS,
+	CNT_NOEXEC,		// include disable-exec.inc
+	CNT_NOROOT,
+	CNT_MDWX,
+	CNT_RESTRICT_NAMESPACES,
+	CNT_APPARMOR,
+	CNT_PRIVATEBIN,
+	CNT_PRIVATEDEV,
+	CNT_PRIVATEETC,
+	CNT_PRIVATELIB,
+	CNT_PRIVATETMP,
+	CNT_WHITELISTHOME,
+	CNT_WHITELISTVAR,	// include whitelist-var-common.inc
+	CNT_WHITELISTRUNUSER,	// include whitelist-runuser-common.inc
+	CNT_WHITELISTUSRSHARE,	// include whitelist-usr-share-common.inc
+	CNT_NETNONE,
+	CNT_DBUS_USER_NONE,
+	CNT_DBUS_USER_FILTER,
+	CNT_DBUS_SYSTEM_NONE,
+	CNT_DBUS_SYSTEM_FILTER,
+	CNT_MAX // this should always be the last entry
+} Counter;
+
+// counter names used in the JSON output
+static const char *const cnt_name[CNT_MAX] = {
+	"include-local",
+	"include-globals",
+	"disable-common",
+	"seccomp",
+	"caps",
+	"disable-exec",
+	"noroot",
+	"memory-deny-write-execute",
+	"restrict-namespaces",
+	"apparmor",
+	"private-bin",
+	"private-dev",
+	"private-etc",
+	"private-lib",
+	"private-tmp",
+	"whitelist-home",
+	"whitelist-var",
+	"whitelist-runuser",
+	"whitelist-usrshare",
+	"net-none",
+	"dbus-user-none",
+	"dbus-user-filter",
+	"dbus-system-none",
+	"dbus-system-filter"
+};
+
 // stats
 static int cnt_profiles = 0;
-static int cnt_apparmor = 0;
-static int cnt_seccomp = 0;
-static int cnt_restrict_namespaces = 0;
-static int cnt_caps = 0;
-static int cnt_dbus_system_none = 0;
-static int cnt_dbus_user_none = 0;
-static int cnt_dbus_system_filter = 0;
-static int cnt_dbus_user_filter = 0;
-static int cnt_dotlocal = 0;
-static int cnt_globalsdotlocal = 0;
-static int cnt_netnone = 0;
-static int cnt_noexec = 0;	// include disable-exec.inc
-static int cnt_privatebin = 0;
-static int cnt_privatedev = 0;
-static int cnt_privatetmp = 0;
-static int cnt_privateetc = 0;
-static int cnt_privatelib = 0;
-static int cnt_whitelistvar = 0;	// include whitelist-var-common.inc
-static int cnt_whitelistrunuser = 0;	// include whitelist-runuser-common.inc
-static int cnt_whitelistusrshare = 0;	// include whitelist-usr-share-common.inc
-static int cnt_ssh = 0;
-static int cnt_mdwx = 0;
-static int cnt_whitelisthome = 0;
-static int cnt_noroot = 0;
+static int cnt[CNT_MAX];
+
+// Every profile and include file is parsed only once. The result is kept
+// together with the counters accumulated over the whole include tree, so
+// common include files cost a hash lookup for each profile using them.
+typedef struct event_t {
+	struct event_t *next;
+	char *line;			// line printed by --print-blacklist and --print-whitelist
+	struct pfile_t *include;	// or an included file
+} Event;
+
+typedef struct pfile_t {
+	struct pfile_t *next;		// hash chain
+	char *name;			// name as specified in the include command
+	char *path;			// file opened; for missing files, the last path tried
+	int found;
+	int have_include_local;
+	int parsing;			// include loop detection
+	int total[CNT_MAX];		// counters for the file and all the included files
+	Event *events;
+	Event *last_event;
+} PFile;
+
+static PFile *htable[HASH_SIZE] = {NULL};
 
 static int level = 0;
 static int arg_debug = 0;
-static int arg_apparmor = 0;
-static int arg_caps = 0;
-static int arg_seccomp = 0;
-static int arg_noexec = 0;
-static int arg_privatebin = 0;
-static int arg_privatedev = 0;
-static int arg_privatetmp = 0;
-static int arg_privateetc = 0;
-static int arg_privatelib = 0;
-static int arg_whitelistvar = 0;
-static int arg_whitelistrunuser = 0;
-static int arg_whitelistusrshare = 0;
-static int arg_ssh = 0;
-static int arg_mdwx = 0;
-static int arg_dbus_system_none = 0;
-static int arg_dbus_user_none = 0;
-static int arg_whitelisthome = 0;
-static int arg_noroot = 0;
+static int arg_json = 0;
 static int arg_print_blacklist = 0;
 static int arg_print_whitelist = 0;
-static int arg_restrict_namespaces = 0;
+static int arg_missing[CNT_MAX];	// print profiles without the feature
 
 static char *profile = NULL;
 
@@ -98,39 +142,179 @@ static const char *const usage_str =
 	"   --whitelist-var - print profiles without \"include whitelist-var-common.inc\"\n"
 	"   --whitelist-runuser - print profiles without \"include whitelist-runuser-common.inc\" or \"blacklist ${RUNUSER}\"\n"
 	"   --whitelist-usrshare - print profiles without \"include whitelist-usr-share-common.inc\"\n"
+	"   --json - print profiles without the selected features and the stats in JSON format\n"
 	"   --debug\n";
 
 static void usage(void) {
 	puts(usage_str);
 }
 
-static void process_file(char *fname) {
-	assert(fname);
-	char *tmpfname = NULL;
+// messages for profiles without a feature, in the order they are printed
+static const struct {
+	Counter id;
+	const char *msg;
+} missing_msg[] = {
+	{ CNT_DBUS_SYSTEM_NONE, "No dbus-system none found in %s\n" },
+	{ CNT_DBUS_USER_NONE, "No dbus-user none found in %s\n" },
+	{ CNT_APPARMOR, "No apparmor found in %s\n" },
+	{ CNT_CAPS, "No caps found in %s\n" },
+	{ CNT_SECCOMP, "No seccomp found in %s\n" },
+	{ CNT_RESTRICT_NAMESPACES, "No restrict-namespaces found in %s\n" },
+	{ CNT_NOEXEC, "No include disable-exec.inc found in %s\n" },
+	{ CNT_NOROOT, "No noroot found in %s\n" },
+	{ CNT_PRIVATEDEV, "No private-dev found in %s\n" },
+	{ CNT_PRIVATEBIN, "No private-bin found in %s\n" },
+	{ CNT_PRIVATETMP, "No private-tmp found in %s\n" },
+	{ CNT_PRIVATEETC, "No private-etc found in %s\n" },
+	{ CNT_PRIVATELIB, "No private-lib found in %s\n" },
+	{ CNT_WHITELISTHOME, "Home directory not whitelisted in %s\n" },
+	{ CNT_WHITELISTVAR, "No include whitelist-var-common.inc found in %s\n" },
+	{ CNT_WHITELISTRUNUSER, "No include whitelist-runuser-common.inc found in %s\n" },
+	{ CNT_WHITELISTUSRSHARE, "No include whitelist-usr-share-common.inc found in %s\n" },
+	{ CNT_SSH, "No include disable-common.inc found in %s\n" },
+	{ CNT_MDWX, "No memory-deny-write-execute found in %s\n" },
+};
 
-	if (arg_debug)
-		printf("processing #%s#\n", fname);
-	level++;
-	assert(level < 32); // to do - check in firejail code
+// counters capped to one per profile, no matter how many times they show up in the include tree
+static const Counter once_per_profile[] = {
+	CNT_DOTLOCAL,
+	CNT_GLOBALSDOTLOCAL,
+	CNT_WHITELISTRUNUSER,
+	CNT_SECCOMP,
+	CNT_RESTRICT_NAMESPACES,
+	CNT_DBUS_USER_NONE,
+	CNT_DBUS_USER_FILTER,
+	CNT_DBUS_SYSTEM_NONE,
+	CNT_DBUS_SYSTEM_FILTER,
+};
+
+static unsigned hash(const char *str) {
+	unsigned h = 5381;
+	int c;
+	while ((c = *str++) != 0)
+		h = ((h << 5) + h) ^ c; // hash * 33 ^ c
+	return h % HASH_SIZE;
+}
+
+static void add_event(PFile *f, char *line, PFile *include) {
+	Event *e = calloc(1, sizeof(Event));
+	if (!e)
+		errExit("calloc");
+	if (line) {
+		e->line = strdup(line);
+		if (!e->line)
+			errExit("strdup");
+	}
+	e->include = include;
+
+	if (f->last_event)
+		f->last_event->next = e;
+	else
+		f->events = e;
+	f->last_event = e;
+}
 
-	FILE *fp = fopen(fname, "r");
-	if (!fp) {
+// returns 0 if the line was not matched by any counter other than seccomp
+static int count_line(PFile *f, const char *ptr) {
+	int *c = f->total;
+
+	if (strncmp(ptr, "seccomp", 7) == 0)
+		c[CNT_SECCOMP]++;
+	if (strncmp(ptr, "restrict-namespaces", 19) == 0)
+		c[CNT_RESTRICT_NAMESPACES]++;
+	else if (strncmp(ptr, "caps", 4) == 0)
+		c[CNT_CAPS]++;
+	else if (strncmp(ptr, "include disable-exec.inc", 24) == 0)
+		c[CNT_NOEXEC]++;
+	else if (strncmp(ptr, "noroot", 6) == 0)
+		c[CNT_NOROOT]++;
+	else if (strncmp(ptr, "include whitelist-var-common.inc", 32) == 0)
+		c[CNT_WHITELISTVAR]++;
+	else if (strncmp(ptr, "include whitelist-runuser-common.inc", 36) == 0 ||
+		strncmp(ptr, "blacklist ${RUNUSER}", 20) == 0)
+		c[CNT_WHITELISTRUNUSER]++;
+	else if (strncmp(ptr, "include whitelist-common.inc", 28) == 0)
+		c[CNT_WHITELISTHOME]++;
+	else if (strncmp(ptr, "include whitelist-usr-share-common.inc", 38) == 0)
+		c[CNT_WHITELISTUSRSHARE]++;
+	else if (strncmp(ptr, "include disable-common.inc", 26) == 0)
+		c[CNT_SSH]++;
+	else if (strncmp(ptr, "memory-deny-write-execute", 25) == 0)
+		c[CNT_MDWX]++;
+	else if (strncmp(ptr, "net none", 8) == 0)
+		c[CNT_NETNONE]++;
+	else if (strncmp(ptr, "apparmor", 8) == 0)
+		c[CNT_APPARMOR]++;
+	else if (strncmp(ptr, "private-bin", 11) == 0)
+		c[CNT_PRIVATEBIN]++;
+	else if (strncmp(ptr, "private-dev", 11) == 0)
+		c[CNT_PRIVATEDEV]++;
+	else if (strncmp(ptr, "private-tmp", 11) == 0)
+		c[CNT_PRIVATETMP]++;
+	else if (strncmp(ptr, "private-etc", 11) == 0)
+		c[CNT_PRIVATEETC]++;
+	else if (strncmp(ptr, "private-lib", 11) == 0)
+		c[CNT_PRIVATELIB]++;
+	else if (strncmp(ptr, "dbus-system none", 16) == 0)
+		c[CNT_DBUS_SYSTEM_NONE]++;
+	else if (strncmp(ptr, "dbus-system", 11) == 0)
+		c[CNT_DBUS_SYSTEM_FILTER]++;
+	else if (strncmp(ptr, "dbus-user none", 14) == 0)
+		c[CNT_DBUS_USER_NONE]++;
+	else if (strncmp(ptr, "dbus-user", 9) == 0)
+		c[CNT_DBUS_USER_FILTER]++;
+	else
+		return 0;
+	return 1;
+}
+
+// find the file in the cache, or parse it and add it to the cache
+static PFile *get_file(const char *name) {
+	assert(name);
+	unsigned h = hash(name);
+	PFile *f = htable[h];
+	while (f) {
+		if (strcmp(f->name, name) == 0) {
+			if (f->parsing) {
+				fprintf(stderr, "Error: include loop detected in %s\n", f->path);
+				exit(1);
+			}
+			return f;
+		}
+		f = f->next;
+	}
+
+	f = calloc(1, sizeof(PFile));
+	if (!f)
+		errExit("calloc");
+	f->name = strdup(name);
+	if (!f->name)
+		errExit("strdup");
+	f->next = htable[h];
+	htable[h] = f;
+
+	FILE *fp = fopen(name, "r");
+	if (fp) {
+		f->path = f->name;
+	}
+	else {
 		// the file was not found in the current directory
 		// look for it in /etc/firejail directory
-		if (asprintf(&tmpfname, "%s/%s", SYSCONFDIR, fname) == -1)
+		if (asprintf(&f->path, "%s/%s", SYSCONFDIR, name) == -1)
 			errExit("asprintf");
 
-		fp = fopen(tmpfname, "r");
-		if (!fp) {
-			fprintf(stderr, "Warning: cannot open %s or %s, while processing %s\n", fname, tmpfname, profile);
-			free(tmpfname);
-			level--;
-			return;
-		}
-		fname = tmpfname;
+		fp = fopen(f->path, "r");
+		if (!fp)
+			return f;
+	}
+	f->found = 1;
+	f->parsing = 1;
+	level++;
+	if (level >= MAX_LEVEL) {
+		fprintf(stderr, "Error: too many include levels in %s\n", f->path);
+		exit(1);
 	}
 
-	int have_include_local = 0;
 	char buf[MAXBUF];
 	while (fgets(buf, MAXBUF, fp)) {
 		char *ptr = strchr(buf, '\n');
@@ -146,69 +330,23 @@ static void process_file(char *fname) {
 		if (arg_print_blacklist) {
 			if (strncmp(ptr, "blacklist", 9) == 0 ||
 			    strncmp(ptr, "noblacklist", 11) == 0)
-				printf("%s: %s\n", fname, ptr);
+				add_event(f, ptr, NULL);
 		}
 		else if (arg_print_whitelist) {
 			if (strncmp(ptr, "whitelist", 9) == 0 ||
 			    strncmp(ptr, "nowhitelist", 11) == 0 ||
 			    strncmp(ptr, "private", 7) == 0)
-				printf("%s: %s\n", fname, ptr);
+				add_event(f, ptr, NULL);
 		}
 
-		if (strncmp(ptr, "seccomp", 7) == 0)
-			cnt_seccomp++;
-		if (strncmp(ptr, "restrict-namespaces", 19) == 0)
-			cnt_restrict_namespaces++;
-		else if (strncmp(ptr, "caps", 4) == 0)
-			cnt_caps++;
-		else if (strncmp(ptr, "include disable-exec.inc", 24) == 0)
-			cnt_noexec++;
-		else if (strncmp(ptr, "noroot", 6) == 0)
-			cnt_noroot++;
-		else if (strncmp(ptr, "include whitelist-var-common.inc", 32) == 0)
-			cnt_whitelistvar++;
-		else if (strncmp(ptr, "include whitelist-runuser-common.inc", 36) == 0 ||
-			strncmp(ptr, "blacklist ${RUNUSER}", 20) == 0)
-			cnt_whitelistrunuser++;
-		else if (strncmp(ptr, "include whitelist-common.inc", 28) == 0)
-			cnt_whitelisthome++;
-		else if (strncmp(ptr, "include whitelist-usr-share-common.inc", 38) == 0)
-			cnt_whitelistusrshare++;
-		else if (strncmp(ptr, "include disable-common.inc", 26) == 0)
-			cnt_ssh++;
-		else if (strncmp(ptr, "memory-deny-write-execute", 25) == 0)
-			cnt_mdwx++;
-		else if (strncmp(ptr, "net none", 8) == 0)
-			cnt_netnone++;
-		else if (strncmp(ptr, "apparmor", 8) == 0)
-			cnt_apparmor++;
-		else if (strncmp(ptr, "private-bin", 11) == 0)
-			cnt_privatebin++;
-		else if (strncmp(ptr, "private-dev", 11) == 0)
-			cnt_privatedev++;
-		else if (strncmp(ptr, "private-tmp", 11) == 0)
-			cnt_privatetmp++;
-		else if (strncmp(ptr, "private-etc", 11) == 0)
-			cnt_privateetc++;
-		else if (strncmp(ptr, "private-lib", 11) == 0)
-			cnt_privatelib++;
-		else if (strncmp(ptr, "dbus-system none", 16) == 0)
-			cnt_dbus_system_none++;
-		else if (strncmp(ptr, "dbus-system", 11) == 0)
-			cnt_dbus_system_filter++;
-		else if (strncmp(ptr, "dbus-user none", 14) == 0)
-			cnt_dbus_user_none++;
-		else if (strncmp(ptr, "dbus-user", 9) == 0)
-			cnt_dbus_user_filter++;
-		else if (strncmp(ptr, "include ", 8) == 0) {
+		if (count_line(f, ptr) == 0 && strncmp(ptr, "include ", 8) == 0) {
 			// not processing .local files
 			if (strstr(ptr, ".local")) {
-				have_include_local = 1;
-//printf("dotlocal %d, level %d - #%s#, redirect #%s#\n", cnt_dotlocal, level, fname, buf + 8);
+				f->have_include_local = 1;
 				if (strstr(ptr, "globals.local"))
-					cnt_globalsdotlocal++;
+					f->total[CNT_GLOBALSDOTLOCAL]++;
 				else
-					cnt_dotlocal++;
+					f->total[CNT_DOTLOCAL]++;
 				continue;
 			}
 			// clean blanks
@@ -216,16 +354,59 @@ static void process_file(char *fname) {
 			while (*ptr != '\0' && *ptr != ' ' && *ptr != '\t')
 				ptr++;
 			*ptr = '\0';
-			process_file(buf + 8);
+			PFile *inc = get_file(buf + 8);
+			int i;
+			for (i = 0; i < CNT_MAX; i++)
+				f->total[i] += inc->total[i];
+			add_event(f, NULL, inc);
 		}
 	}
 
 	fclose(fp);
-	if (!have_include_local)
-		printf("No include .local found in %s\n", fname);
+	f->parsing = 0;
+	level--;
+	return f;
+}
+
+// print the messages generated by a file and its include tree
+static void print_file(PFile *f) {
+	if (arg_debug)
+		printf("processing #%s#\n", f->name);
+	level++;
+	assert(level < MAX_LEVEL);
+
+	if (!f->found) {
+		fprintf(stderr, "Warning: cannot open %s or %s, while processing %s\n", f->name, f->path, profile);
+		level--;
+		return;
+	}
+
+	Event *e = f->events;
+	while (e) {
+		if (e->include)
+			print_file(e->include);
+		else
+			printf("%s: %s\n", f->path, e->line);
+		e = e->next;
+	}
+
+	if (!f->have_include_local && !arg_json)
+		printf("No include .local found in %s\n", f->path);
 	level--;
-	if (tmpfname)
-		free(tmpfname);
+}
+
+static void print_json_string(const char *str) {
+	putchar('"');
+	for (; *str; str++) {
+		unsigned char c = (unsigned char) *str;
+		if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < 0x20)
+			printf("\\u%04x", c);
+		else
+			putchar(c);
+	}
+	putchar('"');
 }
 
 int main(int argc, char **argv) {
@@ -243,46 +424,48 @@ int main(int argc, char **argv) {
 		}
 		else if (strcmp(argv[i], "--debug") == 0)
 			arg_debug = 1;
+		else if (strcmp(argv[i], "--json") == 0)
+			arg_json = 1;
 		else if (strcmp(argv[i], "--apparmor") == 0)
-			arg_apparmor = 1;
+			arg_missing[CNT_APPARMOR] = 1;
 		else if (strcmp(argv[i], "--caps") == 0)
-			arg_caps = 1;
+			arg_missing[CNT_CAPS] = 1;
 		else if (strcmp(argv[i], "--seccomp") == 0)
-			arg_seccomp = 1;
+			arg_missing[CNT_SECCOMP] = 1;
 		else if (strcmp(argv[i], "--restrict-namespaces") == 0)
-			arg_restrict_namespaces = 1;
+			arg_missing[CNT_RESTRICT_NAMESPACES] = 1;
 		else if (strcmp(argv[i], "--memory-deny-write-execute") == 0)
-			arg_mdwx = 1;
+			arg_missing[CNT_MDWX] = 1;
 		else if (strcmp(argv[i], "--noexec") == 0)
-			arg_noexec = 1;
+			arg_missing[CNT_NOEXEC] = 1;
 		else if (strcmp(argv[i], "--noroot") == 0)
-			arg_noroot = 1;
+			arg_missing[CNT_NOROOT] = 1;
 		else if (strcmp(argv[i], "--private-bin") == 0)
-			arg_privatebin = 1;
+			arg_missing[CNT_PRIVATEBIN] = 1;
 		else if (strcmp(argv[i], "--private-dev") == 0)
-			arg_privatedev = 1;
+			arg_missing[CNT_PRIVATEDEV] = 1;
 		else if (strcmp(argv[i], "--private-tmp") == 0)
-			arg_privatetmp = 1;
+			arg_missing[CNT_PRIVATETMP] = 1;
 		else if (strcmp(argv[i], "--private-etc") == 0)
-			arg_privateetc = 1;
+			arg_missing[CNT_PRIVATEETC] = 1;
 		else if (strcmp(argv[i], "--print-blacklist") == 0)
 			arg_print_blacklist = 1;
 		else if (strcmp(argv[i], "--print-whitelist") == 0)
 			arg_print_whitelist = 1;
 		else if (strcmp(argv[i], "--whitelist-home") == 0)
-			arg_whitelisthome = 1;
+			arg_missing[CNT_WHITELISTHOME] = 1;
 		else if (strcmp(argv[i], "--whitelist-var") == 0)
-			arg_whitelistvar = 1;
+			arg_missing[CNT_WHITELISTVAR] = 1;
 		else if (strcmp(argv[i], "--whitelist-runuser") == 0)
-			arg_whitelistrunuser = 1;
+			arg_missing[CNT_WHITELISTRUNUSER] = 1;
 		else if (strcmp(argv[i], "--whitelist-usrshare") == 0)
-			arg_whitelistusrshare = 1;
+			arg_missing[CNT_WHITELISTUSRSHARE] = 1;
 		else if (strcmp(argv[i], "--ssh") == 0)
-			arg_ssh = 1;
+			arg_missing[CNT_SSH] = 1;
 		else if (strcmp(argv[i], "--dbus-system-none") == 0)
-			arg_dbus_system_none = 1;
+			arg_missing[CNT_DBUS_SYSTEM_NONE] = 1;
 		else if (strcmp(argv[i], "--dbus-user-none") == 0)
-			arg_dbus_user_none = 1;
+			arg_missing[CNT_DBUS_USER_NONE] = 1;
 		else if (*argv[i] == '-') {
 			fprintf(stderr, "Error: invalid option %s\n", argv[i]);
 			return 1;
@@ -296,137 +479,105 @@ int main(int argc, char **argv) {
 		fprintf(stderr, "Error: no profile file specified\n");
 		return 1;
 	}
+	if (arg_json && (arg_print_blacklist || arg_print_whitelist)) {
+		fprintf(stderr, "Error: --json cannot be combined with --print-blacklist or --print-whitelist\n");
+		return 1;
+	}
 
+	if (arg_json)
+		printf("{\n  \"profiles\": [");
 	for (i = start; i < argc; i++) {
 		cnt_profiles++;
 
-		int restrict_namespaces = cnt_restrict_namespaces;
-		int seccomp = cnt_seccomp;
-		int caps = cnt_caps;
-		int apparmor = cnt_apparmor;
-		int noexec = cnt_noexec;
-		int noroot = cnt_noroot;
-		int privatebin = cnt_privatebin;
-		int privatetmp = cnt_privatetmp;
-		int privatedev = cnt_privatedev;
-		int privateetc = cnt_privateetc;
-		int privatelib = cnt_privatelib;
-		int dotlocal = cnt_dotlocal;
-		int globalsdotlocal = cnt_globalsdotlocal;
-		int whitelisthome = cnt_whitelisthome;
-		int whitelistvar = cnt_whitelistvar;
-		int whitelistrunuser = cnt_whitelistrunuser;
-		int whitelistusrshare = cnt_whitelistusrshare;
-		int dbussystemnone = cnt_dbus_system_none;
-		int dbussystemfilter = cnt_dbus_system_filter;
-		int dbususernone = cnt_dbus_user_none;
-		int dbususerfilter = cnt_dbus_user_filter;
-		int ssh = cnt_ssh;
-		int mdwx = cnt_mdwx;
-
 		// process file
 		profile = argv[i];
-		process_file(argv[i]);
+		PFile *f = get_file(argv[i]);
+		print_file(f);
+
+		int delta[CNT_MAX];
+		memcpy(delta, f->total, sizeof(delta));
 
 		// warnings
-		if ((caps + 2) <= cnt_caps) {
-			printf("Warning: multiple caps in %s\n", argv[i]);
-			cnt_caps = caps + 1;
+		if (delta[CNT_CAPS] >= 2) {
+			if (!arg_json)
+				printf("Warning: multiple caps in %s\n", argv[i]);
+			delta[CNT_CAPS] = 1;
 		}
 
 		// fix redirections
-		if (cnt_dotlocal > (dotlocal + 1))
-			cnt_dotlocal = dotlocal + 1;
-		if (cnt_globalsdotlocal > (globalsdotlocal + 1))
-			cnt_globalsdotlocal = globalsdotlocal + 1;
-		if (cnt_whitelistrunuser > (whitelistrunuser + 1))
-			cnt_whitelistrunuser = whitelistrunuser + 1;
-		if (cnt_seccomp > (seccomp + 1))
-			cnt_seccomp = seccomp + 1;
-		if (cnt_restrict_namespaces > (restrict_namespaces + 1))
-			cnt_seccomp = restrict_namespaces + 1;
-		if (cnt_dbus_user_none > (dbususernone + 1))
-			cnt_dbus_user_none = dbususernone + 1;
-		if (cnt_dbus_user_filter > (dbususerfilter + 1))
-			cnt_dbus_user_filter = dbususerfilter + 1;
-		if (cnt_dbus_system_none > (dbussystemnone + 1))
-			cnt_dbus_system_none = dbussystemnone + 1;
-		if (cnt_dbus_system_filter > (dbussystemfilter + 1))
-			cnt_dbus_system_filter = dbussystemfilter + 1;
-
-		if (arg_dbus_system_none && dbussystemnone == cnt_dbus_system_none)
-			printf("No dbus-system none found in %s\n", argv[i]);
-		if (arg_dbus_user_none && dbususernone == cnt_dbus_user_none)
-			printf("No dbus-user none found in %s\n", argv[i]);
-		if (arg_apparmor && apparmor == cnt_apparmor)
-			printf("No apparmor found in %s\n", argv[i]);
-		if (arg_caps && caps == cnt_caps)
-			printf("No caps found in %s\n", argv[i]);
-		if (arg_seccomp && seccomp == cnt_seccomp)
-			printf("No seccomp found in %s\n", argv[i]);
-		if (arg_restrict_namespaces && restrict_namespaces == cnt_restrict_namespaces)
-			printf("No restrict-namespaces found in %s\n", argv[i]);
-		if (arg_noexec && noexec == cnt_noexec)
-			printf("No include disable-exec.inc found in %s\n", argv[i]);
-		if (arg_noroot && noroot == cnt_noroot)
-			printf("No noroot found in %s\n", argv[i]);
-		if (arg_privatedev && privatedev == cnt_privatedev)
-			printf("No private-dev found in %s\n", argv[i]);
-		if (arg_privatebin && privatebin == cnt_privatebin)
-			printf("No private-bin found in %s\n", argv[i]);
-		if (arg_privatetmp && privatetmp == cnt_privatetmp)
-			printf("No private-tmp found in %s\n", argv[i]);
-		if (arg_privateetc && privateetc == cnt_privateetc)
-			printf("No private-etc found in %s\n", argv[i]);
-		if (arg_privatelib && privatelib == cnt_privatelib)
-			printf("No private-lib found in %s\n", argv[i]);
-		if (arg_whitelisthome && whitelisthome == cnt_whitelisthome)
-			printf("Home directory not whitelisted in %s\n", argv[i]);
-		if (arg_whitelistvar && whitelistvar == cnt_whitelistvar)
-			printf("No include whitelist-var-common.inc found in %s\n", argv[i]);
-		if (arg_whitelistrunuser && whitelistrunuser == cnt_whitelistrunuser)
-			printf("No include whitelist-runuser-common.inc found in %s\n", argv[i]);
-		if (arg_whitelistusrshare && whitelistusrshare == cnt_whitelistusrshare)
-			printf("No include whitelist-usr-share-common.inc found in %s\n", argv[i]);
-		if (arg_ssh && ssh == cnt_ssh)
-			printf("No include disable-common.inc found in %s\n", argv[i]);
-		if (arg_mdwx && mdwx == cnt_mdwx)
-			printf("No memory-deny-write-execute found in %s\n", argv[i]);
+		size_t j;
+		for (j = 0; j < ARRAY_SIZE(once_per_profile); j++) {
+			if (delta[once_per_profile[j]] > 1)
+				delta[once_per_profile[j]] = 1;
+		}
+
+		if (arg_json) {
+			printf("%s\n    { \"name\": ", (i == start) ? "" : ",");
+			print_json_string(argv[i]);
+			printf(", \"missing\": [");
+			int first = 1;
+			for (j = 0; j < ARRAY_SIZE(missing_msg); j++) {
+				Counter id = missing_msg[j].id;
+				if (arg_missing[id] && delta[id] == 0) {
+					printf("%s\"%s\"", first ? "" : ", ", cnt_name[id]);
+					first = 0;
+				}
+			}
+			printf("], \"include-local\": %s }", f->have_include_local ? "true" : "false");
+		}
+		else {
+			for (j = 0; j < ARRAY_SIZE(missing_msg); j++) {
+				if (arg_missing[missing_msg[j].id] && delta[missing_msg[j].id] == 0)
+					printf(missing_msg[j].msg, argv[i]);
+			}
+		}
+
+		int k;
+		for (k = 0; k < CNT_MAX; k++)
+			cnt[k] += delta[k];
 
 		assert(level == 0);
 	}
 
+	if (arg_json) {
+		printf("\n  ],\n  \"stats\": {\n    \"profiles\": %d", cnt_profiles);
+		for (i = 0; i < CNT_MAX; i++)
+			printf(",\n    \"%s\": %d", cnt_name[i], cnt[i]);
+		printf("\n  }\n}\n");
+		return 0;
+	}
+
 	if (arg_print_blacklist || arg_print_whitelist)
 		return 0;
 
 	printf("\n");
 	printf("Stats:\n");
 	printf("    profiles\t\t\t%d\n", cnt_profiles);
-	printf("    include local profile\t%d   (include profile-name.local)\n", cnt_dotlocal);
-	printf("    include globals\t\t%d   (include globals.local)\n", cnt_globalsdotlocal);
-	printf("    blacklist ~/.ssh\t\t%d   (include disable-common.inc)\n", cnt_ssh);
-	printf("    seccomp\t\t\t%d\n", cnt_seccomp);
-	printf("    capabilities\t\t%d\n", cnt_caps);
-	printf("    noexec\t\t\t%d   (include disable-exec.inc)\n", cnt_noexec);
-	printf("    noroot\t\t\t%d\n", cnt_noroot);
-	printf("    memory-deny-write-execute\t%d\n", cnt_mdwx);
-	printf("    restrict-namespaces\t\t%d\n", cnt_restrict_namespaces);
-	printf("    apparmor\t\t\t%d\n", cnt_apparmor);
-	printf("    private-bin\t\t\t%d\n", cnt_privatebin);
-	printf("    private-dev\t\t\t%d\n", cnt_privatedev);
-	printf("    private-etc\t\t\t%d\n", cnt_privateetc);
-	printf("    private-lib\t\t\t%d\n", cnt_privatelib);
-	printf("    private-tmp\t\t\t%d\n", cnt_privatetmp);
-	printf("    whitelist home directory\t%d\n", cnt_whitelisthome);
-	printf("    whitelist var\t\t%d   (include whitelist-var-common.inc)\n", cnt_whitelistvar);
-	printf("    whitelist run/user\t\t%d   (include whitelist-runuser-common.inc\n", cnt_whitelistrunuser);
+	printf("    include local profile\t%d   (include profile-name.local)\n", cnt[CNT_DOTLOCAL]);
+	printf("    include globals\t\t%d   (include globals.local)\n", cnt[CNT_GLOBALSDOTLOCAL]);
+	printf("    blacklist ~/.ssh\t\t%d   (include disable-common.inc)\n", cnt[CNT_SSH]);
+	printf("    seccomp\t\t\t%d\n", cnt[CNT_SECCOMP]);
+	printf("    capabilities\t\t%d\n", cnt[CNT_CAPS]);
+	printf("    noexec\t\t\t%d   (include disable-exec.inc)\n", cnt[CNT_NOEXEC]);
+	printf("    noroot\t\t\t%d\n", cnt[CNT_NOROOT]);
+	printf("    memory-deny-write-execute\t%d\n", cnt[CNT_MDWX]);
+	printf("    restrict-namespaces\t\t%d\n", cnt[CNT_RESTRICT_NAMESPACES]);
+	printf("    apparmor\t\t\t%d\n", cnt[CNT_APPARMOR]);
+	printf("    private-bin\t\t\t%d\n", cnt[CNT_PRIVATEBIN]);
+	printf("    private-dev\t\t\t%d\n", cnt[CNT_PRIVATEDEV]);
+	printf("    private-etc\t\t\t%d\n", cnt[CNT_PRIVATEETC]);
+	printf("    private-lib\t\t\t%d\n", cnt[CNT_PRIVATELIB]);
+	printf("    private-tmp\t\t\t%d\n", cnt[CNT_PRIVATETMP]);
+	printf("    whitelist home directory\t%d\n", cnt[CNT_WHITELISTHOME]);
+	printf("    whitelist var\t\t%d   (include whitelist-var-common.inc)\n", cnt[CNT_WHITELISTVAR]);
+	printf("    whitelist run/user\t\t%d   (include whitelist-runuser-common.inc\n", cnt[CNT_WHITELISTRUNUSER]);
 	printf("\t\t\t\t\tor blacklist ${RUNUSER})\n");
-	printf("    whitelist usr/share\t\t%d   (include whitelist-usr-share-common.inc\n", cnt_whitelistusrshare);
-	printf("    net none\t\t\t%d\n", cnt_netnone);
-	printf("    dbus-user none \t\t%d\n", cnt_dbus_user_none);
-	printf("    dbus-user filter \t\t%d\n", cnt_dbus_user_filter);
-	printf("    dbus-system none \t\t%d\n", cnt_dbus_system_none);
-	printf("    dbus-system filter \t\t%d\n", cnt_dbus_system_filter);
+	printf("    whitelist usr/share\t\t%d   (include whitelist-usr-share-common.inc\n", cnt[CNT_WHITELISTUSRSHARE]);
+	printf("    net none\t\t\t%d\n", cnt[CNT_NETNONE]);
+	printf("    dbus-user none \t\t%d\n", cnt[CNT_DBUS_USER_NONE]);
+	printf("    dbus-user filter \t\t%d\n", cnt[CNT_DBUS_USER_FILTER]);
+	printf("    dbus-system none \t\t%d\n", cnt[CNT_DBUS_SYSTEM_NONE]);
+	printf("    dbus-system filter \t\t%d\n", cnt[CNT_DBUS_SYSTEM_FILTER]);
 	printf("\n");
 	return 0;
 }
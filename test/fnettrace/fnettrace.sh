@@ -0,0 +1,18 @@
+#!/bin/bash
+# This file is part of Firejail project
+# Copyright (C) 2014-2024 Firejail Authors
+# License GPL v2
+
+export MALLOC_CHECK_=3
+export MALLOC_PERTURB_=$(($RANDOM % 255 + 1))
+export LC_ALL=C
+
+if [[ -f /etc/debian_version ]]; then
+	libdir=$(dirname "$(dpkg -L firejail | grep fcopy)")
+	export PATH="$PATH:$libdir"
+fi
+
+export PATH="$PATH:/usr/lib/firejail:/usr/lib64/firejail:/usr/local/lib/firejail"
+
+echo "TESTING: fnettrace pcap (test/fnettrace/pcap.exp)"
+./pcap.exp
@@ -83,6 +83,18 @@ rm -f ~/_firejail_test_link2
 echo "TESTING: private-bin (test/fs/private-bin.exp)"
 ./private-bin.exp
 
+echo "TESTING: overlay-tmpfs (test/fs/overlay-tmpfs.exp)"
+./overlay-tmpfs.exp
+
+echo "TESTING: overlay root (test/fs/overlay-root.exp)"
+sudo ./overlay-root.exp
+
+echo "TESTING: overlay nosuid (test/fs/overlay-nosuid.exp)"
+sudo ./overlay-nosuid.exp
+
+echo "TESTING: tmpfs-options (test/fs/tmpfs-options.exp)"
+./tmpfs-options.exp
+
 echo "TESTING: private-cache (test/fs/private-cache.exp)"
 ./private-cache.exp
 rm -f ~/.cache/abcdefg
@@ -154,6 +166,12 @@ echo "TESTING: fscheck --tmpfs non root (test/fs/fscheck-tmpfs.exp)"
 rm -fr ~/_firejail_test_dir
 rm -fr /tmp/_firejail_test_dir
 
+echo "TESTING: restrict-users cache (test/fs/restrict-users.exp)"
+./restrict-users.exp
+
+echo "TESTING: proc-subset (test/fs/proc-subset.exp)"
+./proc-subset.exp
+
 echo "TESTING: fscheck --private= (test/fs/fscheck-private.exp)"
 ./fscheck-private.exp
 
@@ -21,3 +21,10 @@ echo "TESTING: etc-cleanup (test/private-etc/etc-cleanup.exp)"
 
 echo "TESTING: hostname (test/private-etc/hostname.exp)"
 ./hostname.exp
+
+fjconfig=/etc/firejail/firejail.config
+printf 'fs-template yes\n' | sudo tee -a "$fjconfig" >/dev/null
+echo "TESTING: fs-template (test/private-etc/fs-template.exp)"
+./fs-template.exp
+printf '%s\n' "$(sed '/^fs-template yes$/d' "$fjconfig")" |
+	sudo tee "$fjconfig" >/dev/null
@@ -24,6 +24,8 @@ if [[ $(uname -m) == "x86_64" ]]; then
 	printf 'private-lib yes\n' | sudo tee -a "$fjconfig" >/dev/null
 	echo "TESTING: private-lib (test/fs/private-lib.exp)"
 	./private-lib.exp
+	echo "TESTING: private-lib dry-run (test/private-lib/dry-run.exp)"
+	./dry-run.exp
 	printf '%s\n' "$(sed '/^private-lib yes$/d' "$fjconfig")" |
 		sudo tee "$fjconfig" >/dev/null
 else
@@ -30,6 +30,9 @@ echo "TESTING: profile.print (test/utils/profile_print.exp)"
 echo "TESTING: version (test/utils/version.exp)"
 ./version.exp
 
+echo "TESTING: dry-run (test/utils/dry-run.exp)"
+./dry-run.exp
+
 echo "TESTING: help (test/utils/help.exp)"
 ./help.exp
 
@@ -79,6 +82,18 @@ echo "TESTING: shutdown4 (test/utils/shutdown4.exp)"
 echo "TESTING: join (test/utils/join.exp)"
 ./join.exp
 
+echo "TESTING: join-agent (test/utils/join-agent.exp)"
+./join-agent.exp
+
+echo "TESTING: pool (test/utils/pool.exp)"
+./pool.exp
+
+echo "TESTING: batch (test/utils/batch.exp)"
+./batch.exp
+
+echo "TESTING: prefetch (test/utils/prefetch.exp)"
+./prefetch.exp
+
 echo "TESTING: join4 (test/utils/join4.exp)"
 ./join4.exp
 
@@ -93,6 +108,9 @@ rm -f index.html*
 ./trace.exp
 rm -f index.html*
 
+echo "TESTING: trace-fanotify (test/utils/trace-fanotify.exp)"
+./trace-fanotify.exp
+
 echo "TESTING: top (test/utils/top.exp)"
 ./top.exp
 
@@ -109,6 +127,13 @@ fi
 echo "TESTING: firemon cpu (test/utils/firemon-cpu.exp)"
 ./firemon-cpu.exp
 
+if grep -q "^Seccomp.*0" /proc/self/status; then
+	echo "TESTING: firemon report (test/utils/firemon-report.exp)"
+	./firemon-report.exp
+else
+	echo "TESTING SKIP: seccomp already active (test/utils/firemon-report.exp)"
+fi
+
 echo "TESTING: firemon version (test/utils/firemon-version.exp)"
 ./firemon-version.exp
 